@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "train.h"
+
+/*
+ * 按相同的合成需求分别回放首个适配 / 最佳适配两种分配策略：
+ * 21 站（20 段）、二等座 1000 座；需求以短途为主，四分之一为 10 段以上的长途。
+ *   fill  阶段只订不退，直到连续 2000 次分配失败，此时的座位段售出率即可售容量；
+ *   churn 阶段约 40% 的请求为随机退票，观察稳态下的分配耗时与长途成功率。
+ */
+
+#define STOPS 21
+#define SEATS 1000
+#define REQUESTS 200000
+
+typedef struct { int seat, from, to; } Sold;
+
+static unsigned long long rng_state;
+static unsigned rng(void) {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(rng_state >> 33);
+}
+
+static void run(TrainList *TL, int policy, const char *date, const char *label, int churn) {
+    static Sold sold[REQUESTS];
+    int nsold = 0;
+    long ok = 0, fail = 0, long_ok = 0, long_req = 0, seg_sold = 0;
+    double alloc_sec = 0;
+    char from[16], to[16];
+
+    train_set_alloc_policy(policy);
+    rng_state = 12345;
+    int streak = 0;
+    for (int i = 0; i < REQUESTS; ++i) {
+        if (!churn && streak >= 2000) break;
+        if (churn && nsold > 0 && rng() % 10 < 4) {
+            int k = rng() % nsold;
+            train_release_seat(TL, "B1", date, 2, sold[k].seat, sold[k].from, sold[k].to);
+            seg_sold -= sold[k].to - sold[k].from;
+            sold[k] = sold[--nsold];
+            continue;
+        }
+        int len = (rng() % 4 == 0) ? 10 + rng() % 11 : 1 + rng() % 4;
+        int f = rng() % (STOPS - len);
+        int t = f + len;
+        snprintf(from, sizeof(from), "S%d", f);
+        snprintf(to, sizeof(to), "S%d", t);
+        if (len >= 10) long_req++;
+
+        int seat, fi, ti;
+        clock_t c0 = clock();
+        int r = train_allocate_seat(TL, "B1", date, from, to, 2, &seat, &fi, &ti);
+        alloc_sec += (double)(clock() - c0) / CLOCKS_PER_SEC;
+        if (r == 0) {
+            ok++;
+            if (len >= 10) long_ok++;
+            seg_sold += len;
+            sold[nsold].seat = seat; sold[nsold].from = fi; sold[nsold].to = ti;
+            nsold++;
+            streak = 0;
+        } else {
+            fail++;
+            streak++;
+        }
+    }
+    printf("%-5s %-10s alloc %8.1f ns/op  sold %7ld  rejected %7ld  long-distance %6ld/%ld  load %.1f%%\n",
+           churn ? "churn" : "fill", label, alloc_sec * 1e9 / (ok + fail), ok, fail, long_ok, long_req,
+           100.0 * seg_sold / ((double)SEATS * (STOPS - 1)));
+}
+
+int main(void) {
+    TrainList TL;
+    trainlist_init(&TL);
+
+    Train t;
+    memset(&t, 0, sizeof(t));
+    snprintf(t.train_id, ID_LEN, "%s", "B1");
+    t.stop_count = STOPS;
+    t.stops = calloc(STOPS, sizeof(Stop));
+    for (int i = 0; i < STOPS; ++i) snprintf(t.stops[i].name, STATION_LEN, "S%d", i);
+    snprintf(t.from, STATION_LEN, "%s", t.stops[0].name);
+    snprintf(t.to, STATION_LEN, "%s", t.stops[STOPS-1].name);
+    t.seat_count[2] = SEATS;
+    for (int i = 0; i < 4; ++i) t.seat_price_coef[i] = 1.0;
+    train_add(&TL, &t);
+
+    run(&TL, ALLOC_FIRST_FIT, "2026-03-01", "first-fit", 0);
+    run(&TL, ALLOC_BEST_FIT, "2026-03-02", "best-fit", 0);
+    run(&TL, ALLOC_FIRST_FIT, "2026-03-03", "first-fit", 1);
+    run(&TL, ALLOC_BEST_FIT, "2026-03-04", "best-fit", 1);
+
+    trainlist_free(&TL);
+    return 0;
+}
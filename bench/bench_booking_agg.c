@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+
+/*
+ * 订单统计：N 条订单（默认 100 万，T 趟车 × 60 天，T 默认 300）载入后，
+ * 比较列式统计 booking_aggregate 与按行遍历紧凑记录 / 展开的 Booking 数组的耗时。
+ * 车次 × 日期 × 等级的组合数超过订单数时（如 T=5000）走散列分组。
+ */
+
+#define TMP_FILE "bench_bookings_agg.tmp"
+#define ROUNDS 10
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    int trains = argc > 2 ? atoi(argv[2]) : 300;
+    if (n <= 0) n = 1000000;
+    if (trains <= 0) trains = 300;
+
+    FILE *f = fopen(TMP_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 60, a = i % 15;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|%d-%d|%d|%d|%d|%d|%d\n",
+                date, tr, i / (trains * 60) + 1, i % 50000, i % 50000, date, tr, a, a + 3,
+                55.5 + a * 10, i % 4 + 1, i % 600 + 1, i % 4, i % 600, a, a + 3, i % 17 == 0);
+    }
+    fclose(f);
+
+    TrainList TL;
+    BookingList BL;
+    trainlist_init(&TL);
+    bookinglist_init(&BL);
+    int ok = load_bookings(TMP_FILE, &BL, &TL);
+    remove(TMP_FILE);
+    if (!ok) { printf("load failed\n"); return 1; }
+    printf("bookings %d, trains %d\n", BL.size, trains);
+
+    Booking *flat = malloc(sizeof(Booking) * (size_t)BL.size);
+    for (int i = 0; i < BL.size; ++i) booking_get(&BL, i, &flat[i]);
+
+    /* 有效订单票款合计 */
+    BookingAggRow row;
+    long long rec_cents = 0;
+    double wide_sum = 0;
+    double t0 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        booking_aggregate(&BL, 0, BOOKING_AGG_ACTIVE, &row, 1);
+    double t1 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BL.size; ++i) if (!BL.data[i].canceled) rec_cents += BL.data[i].price_cents;
+    double t2 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BL.size; ++i) if (!flat[i].canceled) wide_sum += flat[i].price;
+    double t3 = sync_now();
+    printf("sum      : columns %6.2f ms, BookingRec %6.2f ms, Booking %6.2f ms  (%.2f / %.2f / %.2f)\n",
+           (t1 - t0) * 1e3 / ROUNDS, (t2 - t1) * 1e3 / ROUNDS, (t3 - t2) * 1e3 / ROUNDS,
+           row.revenue_cents / 100.0, rec_cents / 100.0 / ROUNDS, wide_sum / ROUNDS);
+
+    /* 各等级载客量（座·段） */
+    BookingAggRow cls[8];
+    long long rec_seg[4] = {0}, wide_seg[4] = {0};
+    t0 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        booking_aggregate(&BL, BOOKING_BY_CLASS, BOOKING_AGG_ACTIVE, cls, 8);
+    t1 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BL.size; ++i) {
+            const BookingRec *b = &BL.data[i];
+            if (!b->canceled) rec_seg[b->seat_class & 3] += b->to_stop_idx - b->from_stop_idx;
+        }
+    t2 = sync_now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BL.size; ++i)
+            if (!flat[i].canceled) wide_seg[flat[i].seat_class & 3] += flat[i].to_stop_idx - flat[i].from_stop_idx;
+    t3 = sync_now();
+    printf("by class : columns %6.2f ms, BookingRec %6.2f ms, Booking %6.2f ms  (class 0: %lld / %lld / %lld)\n",
+           (t1 - t0) * 1e3 / ROUNDS, (t2 - t1) * 1e3 / ROUNDS, (t3 - t2) * 1e3 / ROUNDS,
+           cls[0].segments, rec_seg[0] / ROUNDS, wide_seg[0] / ROUNDS);
+
+    /* 按车次+日期、车次+日期+等级分组 */
+    int groups = booking_aggregate(&BL, BOOKING_BY_TRAIN | BOOKING_BY_DATE | BOOKING_BY_CLASS, BOOKING_AGG_ALL, NULL, 0);
+    BookingAggRow *rows = malloc(sizeof(BookingAggRow) * (groups > 0 ? groups : 1));
+    int by[2] = { BOOKING_BY_TRAIN | BOOKING_BY_DATE, BOOKING_BY_TRAIN | BOOKING_BY_DATE | BOOKING_BY_CLASS };
+    const char *name[2] = { "train+date", "train+date+class" };
+    for (int k = 0; k < 2; ++k) {
+        int g = 0;
+        t0 = sync_now();
+        for (int r = 0; r < ROUNDS; ++r)
+            g = booking_aggregate(&BL, by[k], BOOKING_AGG_ALL, rows, groups);
+        t1 = sync_now();
+        printf("%-17s: columns %6.2f ms, %d groups\n", name[k], (t1 - t0) * 1e3 / ROUNDS, g);
+    }
+
+    free(rows);
+    free(flat);
+    bookinglist_free(&BL);
+    trainlist_free(&TL);
+    return 0;
+}
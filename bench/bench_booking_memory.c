@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+
+/*
+ * 生成 N 条订单（默认 100 万：300 趟车 × 60 天、5 万名乘客、每车 16 站）写入临时文件后载入，
+ * 比较紧凑记录 + 驻留池与同样数量 Booking 数组的内存，以及按字段扫描全部订单的耗时。
+ */
+
+#define TMP_FILE "bench_bookings.tmp"
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (n <= 0) n = 1000000;
+
+    FILE *f = fopen(TMP_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % 300, d = (i / 300) % 60, p = (i * 7919) % 50000, a = i % 15;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|11010119900101%04d|乘客%d|%s|G%d|站点%d|站点%d|%02d:%02d|%.2f|2-%d|1|%d|%d|%d|%d\n",
+                date, tr, i / 18000 + 1, p, p, date, tr, a, a + 1, 6 + tr % 14, tr % 60,
+                55.5 + a * 10, i % 600 + 1, i % 600, a, a + 1, i % 17 == 0);
+    }
+    fclose(f);
+
+    TrainList TL;
+    BookingList BL;
+    trainlist_init(&TL);
+    bookinglist_init(&BL);
+    double t0 = sync_now();
+    int ok = load_bookings(TMP_FILE, &BL, &TL);
+    double t1 = sync_now();
+    remove(TMP_FILE);
+    if (!ok) { printf("load failed\n"); return 1; }
+
+    size_t compact = booking_storage_bytes(&BL);
+    size_t wide = sizeof(Booking) * (size_t)BL.size;
+    printf("bookings %d, load %.2f s\n", BL.size, t1 - t0);
+    printf("compact: %8.1f MB  (%zu B/record + string pools)\n", compact / 1048576.0, sizeof(BookingRec));
+    printf("Booking: %8.1f MB  (%zu B/record)\n", wide / 1048576.0, sizeof(Booking));
+    printf("ratio  : %.1fx smaller\n", (double)wide / (double)compact);
+
+    /* 扫描：统计有效订单票款，紧凑记录直接读整数字段，对照组为展开后的 Booking 数组 */
+    Booking *flat = malloc(wide);
+    for (int i = 0; i < BL.size; ++i) booking_get(&BL, i, &flat[i]);
+    long long cents = 0;
+    double s0 = sync_now();
+    for (int r = 0; r < 5; ++r)
+        for (int i = 0; i < BL.size; ++i) if (!BL.data[i].canceled) cents += BL.data[i].price_cents;
+    double s1 = sync_now();
+    double sum = 0;
+    for (int r = 0; r < 5; ++r)
+        for (int i = 0; i < BL.size; ++i) if (!flat[i].canceled) sum += flat[i].price;
+    double s2 = sync_now();
+    printf("scan   : compact %.2f ms, Booking %.2f ms per pass (revenue %.2f / %.2f)\n",
+           (s1 - s0) * 1e3 / 5, (s2 - s1) * 1e3 / 5, cents / 500.0, sum / 5);
+
+    free(flat);
+    bookinglist_free(&BL);
+    trainlist_free(&TL);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+#include "sync.h"
+
+/*
+ * 100 万个订单号形式的键：插入（不预留容量，含扩容）、命中查找、未命中查找、
+ * 删除一半后再查找，输出每次操作的纳秒数。
+ */
+
+#define KEYS 1000000
+#define KEY_LEN 24
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : KEYS;
+    if (n <= 0) n = KEYS;
+    char *keys = malloc((size_t)n * KEY_LEN);
+    if (!keys) return 1;
+    for (int i = 0; i < n; ++i)
+        snprintf(keys + (size_t)i * KEY_LEN, KEY_LEN, "2026-08-%02d-G%d-%04d", 1 + i % 28, 100 + i / 9973, i % 9973);
+
+    HashTable *ht = ht_create(1031);
+    double t0 = sync_now();
+    for (int i = 0; i < n; ++i) ht_insert(ht, keys + (size_t)i * KEY_LEN, i);
+    double t1 = sync_now();
+
+    long hit = 0;
+    for (int r = 0; r < 3; ++r)
+        for (int i = 0; i < n; ++i) hit += ht_find(ht, keys + (size_t)((i * 7919LL) % n) * KEY_LEN) >= 0;
+    double t2 = sync_now();
+
+    char miss[KEY_LEN];
+    long missed = 0;
+    for (int i = 0; i < n; ++i) {
+        snprintf(miss, sizeof(miss), "2026-09-%02d-X%d", 1 + i % 28, i);
+        missed += ht_find(ht, miss) < 0;
+    }
+    double t3 = sync_now();
+
+    for (int i = 0; i < n; i += 2) ht_remove(ht, keys + (size_t)i * KEY_LEN);
+    double t4 = sync_now();
+    for (int i = 0; i < n; ++i) hit += ht_find(ht, keys + (size_t)i * KEY_LEN) >= 0;
+    double t5 = sync_now();
+
+    printf("keys %d (left %d), hits %ld, misses %ld\n", n, ht_count(ht), hit, missed);
+    printf("insert      %7.1f ns/op\n", (t1 - t0) * 1e9 / n);
+    printf("find hit    %7.1f ns/op\n", (t2 - t1) * 1e9 / (3.0 * n));
+    printf("find miss   %7.1f ns/op  (includes key formatting)\n", (t3 - t2) * 1e9 / n);
+    printf("remove      %7.1f ns/op\n", (t4 - t3) * 1e9 / ((n + 1) / 2));
+    printf("find mixed  %7.1f ns/op  (after removing half)\n", (t5 - t4) * 1e9 / n);
+
+    ht_free(ht);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "wal.h"
+#include "sync.h"
+
+/*
+ * 增量保存：T 趟车（默认 3000，每车 16 站）与 N 条订单（默认 100 万）载入后先做一次完整保存，
+ * 之后每订一张票保存一次（K 次，默认 200），比较只落盘日志的增量保存与每次重写整个快照的耗时。
+ * 订票时 wal_commit 已把记录 fsync，增量保存只剩检查与一次空的日志落盘。
+ * 最后做一次后台保存：给出调用方被阻塞的映像生成时间、后台写出时间与写出期间完成的订票数。
+ */
+
+#define TRAIN_FILE "bench_inc_trains.tmp"
+#define BOOKING_FILE "bench_inc_bookings.tmp"
+#define SNAP_FILE "bench_inc.snap"
+#define BG_FILE "bench_inc_bg.snap"
+#define WAL_FILE "bench_inc.wal"
+#define STOPS 16
+
+static void cleanup(void) {
+    remove(TRAIN_FILE);
+    remove(BOOKING_FILE);
+    remove(SNAP_FILE);
+    remove(BG_FILE);
+    remove(WAL_FILE);
+    remove(WAL_FILE ".old");
+}
+
+int main(int argc, char **argv) {
+    int trains = argc > 1 ? atoi(argv[1]) : 3000;
+    int n = argc > 2 ? atoi(argv[2]) : 1000000;
+    int k = argc > 3 ? atoi(argv[3]) : 200;
+    if (trains <= 0) trains = 3000;
+    if (n <= 0) n = 1000000;
+    if (k <= 0) k = 200;
+
+    FILE *f = fopen(TRAIN_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", trains);
+    for (int i = 0; i < trains; ++i) {
+        fprintf(f, "G%d|站点%d|站点%d|08:00|100.00|1|300|%d|20|60|400|0|3.0|1.6|1.0|1.0\n",
+                i, i % 400, (i + 15) % 400, STOPS);
+        for (int j = 0; j < STOPS; ++j)
+            fprintf(f, "站点%d|%02d:%02d|%02d:%02d|%d\n", (i + j) % 400, 8 + j / 2, j % 2 * 30, 8 + j / 2, j % 2 * 30 + 2, j * 50);
+    }
+    fclose(f);
+
+    f = fopen(BOOKING_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 30, a = i % (STOPS - 1), seat = (i / (trains * 30)) % 400;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|3-%d|2|%d|%d|%d|%d\n",
+                date, tr, i / (trains * 30) + 1, i % 50000, i % 50000, date, tr, (tr + a) % 400, (tr + a + 1) % 400,
+                55.5 + a * 10, seat + 1, seat, a, a + 1, i % 17 == 0);
+    }
+    fclose(f);
+
+    TrainList TL;
+    PassengerList PL;
+    BookingList BL;
+    trainlist_init(&TL);
+    passengerlist_init(&PL);
+    bookinglist_init(&BL);
+    Passenger p;
+    memset(&p, 0, sizeof(p));
+    strcpy(p.id_type, "ID");
+    strcpy(p.id_num, "B1");
+    strcpy(p.name, "Bench");
+    passenger_add(&PL, &p);
+    if (!load_trains(TRAIN_FILE, &TL) || !load_bookings_parallel(BOOKING_FILE, &BL, &TL, 0)) {
+        printf("load failed\n");
+        cleanup();
+        return 1;
+    }
+    wal_open(WAL_FILE);
+
+    double t0 = sync_now();
+    int res = save_snapshot_incremental(SNAP_FILE, &TL, &PL, &BL);
+    double t1 = sync_now();
+    printf("trains %d, bookings %d\n", TL.size, BL.size);
+    printf("first save (%s)        : %8.1f ms\n", res == SNAPSHOT_WRITTEN ? "full" : "????", (t1 - t0) * 1e3);
+
+    char from[STATION_LEN], to[STATION_LEN];
+    double inc = 0.0, full = 0.0;
+    int logged = 0;
+    WalStats st;
+    for (int i = 0; i < 2 * k; ++i) {
+        int tr = i % trains;
+        char id[ID_LEN];
+        snprintf(id, sizeof(id), "G%d", tr);
+        snprintf(from, sizeof(from), "站点%d", tr % 400);
+        snprintf(to, sizeof(to), "站点%d", (tr + STOPS - 1) % 400);
+        booking_create(&BL, &TL, &PL, "2026-09-15", id, from, to, "B1", 1, NULL, 0);
+        double s0 = sync_now();
+        if (i < k) {
+            logged += save_snapshot_incremental(SNAP_FILE, &TL, &PL, &BL) == SNAPSHOT_LOGGED;
+            inc += sync_now() - s0;
+            wal_stats(&st);
+        } else {
+            wal_checkpoint_begin();
+            wal_checkpoint_end(save_snapshot(SNAP_FILE, &TL, &PL, &BL));
+            full += sync_now() - s0;
+        }
+    }
+    printf("incremental save x%d    : %8.3f ms each (%d log-only, log %lld bytes)\n", k, inc * 1e3 / k, logged, st.log_bytes);
+    printf("full snapshot save x%d  : %8.3f ms each\n", k, full * 1e3 / k);
+
+    /* 换一个文件名，必然写整个快照 */
+    res = save_snapshot_background(BG_FILE, &TL, &PL, &BL);
+    int during = 0;
+    SnapshotStatus ss;
+    snapshot_status(&ss);
+    while (res == SNAPSHOT_STARTED && ss.state == SNAPSHOT_RUNNING) {
+        int tr = during % trains;
+        char id[ID_LEN];
+        snprintf(id, sizeof(id), "G%d", tr);
+        snprintf(from, sizeof(from), "站点%d", tr % 400);
+        snprintf(to, sizeof(to), "站点%d", (tr + STOPS - 1) % 400);
+        during += booking_create(&BL, &TL, &PL, "2026-09-16", id, from, to, "B1", 1, NULL, 0) == 0;
+        snapshot_status(&ss);
+    }
+    int bg_ok = snapshot_wait();
+    snapshot_status(&ss);
+    printf("background save (%s)    : %8.1f ms blocked, %8.1f ms writing %.1f MB, %d bookings meanwhile\n",
+           bg_ok ? "ok" : "failed", ss.capture_ms, ss.write_ms, ss.total / 1048576.0, during);
+
+    wal_close();
+    bookinglist_free(&BL);
+    passengerlist_free(&PL);
+    trainlist_free(&TL);
+    cleanup();
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+
+/*
+ * 载入时的分配次数：T 趟车（默认 3000，每车 16 站）与 N 条订单（默认 20 万，分布在 30 天）
+ * 写入临时文件后载入，报告各内存池分配的对象数与实际向系统申请的次数，以及载入与释放耗时。
+ * 引入内存池之前，每个对象都是一次 malloc/calloc/realloc。
+ */
+
+#define TRAIN_FILE "bench_load_trains.tmp"
+#define BOOKING_FILE "bench_load_bookings.tmp"
+#define STOPS 16
+
+static void report(const char *name, const ArenaStats *st) {
+    printf("%-8s: %8lld objects (%lld released) from %5lld system allocations, %6.1f MB reserved, %6.1f MB live\n",
+           name, st->allocs, st->frees, st->sys_allocs, st->reserved / 1048576.0, st->live / 1048576.0);
+}
+
+int main(int argc, char **argv) {
+    int trains = argc > 1 ? atoi(argv[1]) : 3000;
+    int n = argc > 2 ? atoi(argv[2]) : 200000;
+    if (trains <= 0) trains = 3000;
+    if (n <= 0) n = 200000;
+
+    FILE *f = fopen(TRAIN_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", trains);
+    for (int i = 0; i < trains; ++i) {
+        fprintf(f, "G%d|站点%d|站点%d|08:00|100.00|1|300|%d|20|60|400|0|3.0|1.6|1.0|1.0\n",
+                i, i % 400, (i + 15) % 400, STOPS);
+        for (int k = 0; k < STOPS; ++k)
+            fprintf(f, "站点%d|%02d:%02d|%02d:%02d|%d\n", (i + k) % 400, 8 + k / 2, k % 2 * 30, 8 + k / 2, k % 2 * 30 + 2, k * 50);
+    }
+    fclose(f);
+
+    f = fopen(BOOKING_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 30, a = i % (STOPS - 1), seat = (i / (trains * 30)) % 400;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|3-%d|2|%d|%d|%d|0\n",
+                date, tr, i / (trains * 30) + 1, i % 50000, i % 50000, date, tr, (tr + a) % 400, (tr + a + 1) % 400,
+                55.5 + a * 10, seat + 1, seat, a, a + 1);
+    }
+    fclose(f);
+
+    TrainList TL;
+    BookingList BL;
+    trainlist_init(&TL);
+    bookinglist_init(&BL);
+    double t0 = sync_now();
+    int ok = load_trains(TRAIN_FILE, &TL);
+    double t1 = sync_now();
+    ok = ok && load_bookings(BOOKING_FILE, &BL, &TL);
+    double t2 = sync_now();
+    remove(TRAIN_FILE);
+    remove(BOOKING_FILE);
+    if (!ok) { printf("load failed\n"); return 1; }
+
+    ArenaStats ts, bs;
+    train_alloc_stats(&ts);
+    booking_alloc_stats(&bs);
+    SeatmapMemStats mem;
+    train_seatmap_mem_stats(&mem);
+    printf("trains %d, bookings %d, seatmap chunks %d\n", TL.size, BL.size, mem.chunks);
+    printf("load   : trains %.1f ms, bookings %.1f ms\n", (t1 - t0) * 1e3, (t2 - t1) * 1e3);
+    report("train", &ts);
+    report("booking", &bs);
+
+    double t3 = sync_now();
+    bookinglist_free(&BL);
+    trainlist_free(&TL);
+    double t4 = sync_now();
+    printf("free   : %.1f ms\n", (t4 - t3) * 1e3);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "train.h"
+#include "sync.h"
+
+/*
+ * 线程反复分配/释放座位（21 站、二等座 1000 座），比较 1..N 线程的总吞吐：
+ *   distinct  每线程各用一个车次，不同车次的座位操作只竞争读锁，应随核数近线性增长；
+ *   hot       所有线程抢同一车次同一日期，比较加槽位锁（first-fit）与 CAS 抢座（lock-free）。
+ * 线程数默认到核数为止，可由第一个参数指定上限。
+ */
+
+#define STOPS 21
+#define SEATS 1000
+#define OPS 400000
+#define MAX_THREADS 16
+
+static TrainList TL;
+
+typedef struct { int id, train; } Arg;
+
+static void *worker(void *p) {
+    Arg *a = p;
+    char tid[ID_LEN], from[16], to[16];
+    int (*held)[3] = malloc(sizeof(int[3]) * SEATS);
+    int limit = a->train == a->id ? SEATS / 2 : SEATS / 16;
+    int nheld = 0;
+    unsigned long long rs = 99 + a->id;
+    snprintf(tid, sizeof(tid), "P%d", a->train);
+    for (int i = 0; i < OPS; ++i) {
+        rs = rs * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned r = (unsigned)(rs >> 33);
+        if (nheld > limit || (nheld > 0 && r % 3 == 0)) {
+            int k = r % nheld;
+            train_release_seat(&TL, tid, "2026-06-01", 2, held[k][0], held[k][1], held[k][2]);
+            memcpy(held[k], held[--nheld], sizeof(held[k]));
+            continue;
+        }
+        int f = r % (STOPS - 1);
+        int t = f + 1 + (r >> 8) % (STOPS - 1 - f);
+        snprintf(from, sizeof(from), "S%d", f);
+        snprintf(to, sizeof(to), "S%d", t);
+        int seat, fi, ti;
+        if (train_allocate_seat(&TL, tid, "2026-06-01", from, to, 2, &seat, &fi, &ti) == 0) {
+            held[nheld][0] = seat; held[nheld][1] = fi; held[nheld][2] = ti;
+            nheld++;
+        }
+    }
+    for (int k = 0; k < nheld; ++k)
+        train_release_seat(&TL, tid, "2026-06-01", 2, held[k][0], held[k][1], held[k][2]);
+    free(held);
+    return NULL;
+}
+
+static void run(const char *label, int policy, int hot, int cpus) {
+    double base = 0;
+    train_set_alloc_policy(policy);
+    for (int n = 1; n <= cpus; n *= 2) {
+        Arg args[MAX_THREADS];
+        SyncThread *th[MAX_THREADS];
+        double t0 = sync_now();
+        for (int i = 0; i < n; ++i) {
+            args[i].id = i; args[i].train = hot ? 0 : i;
+            th[i] = sync_thread_start(worker, &args[i]);
+        }
+        for (int i = 0; i < n; ++i) sync_thread_join(th[i]);
+        double sec = sync_now() - t0;
+        double mops = (double)OPS * n / sec / 1e6;
+        if (n == 1) base = mops;
+        printf("%-8s %-10s threads %2d  %8.2f Mops/s  speedup %.2fx\n",
+               label, policy == ALLOC_LOCK_FREE ? "lock-free" : "first-fit", n, mops, mops / base);
+    }
+}
+
+int main(int argc, char **argv) {
+    trainlist_init(&TL);
+    int cpus = argc > 1 ? atoi(argv[1]) : sync_cpu_count();
+    if (cpus < 1) cpus = 1;
+    if (cpus > MAX_THREADS) cpus = MAX_THREADS;
+    for (int k = 0; k < MAX_THREADS; ++k) {
+        Train t;
+        memset(&t, 0, sizeof(t));
+        snprintf(t.train_id, ID_LEN, "P%d", k);
+        t.stop_count = STOPS;
+        t.stops = calloc(STOPS, sizeof(Stop));
+        for (int i = 0; i < STOPS; ++i) snprintf(t.stops[i].name, STATION_LEN, "S%d", i);
+        t.seat_count[2] = SEATS;
+        for (int i = 0; i < 4; ++i) t.seat_price_coef[i] = 1.0;
+        train_add(&TL, &t);
+    }
+
+    run("distinct", ALLOC_FIRST_FIT, 0, cpus);
+    run("hot", ALLOC_FIRST_FIT, 1, cpus);
+    run("hot", ALLOC_LOCK_FREE, 1, cpus);
+
+    trainlist_free(&TL);
+    return 0;
+}
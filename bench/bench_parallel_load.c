@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+
+/*
+ * 并行载入 bookings.txt：T 趟车（默认 2000，每车 16 站）与 N 条订单（默认 200 万，分布在 30 天），
+ * 先用逐行的 load_bookings 载入作基准，再用 load_bookings_parallel 以 1/2/4/8/16 线程载入，
+ * 每次都在新建的车次表与空订单表上进行，并核对订单数与余票一致。
+ */
+
+#define TRAIN_FILE "bench_pload_trains.tmp"
+#define BOOKING_FILE "bench_pload_bookings.tmp"
+#define STOPS 16
+
+static long long remaining_sum(TrainList *TL, int trains) {
+    long long sum = 0;
+    for (int i = 0; i < trains; i += 97) {
+        char id[ID_LEN], a[STATION_LEN], b[STATION_LEN];
+        snprintf(id, sizeof(id), "G%d", i);
+        snprintf(a, sizeof(a), "站点%d", i % 400);
+        snprintf(b, sizeof(b), "站点%d", (i + STOPS - 1) % 400);
+        sum += train_remaining_seats(TL, id, "2026-08-03", a, b, 2);
+    }
+    return sum;
+}
+
+/* threads 为 0 时用 load_bookings；返回耗时（秒），失败返回负数 */
+static double run(int threads, int trains, int *size, long long *seats) {
+    TrainList TL;
+    BookingList BL;
+    trainlist_init(&TL);
+    bookinglist_init(&BL);
+    double t = -1.0;
+    if (load_trains(TRAIN_FILE, &TL)) {
+        double t0 = sync_now();
+        int ok = threads ? load_bookings_parallel(BOOKING_FILE, &BL, &TL, threads) : load_bookings(BOOKING_FILE, &BL, &TL);
+        t = ok ? sync_now() - t0 : -1.0;
+        *size = BL.size;
+        *seats = remaining_sum(&TL, trains);
+    }
+    bookinglist_free(&BL);
+    trainlist_free(&TL);
+    return t;
+}
+
+int main(int argc, char **argv) {
+    int trains = argc > 1 ? atoi(argv[1]) : 2000;
+    int n = argc > 2 ? atoi(argv[2]) : 2000000;
+    if (trains <= 0) trains = 2000;
+    if (n <= 0) n = 2000000;
+
+    FILE *f = fopen(TRAIN_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", trains);
+    for (int i = 0; i < trains; ++i) {
+        fprintf(f, "G%d|站点%d|站点%d|08:00|100.00|1|300|%d|20|60|400|0|3.0|1.6|1.0|1.0\n",
+                i, i % 400, (i + 15) % 400, STOPS);
+        for (int k = 0; k < STOPS; ++k)
+            fprintf(f, "站点%d|%02d:%02d|%02d:%02d|%d\n", (i + k) % 400, 8 + k / 2, k % 2 * 30, 8 + k / 2, k % 2 * 30 + 2, k * 50);
+    }
+    fclose(f);
+
+    f = fopen(BOOKING_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 30, a = i % (STOPS - 1), seat = (i / (trains * 30)) % 400;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|3-%d|2|%d|%d|%d|%d\n",
+                date, tr, i / (trains * 30) + 1, i % 50000, i % 50000, date, tr, (tr + a) % 400, (tr + a + 1) % 400,
+                55.5 + a * 10, seat + 1, seat, a, a + 1, i % 17 == 0);
+    }
+    fclose(f);
+
+    int size0, size;
+    long long seats0, seats;
+    double serial = run(0, trains, &size0, &seats0);
+    if (serial < 0) { printf("serial load failed\n"); return 1; }
+    printf("cpus %d, trains %d, bookings %d\n", sync_cpu_count(), trains, size0);
+    printf("load_bookings          : %8.1f ms\n", serial * 1e3);
+
+    static const int threads[] = { 1, 2, 4, 8, 16 };
+    for (int k = 0; k < 5; ++k) {
+        double t = run(threads[k], trains, &size, &seats);
+        if (t < 0) { printf("parallel load failed\n"); return 1; }
+        printf("parallel, %2d threads   : %8.1f ms  speedup %.2fx  %s\n", threads[k], t * 1e3, serial / t,
+               size == size0 && seats == seats0 ? "match" : "MISMATCH");
+    }
+
+    remove(TRAIN_FILE);
+    remove(BOOKING_FILE);
+    return 0;
+}
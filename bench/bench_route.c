@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "route.h"
+#include "sync.h"
+
+/*
+ * 合成线网：STATIONS 个站排成 20 列的网格，每趟车沿网格随机游走 8..20 站，
+ * 06:00..20:00 间随机发车，站间 15..40 分钟、停站 2 分钟。
+ * 随机起止站与出发时间查询最多换乘两次的最早到达，输出建表耗时与每次查询的毫秒数。
+ */
+
+#define STATIONS 400
+#define COLS 20
+#define QUERIES 2000
+
+static unsigned long long rs = 12345;
+
+static unsigned rnd(void) {
+    rs = rs * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(rs >> 33);
+}
+
+static void fmt_time(char *out, int min) {
+    min %= 1440;
+    snprintf(out, TIME_LEN, "%02d:%02d", min / 60, min % 60);
+}
+
+int main(int argc, char **argv) {
+    int ntrains = argc > 1 ? atoi(argv[1]) : 3000;
+    if (ntrains <= 0) ntrains = 3000;
+
+    TrainList TL;
+    trainlist_init(&TL);
+    for (int k = 0; k < ntrains; ++k) {
+        Train t;
+        memset(&t, 0, sizeof(t));
+        snprintf(t.train_id, ID_LEN, "R%d", k);
+        t.running = 1;
+        t.stop_count = 8 + rnd() % 13;
+        t.stops = calloc(t.stop_count, sizeof(Stop));
+        int s = rnd() % STATIONS, clock = 360 + rnd() % 840;
+        int dir = rnd() % 4;
+        for (int i = 0; i < t.stop_count; ++i) {
+            snprintf(t.stops[i].name, STATION_LEN, "S%d", s);
+            if (i > 0) fmt_time(t.stops[i].arrive, clock);
+            if (i + 1 < t.stop_count) { clock += i > 0 ? 2 : 0; fmt_time(t.stops[i].depart, clock); }
+            clock += 15 + rnd() % 26;
+            if (rnd() % 4 == 0) dir = rnd() % 4;
+            int r = s / COLS, c = s % COLS;
+            if (dir == 0 && c + 1 < COLS) c++; else if (dir == 1 && c > 0) c--;
+            else if (dir == 2 && r + 1 < STATIONS / COLS) r++; else if (r > 0) r--;
+            s = r * COLS + c;
+        }
+        t.seat_count[2] = 100;
+        train_add(&TL, &t);
+    }
+
+    double t0 = sync_now();
+    Router *r = route_build(&TL);
+    double t1 = sync_now();
+    printf("trains %d, stations %d, connections %d, build %.1f ms\n",
+           ntrains, route_station_count(r), route_connection_count(r), (t1 - t0) * 1e3);
+
+    int found = 0, legs[ROUTE_MAX_LEGS + 1] = { 0 };
+    double worst = 0;
+    char from[16], to[16], at[TIME_LEN];
+    t0 = sync_now();
+    for (int q = 0; q < QUERIES; ++q) {
+        snprintf(from, sizeof(from), "S%u", rnd() % STATIONS);
+        snprintf(to, sizeof(to), "S%u", rnd() % STATIONS);
+        fmt_time(at, 360 + rnd() % 600);
+        RoutePlan p;
+        double q0 = sync_now();
+        if (route_earliest(r, from, to, at, 10, 2, &p) == 0) { found++; legs[p.legs]++; }
+        double dq = sync_now() - q0;
+        if (dq > worst) worst = dq;
+    }
+    t1 = sync_now();
+    printf("queries %d, found %d (1 leg %d, 2 legs %d, 3 legs %d)\n", QUERIES, found, legs[1], legs[2], legs[3]);
+    printf("avg %.3f ms/query, worst %.3f ms\n", (t1 - t0) * 1e3 / QUERIES, worst * 1e3);
+
+    route_free(r);
+    trainlist_free(&TL);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scan.h"
+#include "booking.h"
+#include "sync.h"
+
+/*
+ * 文本解析吞吐（MB/s）：N 条订单（默认 200 万）的 bookings 文件，
+ * 比较原来的 fgets + strtok/strncpy + atoi/atof 逐行解析与扫描器在映射内存上的解析（只解析不入表），
+ * 再给出 load_trains / load_bookings 整体载入的吞吐。
+ */
+
+#define TRAIN_FILE "bench_scan_trains.tmp"
+#define BOOKING_FILE "bench_scan_bookings.tmp"
+#define STOPS 16
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+/* 原实现：栈上 2048 字节行缓冲，strtok 切分后逐字段 strncpy / atoi / atof */
+static int parse_legacy(const char *path, long long *check) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    int count = 0;
+    if (fscanf(f, "%d\n", &count) != 1) { fclose(f); return 0; }
+    char line[2048];
+    for (int i = 0; i < count; ++i) {
+        if (!fgets(line, sizeof(line), f)) { fclose(f); return 0; }
+        size_t ln = strlen(line);
+        if (ln && line[ln - 1] == '\n') line[ln - 1] = 0;
+        char *parts[15];
+        int p = 0;
+        char *tok = strtok(line, "|");
+        while (tok && p < 15) { parts[p++] = tok; tok = strtok(NULL, "|"); }
+        if (p < 15) { fclose(f); return 0; }
+        Booking b;
+        memset(&b, 0, sizeof(b));
+        strncpy(b.order_id, parts[0], ORDER_ID_LEN - 1);
+        strncpy(b.passenger_id, parts[1], ID_LEN - 1);
+        strncpy(b.passenger_name, parts[2], NAME_LEN - 1);
+        strncpy(b.date, parts[3], DATE_LEN - 1);
+        strncpy(b.train_id, parts[4], ID_LEN - 1);
+        strncpy(b.from, parts[5], STATION_LEN - 1);
+        strncpy(b.to, parts[6], STATION_LEN - 1);
+        strncpy(b.depart_time, parts[7], TIME_LEN - 1);
+        b.price = atof(parts[8]);
+        strncpy(b.seat_no, parts[9], sizeof(b.seat_no) - 1);
+        b.seat_class = atoi(parts[10]);
+        b.seat_index = atoi(parts[11]);
+        b.from_stop_idx = atoi(parts[12]);
+        b.to_stop_idx = atoi(parts[13]);
+        b.canceled = atoi(parts[14]);
+        *check += b.seat_index + (long long)(b.price * 100 + 0.5) + b.train_id[1];
+    }
+    fclose(f);
+    return 1;
+}
+
+/* 扫描器：映射整个文件，字段直接读进 Booking */
+static int parse_scan(const char *path, long long *check) {
+    MappedFile m;
+    if (map_file(path, &m) != 0) return 0;
+    Scanner s;
+    int count = 0;
+    scan_init(&s, m.p, m.len, 1);
+    scan_line(&s);
+    scan_int(&s, &count);
+    for (int i = 0; i < count && !s.err; ++i) {
+        Booking b;
+        memset(&b, 0, sizeof(b));
+        scan_line(&s);
+        scan_str(&s, b.order_id, sizeof(b.order_id));
+        scan_str(&s, b.passenger_id, sizeof(b.passenger_id));
+        scan_str(&s, b.passenger_name, sizeof(b.passenger_name));
+        scan_str(&s, b.date, sizeof(b.date));
+        scan_str(&s, b.train_id, sizeof(b.train_id));
+        scan_str(&s, b.from, sizeof(b.from));
+        scan_str(&s, b.to, sizeof(b.to));
+        scan_str(&s, b.depart_time, sizeof(b.depart_time));
+        scan_double(&s, &b.price);
+        scan_str(&s, b.seat_no, sizeof(b.seat_no));
+        scan_int(&s, &b.seat_class);
+        scan_int(&s, &b.seat_index);
+        scan_int(&s, &b.from_stop_idx);
+        scan_int(&s, &b.to_stop_idx);
+        scan_int(&s, &b.canceled);
+        *check += b.seat_index + (long long)(b.price * 100 + 0.5) + b.train_id[1];
+    }
+    unmap_file(&m);
+    return !s.err;
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000000;
+    int trains = 2000;
+    if (n <= 0) n = 2000000;
+
+    FILE *f = fopen(TRAIN_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", trains);
+    for (int i = 0; i < trains; ++i) {
+        fprintf(f, "G%d|站点%d|站点%d|08:00|100.00|1|300|%d|20|60|400|0|3.000|1.600|1.000|1.000\n",
+                i, i % 400, (i + 15) % 400, STOPS);
+        for (int k = 0; k < STOPS; ++k)
+            fprintf(f, "站点%d|%02d:%02d|%02d:%02d|%d\n", (i + k) % 400, 8 + k / 2, k % 2 * 30, 8 + k / 2, k % 2 * 30 + 2, k * 50);
+    }
+    fclose(f);
+
+    f = fopen(BOOKING_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 30, a = i % (STOPS - 1), seat = (i / (trains * 30)) % 400;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|3-%d|2|%d|%d|%d|%d\n",
+                date, tr, i / (trains * 30) + 1, i % 50000, i % 50000, date, tr, (tr + a) % 400, (tr + a + 1) % 400,
+                55.5 + a * 10, seat + 1, seat, a, a + 1, i % 17 == 0);
+    }
+    fclose(f);
+
+    double mb = file_size(BOOKING_FILE) / 1048576.0;
+    long long c1 = 0, c2 = 0;
+    double t0 = sync_now();
+    int ok1 = parse_legacy(BOOKING_FILE, &c1);
+    double t1 = sync_now();
+    int ok2 = parse_scan(BOOKING_FILE, &c2);
+    double t2 = sync_now();
+    if (!ok1 || !ok2) { printf("parse failed\n"); return 1; }
+    printf("bookings %d, %.1f MB\n", n, mb);
+    printf("parse, strtok/strncpy : %8.1f ms  %7.1f MB/s\n", (t1 - t0) * 1e3, mb / (t1 - t0));
+    printf("parse, scanner        : %8.1f ms  %7.1f MB/s  (%.2fx, fields %s)\n", (t2 - t1) * 1e3, mb / (t2 - t1),
+           (t1 - t0) / (t2 - t1), c1 == c2 ? "match" : "MISMATCH");
+
+    TrainList TL;
+    BookingList BL;
+    trainlist_init(&TL);
+    bookinglist_init(&BL);
+    double tmb = file_size(TRAIN_FILE) / 1048576.0;
+    t0 = sync_now();
+    ok1 = load_trains(TRAIN_FILE, &TL);
+    t1 = sync_now();
+    ok2 = ok1 && load_bookings(BOOKING_FILE, &BL, &TL);
+    t2 = sync_now();
+    if (!ok2) { printf("load failed\n"); return 1; }
+    printf("load_trains           : %8.1f ms  %7.1f MB/s\n", (t1 - t0) * 1e3, tmb / (t1 - t0));
+    printf("load_bookings         : %8.1f ms  %7.1f MB/s\n", (t2 - t1) * 1e3, mb / (t2 - t1));
+
+    bookinglist_free(&BL);
+    trainlist_free(&TL);
+    remove(TRAIN_FILE);
+    remove(BOOKING_FILE);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "train.h"
+
+/*
+ * 200 趟车 × 30 天：每个车次-日期都有余票查询，约 1/5 的车次-日期有少量二等座售出，
+ * 其中少数热门日期售出上千张。对比懒分配的实际内存与“日期一有售出即分配全部等级与全部座位”的估算值。
+ */
+
+#define TRAINS 200
+#define DAYS 30
+#define STOPS 16
+
+static const int seats[4] = { 24, 120, 1000, 0 };
+
+/* 一个等级全部分配时的字节数：rows + seg_occ + run_cnt + run_bit */
+static long long eager_class_bytes(int segs, int n) {
+    if (n <= 0) return 0;
+    long long stride = ((n + 63) / 64 + 3) & ~3;
+    return 8LL * n + 8LL * stride * segs + 4LL * (segs + 1) * (segs + 1) + 4LL * (segs + 2) * (segs + 2);
+}
+
+int main(void) {
+    TrainList TL;
+    trainlist_init(&TL);
+    for (int k = 0; k < TRAINS; ++k) {
+        Train t;
+        memset(&t, 0, sizeof(t));
+        snprintf(t.train_id, ID_LEN, "M%d", k);
+        t.stop_count = STOPS;
+        t.stops = calloc(STOPS, sizeof(Stop));
+        for (int i = 0; i < STOPS; ++i) snprintf(t.stops[i].name, STATION_LEN, "S%d", i);
+        for (int c = 0; c < 4; ++c) { t.seat_count[c] = seats[c]; t.seat_price_coef[c] = 1.0; }
+        train_add(&TL, &t);
+    }
+
+    unsigned long long rs = 7;
+    long sold = 0, touched = 0;
+    char tid[ID_LEN], date[DATE_LEN];
+    int base = train_date_to_day("2026-08-01");
+    for (int k = 0; k < TRAINS; ++k)
+        for (int d = 0; d < DAYS; ++d) {
+            snprintf(tid, sizeof(tid), "M%d", k);
+            train_day_to_date(base + d, date, sizeof(date));
+            for (int c = 0; c < 3; ++c) train_remaining_seats(&TL, tid, date, "S0", "S15", c);
+            rs = rs * 6364136223846793005ULL + 1442695040888963407ULL;
+            unsigned r = (unsigned)(rs >> 33);
+            if (r % 5) continue;
+            int n = (r % 97 == 0) ? 1500 : 1 + r % 40;
+            for (int i = 0; i < n; ++i) {
+                int seat, fi, ti;
+                char from[8], to[8];
+                int f = (r + i) % 10;
+                snprintf(from, sizeof(from), "S%d", f);
+                snprintf(to, sizeof(to), "S%d", f + 1 + (i % 5));
+                if (train_allocate_seat(&TL, tid, date, from, to, 2, &seat, &fi, &ti) == 0) sold++;
+            }
+            touched++;
+        }
+
+    SeatmapMemStats st;
+    train_seatmap_mem_stats(&st);
+    long long eager_per_date = 0;
+    for (int c = 0; c < 4; ++c) eager_per_date += eager_class_bytes(STOPS - 1, seats[c]);
+    long long eager = eager_per_date * touched;
+    printf("train-dates queried %d, with sales %ld, tickets sold %ld\n", TRAINS * DAYS, touched, sold);
+    printf("lazy : %10lld bytes  (dates %d, classes %d, chunks %d)\n", st.bytes, st.dates, st.classes, st.chunks);
+    printf("eager: %10lld bytes  (every date with sales, all classes fully allocated)\n", eager);
+    printf("ratio: %.1fx smaller\n", (double)eager / (double)(st.bytes ? st.bytes : 1));
+
+    trainlist_free(&TL);
+    train_seatmap_mem_stats(&st);
+    printf("after free: %lld bytes\n", st.bytes);
+    return 0;
+}
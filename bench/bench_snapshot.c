@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "sync.h"
+
+/*
+ * 启动耗时：T 趟车（默认 3000，每车 16 站）与 N 条订单（默认 300 万，分布在 30 天）
+ * 先从文本载入（逐行解析 + 逐条 train_mark_seat 重建座位），保存为二进制快照，
+ * 再清空后从快照载入，比较两种启动路径的耗时并核对余票一致。
+ */
+
+#define TRAIN_FILE "bench_snap_trains.tmp"
+#define BOOKING_FILE "bench_snap_bookings.tmp"
+#define SNAP_FILE "bench_snap.snap"
+#define STOPS 16
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+static long long remaining_sum(TrainList *TL, int trains) {
+    long long sum = 0;
+    for (int i = 0; i < trains; i += 97) {
+        char id[ID_LEN], a[STATION_LEN], b[STATION_LEN];
+        snprintf(id, sizeof(id), "G%d", i);
+        snprintf(a, sizeof(a), "站点%d", i % 400);
+        snprintf(b, sizeof(b), "站点%d", (i + STOPS - 1) % 400);
+        sum += train_remaining_seats(TL, id, "2026-08-03", a, b, 2);
+    }
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    int trains = argc > 1 ? atoi(argv[1]) : 3000;
+    int n = argc > 2 ? atoi(argv[2]) : 3000000;
+    if (trains <= 0) trains = 3000;
+    if (n <= 0) n = 3000000;
+
+    FILE *f = fopen(TRAIN_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", trains);
+    for (int i = 0; i < trains; ++i) {
+        fprintf(f, "G%d|站点%d|站点%d|08:00|100.00|1|300|%d|20|60|400|0|3.0|1.6|1.0|1.0\n",
+                i, i % 400, (i + 15) % 400, STOPS);
+        for (int k = 0; k < STOPS; ++k)
+            fprintf(f, "站点%d|%02d:%02d|%02d:%02d|%d\n", (i + k) % 400, 8 + k / 2, k % 2 * 30, 8 + k / 2, k % 2 * 30 + 2, k * 50);
+    }
+    fclose(f);
+
+    f = fopen(BOOKING_FILE, "w");
+    if (!f) return 1;
+    fprintf(f, "%d\n", n);
+    int base = train_date_to_day("2026-08-01");
+    for (int i = 0; i < n; ++i) {
+        char date[DATE_LEN];
+        int tr = i % trains, d = (i / trains) % 30, a = i % (STOPS - 1), seat = (i / (trains * 30)) % 400;
+        train_day_to_date(base + d, date, sizeof(date));
+        fprintf(f, "%s-G%d-%04d|P%d|乘客%d|%s|G%d|站点%d|站点%d|08:00|%.2f|3-%d|2|%d|%d|%d|%d\n",
+                date, tr, i / (trains * 30) + 1, i % 50000, i % 50000, date, tr, (tr + a) % 400, (tr + a + 1) % 400,
+                55.5 + a * 10, seat + 1, seat, a, a + 1, i % 17 == 0);
+    }
+    fclose(f);
+
+    TrainList TL;
+    PassengerList PL;
+    BookingList BL;
+    trainlist_init(&TL);
+    passengerlist_init(&PL);
+    bookinglist_init(&BL);
+    double t0 = sync_now();
+    int ok = load_trains(TRAIN_FILE, &TL) && load_bookings(BOOKING_FILE, &BL, &TL);
+    double t1 = sync_now();
+    long text_bytes = file_size(TRAIN_FILE) + file_size(BOOKING_FILE);
+    remove(TRAIN_FILE);
+    remove(BOOKING_FILE);
+    if (!ok) { printf("text load failed\n"); return 1; }
+    long long expect = remaining_sum(&TL, trains);
+
+    double t2 = sync_now();
+    ok = save_snapshot(SNAP_FILE, &TL, &PL, &BL);
+    double t3 = sync_now();
+    if (!ok) { printf("snapshot save failed\n"); return 1; }
+
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    double t4 = sync_now();
+    ok = load_snapshot(SNAP_FILE, &TL, &PL, &BL);
+    double t5 = sync_now();
+    long snap_bytes = file_size(SNAP_FILE);
+    remove(SNAP_FILE);
+    if (!ok) { printf("snapshot load failed\n"); return 1; }
+
+    printf("trains %d, bookings %d\n", TL.size, BL.size);
+    printf("text load    : %8.1f ms  (%6.1f MB)\n", (t1 - t0) * 1e3, text_bytes / 1048576.0);
+    printf("snapshot save: %8.1f ms  (%6.1f MB)\n", (t3 - t2) * 1e3, snap_bytes / 1048576.0);
+    printf("snapshot load: %8.1f ms  (%.1fx faster)\n", (t5 - t4) * 1e3, (t1 - t0) / (t5 - t4));
+    printf("remaining seats %s\n", remaining_sum(&TL, trains) == expect ? "match" : "MISMATCH");
+
+    bookinglist_free(&BL);
+    passengerlist_free(&PL);
+    trainlist_free(&TL);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * 分级内存池：向系统按大块（默认 256KB）申请，块内按大小分级切分（16 字节对齐，
+ * 256 字节以内每级 16 字节，以上每个 2 的幂区间分 4 级），释放的对象挂回本级空闲链复用；
+ * 超过 64KB 的对象单独向系统申请。arena_reset 一次归还全部内存，无需逐个释放。
+ * 释放与改变大小时由调用方给出原大小。不加锁，由调用方与其所属数据一起保护。
+ */
+
+typedef struct Arena Arena;
+
+typedef struct {
+    long long allocs;        /* 累计分配的对象数（含 realloc 换块） */
+    long long frees;         /* 累计释放回池的对象数 */
+    long long sys_allocs;    /* 累计向系统申请的次数（大块 + 大对象） */
+    long long chunks;        /* 当前持有的系统内存块数 */
+    size_t reserved;         /* 当前持有的系统内存字节数 */
+    size_t live;             /* 仍在使用的对象字节数（按分级后大小） */
+} ArenaStats;
+
+Arena *arena_create(size_t chunk_size);  /* 0 取默认大小 */
+void arena_destroy(Arena *a);
+void arena_reset(Arena *a);
+
+void *arena_alloc(Arena *a, size_t n);
+void *arena_calloc(Arena *a, size_t n);
+void *arena_realloc(Arena *a, void *p, size_t old_n, size_t n);
+void arena_release(Arena *a, void *p, size_t n);
+
+void arena_stats(Arena *a, ArenaStats *st);
+
+#endif /* ARENA_H */
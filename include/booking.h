@@ -1,10 +1,12 @@
 #ifndef BOOKING_H
 #define BOOKING_H
 
+#include <stdint.h>
 #include "train.h"
 #include "passenger.h"
 
 #define ORDER_ID_LEN 64
+#define GROUP_MAX_SIZE 10
 
 typedef struct {
     char order_id[ORDER_ID_LEN];
@@ -24,8 +26,32 @@ typedef struct {
     int canceled;
 } Booking;
 
+/*
+ * BookingList 内部存储的紧凑订单记录（48 字节，Booking 约 440 字节）：
+ * 字符串字段为驻留池编号（车次/站名/发车时间一池，证件号/姓名一池），日期为日序号，票价以分计；
+ * 标准格式的订单号由 日期-车次号-serial 还原，其它格式的订单号存入池中（order_alt）。
+ * 座位号由等级与座位下标生成。读取请用 booking_get 展开为 Booking。
+ */
 typedef struct {
-    Booking *data;
+    uint32_t passenger_id;
+    uint32_t passenger_name;
+    uint32_t train_id;
+    uint32_t from;
+    uint32_t to;
+    uint32_t depart_time;
+    int32_t order_alt;      /* -1 表示标准格式订单号 */
+    int32_t serial;
+    int32_t day;            /* train_date_to_day */
+    int32_t price_cents;
+    int32_t seat_index;
+    uint8_t seat_class;
+    uint8_t from_stop_idx;
+    uint8_t to_stop_idx;
+    uint8_t canceled;
+} BookingRec;
+
+typedef struct {
+    BookingRec *data;
     int size;
     int capacity;
 } BookingList;
@@ -33,19 +59,94 @@ typedef struct {
 void bookinglist_init(BookingList *L);
 void bookinglist_free(BookingList *L);
 
+/* 返回 0 成功，-1 乘客不存在，-2 余票不足，ERR_BAD_FIELD 车次/站名/日期含 '|' 或换行；
+   ERR_NOT_DURABLE 表示订单已生效（订单号照常写出）但日志写盘失败 */
 int booking_create(BookingList *BL, TrainList *TL, PassengerList *PL,
                    const char *date, const char *train_id,
                    const char *from, const char *to,
                    const char *passenger_id, int seat_class, char *out_order_id, size_t order_len);
 
+/* 团体订票：n 人同一区间一次分配（优先连号），全部成功或全部不订；
+   返回 0 成功，-1 乘客不存在，-2 余票不足，-3 人数无效，ERR_BAD_FIELD 同 booking_create，ERR_NOT_DURABLE 已订但日志写盘失败 */
+int booking_create_group(BookingList *BL, TrainList *TL, PassengerList *PL,
+                         const char *date, const char *train_id,
+                         const char *from, const char *to,
+                         const char *const *passenger_ids, int n, int seat_class,
+                         char (*out_order_ids)[ORDER_ID_LEN]);
+
+/* 返回 0 成功，-1 订单不存在，-2 已退票，-3 释放座位失败，ERR_NOT_DURABLE 已退但日志写盘失败 */
 int booking_cancel(BookingList *BL, const char *order_id, TrainList *TL);
 
+/* 重放一条 B/C 日志记录（见 wal.h），不再记日志；返回 1 已应用，0 无需应用，-1 格式无效，
+   2 已应用但座位无法占用（已被占用、区间无效或日期不在售票窗口内），订单按未分配座位（seat_index 为 -1）记入 */
+int booking_replay(BookingList *BL, TrainList *TL, const char *rec);
+
 int booking_find_index(BookingList *BL, const char *order_id);
 
+/* 在读锁下把第 idx 个订单展开到 out；下标无效返回 -1 */
+int booking_get(BookingList *BL, int idx, Booking *out);
+
+/* 订单存储（紧凑记录数组 + 字符串驻留池）占用的堆内存字节数，不含各索引 */
+size_t booking_storage_bytes(BookingList *BL);
+
+/* 订单二级索引列表所在内存池的分配统计 */
+void booking_alloc_stats(ArenaStats *out);
+
+/*
+ * 订单统计：在列式副本（票价/等级/日期/车次/站段/退票位图各一列）上扫描，不展开订单。
+ * group_by 为 BOOKING_BY_* 的按位组合，0 表示只求一行合计；filter 选择统计哪些订单。
+ * 结果按 车次号、日期、等级 升序写入 out，最多 max 行，返回分组总数（不分组时恒为 1）；
+ * 参数无效返回 -1。只出现计数非零的分组。
+ */
+#define BOOKING_BY_TRAIN 1
+#define BOOKING_BY_DATE  2
+#define BOOKING_BY_CLASS 4
+
+#define BOOKING_AGG_ALL      0
+#define BOOKING_AGG_ACTIVE   1  /* 未退票 */
+#define BOOKING_AGG_CANCELED 2  /* 已退票 */
+
+typedef struct {
+    char train_id[ID_LEN];   /* 未按车次分组时为空串 */
+    char date[DATE_LEN];     /* 未按日期分组时为空串 */
+    int seat_class;          /* 未按等级分组时为 -1 */
+    long long count;
+    long long revenue_cents;
+    long long segments;      /* 各订单乘坐站段数之和（座·段），即占用的座位区段量 */
+} BookingAggRow;
+
+int booking_aggregate(BookingList *BL, int group_by, int filter, BookingAggRow *out, int max);
+
+/* 订单号格式为 "日期-车次号-序号"（序号至少 4 位，按车次+日期从 1 递增），
+   不查表即可拆回所属车次与日期；格式无效或缓冲区不足返回 -1 */
+int booking_decode_order_id(const char *order_id, char *date, size_t date_len,
+                            char *train_id, size_t train_len, int *serial);
+
+/* 二级索引查询：把匹配的订单（含已退票）按下单顺序复制到 out，最多 max 个，
+   返回匹配总数（可能大于 max，可先以 out=NULL、max=0 取总数）。
+   passenger 既按证件号也按姓名匹配 */
+int booking_find_by_passenger(BookingList *BL, const char *passenger, Booking *out, int max);
+int booking_find_by_train_date(BookingList *BL, const char *train_id, const char *date, Booking *out, int max);
+
 void booking_list_all(BookingList *L);
 
 
+/* 先写 <filename>.tmp，fsync 后改名替换；失败时原文件不变 */
 int save_bookings(const char *filename, BookingList *L);
+/* 格式错误时在 stderr 打印出错的行、列与字段并返回 0，此前的记录已载入。
+   有效订单的座位无法占用（已被别的订单占用、区间无效，或日历槽被另一个未过期日期占着）时，订单按未分配座位
+   （seat_index 为 -1）载入，在 stderr 列出订单号，全部读完后同样返回 0；已归档日期的订单不占座，不算失败 */
 int load_bookings(const char *filename, BookingList *L, TrainList *TL);
 
+/* 同 load_bookings，但文件按块分给 threads 个线程并行解析，并按车次/日期分组并行重放占座；
+   threads <= 0 时取 CPU 核数。订单按文件顺序写入，结果与 load_bookings 相同 */
+int load_bookings_parallel(const char *filename, BookingList *L, TrainList *TL, int threads);
+
+/* 日志之外的修改计数：清空、载入文本以及日志未打开时的订票/退票都会使其增加（重放不计） */
+long long booking_version(void);
+
+/* 订单记录、驻留池与各索引原样写入快照 / 载入（L 应为空表，座位占用随车次快照恢复），数据无效返回 -1 */
+void booking_snapshot_save(BookingList *L, SnapWriter *w);
+int booking_snapshot_load(BookingList *L, SnapReader *r);
+
 #endif /* BOOKING_H */
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef HASH_H
 #define HASH_H
 
+#include <stddef.h>
+#include "snapio.h"
 
 typedef struct HashTable HashTable;
 
@@ -9,5 +11,20 @@ void ht_free(HashTable *ht);
 void ht_clear(HashTable *ht);
 void ht_insert(HashTable *ht, const char *key, int idx);
 int ht_find(HashTable *ht, const char *key);
+/* 键存在时改写其下标，返回 0；不存在返回 -1 */
+int ht_update(HashTable *ht, const char *key, int idx);
+/* 删除键，返回 0；不存在返回 -1 */
+int ht_remove(HashTable *ht, const char *key);
+/* 预留至少容纳 n 个键的容量，避免批量插入时反复扩容 */
+void ht_reserve(HashTable *ht, int n);
+int ht_count(HashTable *ht);
+/* 表本身占用的堆内存字节数（槽位 + 键 arena） */
+size_t ht_bytes(HashTable *ht);
+
+/* 槽位与键 arena 原样写入快照 / 从快照整块替换 ht 的内容，不重新计算哈希；数据无效返回 -1 */
+void ht_snapshot_save(HashTable *ht, SnapWriter *w);
+int ht_snapshot_load(HashTable *ht, SnapReader *r);
+/* 所有键的下标都落在 [0, n) 内返回 0，否则 -1；快照载入后用它确认下标不越出所指的数组 */
+int ht_check_index(HashTable *ht, int n);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include "snapio.h"
+
+/*
+ * 字符串驻留池：相同的字符串只存一份，以从 0 递增的整数编号代表。
+ * strpool_get 返回的指针在下一次 strpool_intern 之前有效（池扩容会搬动存储）。
+ * 不加锁，由调用方与其所属数据一起保护。
+ */
+
+typedef struct StrPool StrPool;
+
+StrPool *strpool_create(void);
+void strpool_free(StrPool *p);
+void strpool_clear(StrPool *p);
+
+/* 返回 s 的编号，不存在则加入 */
+int strpool_intern(StrPool *p, const char *s);
+/* 只查不加，不存在返回 -1 */
+int strpool_find(StrPool *p, const char *s);
+/* 编号无效返回 "" */
+const char *strpool_get(StrPool *p, int id);
+
+int strpool_count(StrPool *p);
+/* 池本身占用的堆内存字节数（含索引） */
+size_t strpool_bytes(StrPool *p);
+
+/* 字符串、偏移表与索引原样写入快照 / 从快照整块替换池的内容；数据无效返回 -1 */
+void strpool_snapshot_save(StrPool *p, SnapWriter *w);
+int strpool_snapshot_load(StrPool *p, SnapReader *r);
+
+#endif /* INTERN_H */
@@ -1,6 +1,8 @@
 #ifndef PASSENGER_H
 #define PASSENGER_H
 
+#include "snapio.h"
+
 #define NAME_LEN 64
 #define ID_LEN 40
 
@@ -19,18 +21,38 @@ typedef struct {
     int capacity;
 } PassengerList;
 
+/* 增删改、订票、退票已在内存中生效，但预写日志写盘失败、重启后会丢失时的返回值（见 wal.h） */
+#define ERR_NOT_DURABLE (-9)
+/* 文本字段含 '|' 或换行，无法写入日志与文本文件时的返回值，不做任何修改 */
+#define ERR_BAD_FIELD (-8)
+
 void passengerlist_init(PassengerList *L);
 void passengerlist_free(PassengerList *L);
 
+/* 成功返回 0；delete/update 找不到证件号返回 -1；add/update 字段含 '|' 或换行返回 ERR_BAD_FIELD；
+   日志写盘失败返回 ERR_NOT_DURABLE */
 int passenger_add(PassengerList *L, Passenger *p);
 int passenger_delete(PassengerList *L, const char *id_num);
 int passenger_update(PassengerList *L, const char *id_num, Passenger *pnew);
 
+/* 重放一条 P/U/D 日志记录（见 wal.h），不再记日志；返回 1 已应用，0 无需应用，-1 格式无效 */
+int passenger_replay(PassengerList *L, const char *rec);
+
 int passenger_find_index(PassengerList *L, const char *id_num);
+/* 在读锁下把乘客信息拷贝到 out；不存在返回 -1 */
+int passenger_copy(PassengerList *L, const char *id_num, Passenger *out);
 
 void passenger_list_all(PassengerList *L);
 
+/* 先写 <filename>.tmp，fsync 后改名替换；失败时原文件不变 */
 int save_passengers(const char *filename, PassengerList *L);
 int load_passengers(const char *filename, PassengerList *L);
 
+/* 日志之外的修改计数：清空、载入文本以及日志未打开时的增删改都会使其增加（重放不计） */
+long long passenger_version(void);
+
+/* 乘客数组与证件号索引原样写入快照 / 载入（L 应为空表），数据无效返回 -1 */
+void passenger_snapshot_save(PassengerList *L, SnapWriter *w);
+int passenger_snapshot_load(PassengerList *L, SnapReader *r);
+
 #endif 
\ No newline at end of file
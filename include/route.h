@@ -0,0 +1,49 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include "train.h"
+
+/*
+ * 换乘查询：由车次表预先建立时刻表快照（站点编号 + 按发车时间排序的相邻站连接），
+ * 以连接扫描（Connection Scan）求最早到达，最多换乘 ROUTE_MAX_LEGS-1 次。
+ * 车次视为每日开行，快照覆盖查询当天与次日，可跨夜换乘。
+ * 快照与车次表无关联，车次表变动后需重新 route_build；route_build 期间不能有其它线程增删改车次。
+ */
+
+#define ROUTE_MAX_LEGS 3
+
+typedef struct Router Router;
+
+typedef struct {
+	char train_id[ID_LEN];
+	char from[STATION_LEN];
+	char to[STATION_LEN];
+	int from_idx, to_idx;     /* 在该车次停靠站中的下标 */
+	int depart_min;           /* 自查询当天 00:00 起的分钟数，次日的车次大于 1440 */
+	int arrive_min;
+} RouteLeg;
+
+typedef struct {
+	int legs;                 /* 乘坐的车次数，换乘次数为 legs-1 */
+	int arrive_min;
+	RouteLeg leg[ROUTE_MAX_LEGS];
+} RoutePlan;
+
+Router *route_build(TrainList *TL);
+void route_free(Router *r);
+
+int route_station_count(Router *r);
+int route_connection_count(Router *r);
+
+/*
+ * 从 from 出发（不早于 depart_after，"HH:MM"）到 to 的最早到达方案，同一到达时间取换乘少的；
+ * 换乘至少留 min_transfer 分钟，最多换乘 max_transfers 次（0..ROUTE_MAX_LEGS-1）。
+ * 找到返回 0 并填写 out；不可达返回 -1；参数无效返回 -2。可多线程同时查询同一快照。
+ */
+int route_earliest(Router *r, const char *from, const char *to, const char *depart_after,
+		   int min_transfer, int max_transfers, RoutePlan *out);
+
+/* "HH:MM" -> 分钟数，格式无效返回 -1 */
+int route_parse_time(const char *hhmm);
+
+#endif /* ROUTE_H */
@@ -0,0 +1,56 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/*
+ * 文本记录扫描器：直接在一整块只读文本（map_file 的映射或读入的缓冲）上逐行、逐个 '|' 取字段，
+ * 不复制行、不写回分隔符，可重入（状态都在 Scanner 里），多个线程可各自扫描同一缓冲的不同部分。
+ * 整数与 "123.45" 形式的小数走快速路径，其它写法的数字交给 strtod。
+ * 出错时记下第一个错误的行号、列号（字节，从 1 开始）与字段序号，之后的调用都返回 -1，
+ * 调用方逐字段读取后检查一次即可，失败时用 scan_report 打印位置。
+ */
+
+typedef struct {
+	const char *p;
+	size_t len;
+} ScanField;
+
+typedef struct {
+	const char *cur, *end;	/* 尚未读到的部分 */
+	const char *line, *eol;	/* 当前行 [line, eol)，不含 \r\n */
+	const char *fp;		/* 行内下一个字段的起点，NULL 表示本行字段已取完 */
+	long lineno;		/* 当前行号 */
+	int field;		/* 本行已取出的字段数 */
+	const char *err;	/* 第一个错误的描述，NULL 表示没有错误 */
+	long err_line;
+	int err_col;
+	int err_field;		/* 出错的字段序号，从 1 开始；0 表示不在某个字段上 */
+} Scanner;
+
+/* 扫描 [buf, buf + len)；first_line 为 buf 第一行的行号（用于报错） */
+void scan_init(Scanner *s, const char *buf, size_t len, long first_line);
+
+/* 前进到下一行；没有更多行时记下“文件提前结束”并返回 0 */
+int scan_line(Scanner *s);
+
+/* 取当前行的下一个字段（可为空）；本行字段已取完时记错返回 -1 */
+int scan_field(Scanner *s, ScanField *f);
+
+/* 下一个字段复制进定长数组 dst（超长截断并补 '\0'） */
+int scan_str(Scanner *s, char *dst, size_t cap);
+
+/* 下一个字段解析为十进制整数 / 小数；空字段、多余字符或溢出记错返回 -1 */
+int scan_int(Scanner *s, int *out);
+int scan_double(Scanner *s, double *out);
+
+/* 记下一个错误（仅保留第一个），at 为出错位置（NULL 表示行首），总是返回 -1 */
+int scan_fail(Scanner *s, const char *at, const char *msg);
+
+/* 打印 "<name>:<行>:<列>: 字段 <n>: <描述>" 到 stderr */
+void scan_report(const Scanner *s, const char *name);
+
+/* s 能否原样写成 '|' 分隔文本记录（文本文件与日志）的一个字段：不含 '|'、'\r'、'\n' 时返回 1 */
+int scan_field_ok(const char *s);
+
+#endif /* SCAN_H */
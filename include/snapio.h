@@ -0,0 +1,60 @@
+#ifndef SNAPIO_H
+#define SNAPIO_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 二进制快照的读写游标（格式见 snapshot.h）。每段数据按 8 字节对齐写出，
+ * 读取时直接返回映射内存中的指针，由调用方按原样 memcpy，不逐字段解析。
+ * 写出失败或读取越界时置 err，之后的读写都不再生效，调用方最后检查一次即可。
+ * SnapWriter 的 f 为 NULL 时写入内存缓冲 buf（按需扩容，off 即已写长度，由调用方 free）。
+ */
+
+typedef struct {
+	FILE *f;
+	uint64_t off;
+	int err;
+	unsigned char *buf;
+	size_t cap;
+} SnapWriter;
+
+typedef struct {
+	const unsigned char *p;
+	size_t len;
+	size_t off;
+	int err;
+} SnapReader;
+
+void snap_write(SnapWriter *w, const void *p, size_t n);
+void snap_put_u64(SnapWriter *w, uint64_t v);
+
+/* 返回接下来 n 字节的起始地址并前进；越界返回 NULL */
+const void *snap_read(SnapReader *r, size_t n);
+/* 越界返回 0 并置 err */
+uint64_t snap_get_u64(SnapReader *r);
+/* 读出一个计数并检查其不超过 max，否则置 err 返回 0 */
+size_t snap_get_count(SnapReader *r, size_t max);
+
+/* 只读映射整个文件（Windows: 文件映射；其它平台: mmap），快照载入与文本导入共用 */
+typedef struct {
+	const char *p;
+	size_t len;
+	void *file;	/* Windows 下的文件与映射句柄 */
+	void *map;
+} MappedFile;
+
+/* 文件不存在、为空或映射失败返回 -1 */
+int map_file(const char *filename, MappedFile *m);
+void unmap_file(MappedFile *m);
+
+/*
+ * 原子替换文件：file_replace_begin 以二进制方式打开 <path>.tmp（名字写入 tmp），
+ * file_replace_commit 在 ok 且写出成功时 fflush + fsync 后改名覆盖 path（POSIX 上再同步所在目录），
+ * 否则删除临时文件。总会关闭 f；成功返回 1，失败返回 0，崩溃或失败时 path 保持原样。
+ */
+FILE *file_replace_begin(const char *path, char *tmp, size_t tmplen);
+int file_replace_commit(FILE *f, const char *tmp, const char *path, int ok);
+
+#endif /* SNAPIO_H */
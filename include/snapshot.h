@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "booking.h"
+
+/*
+ * 二进制快照：车次（含 stops 与全部 seatmap 的原始位图）、乘客、订单（紧凑记录、驻留池与各索引）
+ * 按内存布局原样写入一个文件，载入时 mmap 整个文件，各段整块复制回内存，不解析文本、不逐条重放占座。
+ * 三个 txt 文件仍是导入/导出格式，快照不可用时退回文本载入。
+ *
+ * 文件 = 文件头 + 车次段 + 乘客段 + 订单段，每段以一个标记字开头，所有数据按 8 字节对齐。
+ * 文件头含魔数、版本号、字节序标记与各记录结构的大小，任一不符（换了平台或结构体）即拒绝载入。
+ * 写入先写 <filename>.tmp，文件头最后回填，fsync 后改名替换，崩溃时旧快照保持完整。
+ * 保存时不应有其它线程在订票/退票（座位与订单分属两把锁，并发时两者可能不一致）。
+ * save_snapshot / save_snapshot_incremental 会先等待进行中的后台保存结束。
+ */
+
+#define SNAPSHOT_VERSION 2
+
+/* 成功返回 1，失败返回 0 */
+int save_snapshot(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL);
+
+/*
+ * 增量保存（快照 + 追加日志，日志过长时压缩）：若上次保存/载入快照以来的修改都已写入预写日志
+ * （三张表的 *_version 未变、快照文件未被替换），且日志不超过 SNAPSHOT_LOG_MIN 字节或快照长度的
+ * 1/SNAPSHOT_LOG_RATIO，只把日志落盘即完成保存，耗时与修改量成正比；
+ * 否则（车次有改动、日志未打开、日志曾写盘失败、从文本导入后、日志过长）在检查点内重写整个快照并清空日志。
+ * 返回 SNAPSHOT_WRITTEN / SNAPSHOT_LOGGED，失败返回 0。
+ */
+#define SNAPSHOT_WRITTEN 1
+#define SNAPSHOT_LOGGED 2
+#define SNAPSHOT_LOG_MIN (1 << 20)
+#define SNAPSHOT_LOG_RATIO 32
+int save_snapshot_incremental(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL);
+
+/*
+ * 后台保存：日志已覆盖修改时同增量保存，只落盘日志返回 SNAPSHOT_LOGGED；否则在检查点内把三张表
+ * 序列化进内存（调用期间不能有订票/退票，得到的是这一刻的一致映像，耗时约为内存拷贝），
+ * 然后交给后台线程写 <filename>.tmp、fsync、改名并结束检查点，立即返回 SNAPSHOT_STARTED，
+ * 调用方随即可继续订票，新的修改进入检查点新开的日志。保存期间内存中多占一份快照大小的映像。
+ * 上一次后台保存未结束时返回 SNAPSHOT_BUSY，失败返回 0。
+ * 后台保存的启动、查询与等待都应在同一个线程（如服务器主循环）里调用。
+ */
+#define SNAPSHOT_STARTED 3
+#define SNAPSHOT_BUSY 4
+int save_snapshot_background(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL);
+
+/* 最近一次后台保存的状态 */
+#define SNAPSHOT_IDLE 0		/* 还没有后台保存过 */
+#define SNAPSHOT_RUNNING 1
+#define SNAPSHOT_DONE 2
+#define SNAPSHOT_FAILED 3
+
+typedef struct {
+	int state;
+	long long written;	/* 已写出的字节数 */
+	long long total;	/* 映像的字节数 */
+	double capture_ms;	/* 生成映像的耗时（调用方被阻塞的时间） */
+	double write_ms;	/* 后台写出至今（或共计）的耗时 */
+} SnapshotStatus;
+
+void snapshot_status(SnapshotStatus *out);
+
+/* 等待进行中的后台保存结束；返回最近一次后台保存是否成功（没有过后台保存时返回 1） */
+int snapshot_wait(void);
+
+/* 三张表应为空表；文件不存在、格式不符或数据无效返回 0，此时三张表被清空（重新 init） */
+int load_snapshot(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL);
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,106 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+
+/*
+ * 线程同步的薄封装（Windows: SRWLOCK / CRITICAL_SECTION / 线程句柄；其它平台: pthread）。
+ * 锁与线程为不透明类型，头文件只引入 stdint.h；原子操作与自旋锁为内联函数，可直接嵌入结构体。
+ */
+
+typedef struct SyncRWLock SyncRWLock;
+typedef struct SyncMutex SyncMutex;
+typedef struct SyncCond SyncCond;
+typedef struct SyncThread SyncThread;
+
+SyncRWLock *sync_rwlock_create(void);
+void sync_rwlock_free(SyncRWLock *l);
+void sync_rwlock_rdlock(SyncRWLock *l);
+void sync_rwlock_rdunlock(SyncRWLock *l);
+void sync_rwlock_wrlock(SyncRWLock *l);
+void sync_rwlock_wrunlock(SyncRWLock *l);
+
+SyncMutex *sync_mutex_create(void);
+void sync_mutex_free(SyncMutex *m);
+void sync_mutex_lock(SyncMutex *m);
+void sync_mutex_unlock(SyncMutex *m);
+
+/* 条件变量，与 SyncMutex 配合使用；wait 返回后需重新检查条件 */
+SyncCond *sync_cond_create(void);
+void sync_cond_free(SyncCond *c);
+void sync_cond_wait(SyncCond *c, SyncMutex *m);
+void sync_cond_broadcast(SyncCond *c);
+
+SyncThread *sync_thread_start(void *(*fn)(void *), void *arg);
+void *sync_thread_join(SyncThread *t);
+
+int sync_cpu_count(void);
+void sync_yield(void);
+/* 单调时钟（秒），用于测量多线程墙钟时间 */
+double sync_now(void);
+
+/* 原子操作 */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static __inline int sync_cas_u64(volatile uint64_t *p, uint64_t *expected, uint64_t desired)
+{
+	uint64_t old = (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)p, (__int64)desired, (__int64)*expected);
+	if (old == *expected)
+		return 1;
+	*expected = old;
+	return 0;
+}
+static __inline uint64_t sync_load_u64(volatile uint64_t *p) { return (uint64_t)_InterlockedOr64((volatile __int64 *)p, 0); }
+static __inline uint64_t sync_or_u64(volatile uint64_t *p, uint64_t v) { return (uint64_t)_InterlockedOr64((volatile __int64 *)p, (__int64)v); }
+static __inline uint64_t sync_and_u64(volatile uint64_t *p, uint64_t v) { return (uint64_t)_InterlockedAnd64((volatile __int64 *)p, (__int64)v); }
+static __inline int sync_fetch_add(volatile int *p, int v) { return (int)_InterlockedExchangeAdd((volatile long *)p, v); }
+static __inline int64_t sync_fetch_add64(volatile int64_t *p, int64_t v) { return (int64_t)_InterlockedExchangeAdd64((volatile __int64 *)p, v); }
+static __inline int sync_load(volatile int *p) { return (int)_InterlockedOr((volatile long *)p, 0); }
+static __inline void sync_store(volatile int *p, int v) { _InterlockedExchange((volatile long *)p, v); }
+static __inline void *sync_load_ptr(void *volatile *p) { return _InterlockedCompareExchangePointer(p, NULL, NULL); }
+static __inline int sync_cas_ptr(void *volatile *p, void *expected, void *desired) { return _InterlockedCompareExchangePointer(p, desired, expected) == expected; }
+static __inline int sync_test_and_set(volatile int *p) { return (int)_InterlockedExchange((volatile long *)p, 1); }
+static __inline void sync_fence(void) { volatile long x = 0; _InterlockedOr(&x, 0); }
+#else
+static inline int sync_cas_u64(volatile uint64_t *p, uint64_t *expected, uint64_t desired)
+{
+	return __atomic_compare_exchange_n(p, expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static inline uint64_t sync_load_u64(volatile uint64_t *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline uint64_t sync_or_u64(volatile uint64_t *p, uint64_t v) { return __atomic_fetch_or(p, v, __ATOMIC_ACQ_REL); }
+static inline uint64_t sync_and_u64(volatile uint64_t *p, uint64_t v) { return __atomic_fetch_and(p, v, __ATOMIC_ACQ_REL); }
+static inline int sync_fetch_add(volatile int *p, int v) { return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL); }
+static inline int64_t sync_fetch_add64(volatile int64_t *p, int64_t v) { return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL); }
+static inline int sync_load(volatile int *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void sync_store(volatile int *p, int v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline void *sync_load_ptr(void *volatile *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline int sync_cas_ptr(void *volatile *p, void *expected, void *desired)
+{
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static inline int sync_test_and_set(volatile int *p) { return __atomic_exchange_n(p, 1, __ATOMIC_ACQUIRE); }
+static inline void sync_fence(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#endif
+
+/* 自旋锁：只用于极短的临界区（单个车次/日期的座位操作），可直接嵌入结构体，0 为未加锁 */
+typedef volatile int SyncSpin;
+
+static inline void sync_spin_lock(SyncSpin *s)
+{
+	int spins = 0;
+	while (sync_test_and_set(s)) {
+		while (sync_load(s)) {
+			if (++spins > 64) {
+				sync_yield();
+				spins = 0;
+			}
+		}
+	}
+}
+
+static inline void sync_spin_unlock(SyncSpin *s)
+{
+	sync_store(s, 0);
+}
+
+#endif
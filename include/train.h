@@ -1,12 +1,29 @@
 #ifndef TRAIN_H
 #define TRAIN_H
 
+#include <stddef.h>
 #include "hash.h"
+#include "arena.h"
 
 #define STATION_LEN 64
 #define TIME_LEN 8
 #define DATE_LEN 12
 #define ID_LEN 40
+/* 座位按站段占用以 64 位字表示，故最多 64 段（65 站） */
+#define MAX_STOPS 65
+/* 每趟车保留的 seatmap 日历窗口（天），按日序号取模定位；槽位上的日期已过（早于今天）时，
+   之后映射到该槽位的日期首次售票即淘汰它；两个未来日期争用同一槽位时后来的日期不可售 */
+#define SEATMAP_WINDOW_DAYS 32
+
+/* 座位占用字按块懒分配，每块的座位数（约一节车厢） */
+#define SEATMAP_CHUNK_SEATS 64
+
+/* 座位分配策略：首个空闲座位 / 空闲区间最贴合所需区间的座位（减少碎片） /
+   首个空闲座位但不加车次日期锁，以 CAS 抢占座位占用字（热门车次放票时使用）；
+   策略应在开始订票前设置，不要在其它线程订票时切换 */
+#define ALLOC_FIRST_FIT 0
+#define ALLOC_BEST_FIT 1
+#define ALLOC_LOCK_FREE 2
 
 typedef struct {
     char name[STATION_LEN];
@@ -49,27 +66,108 @@ int train_delete(TrainList *L, const char *train_id);
 int train_update(TrainList *L, const char *train_id, Train *newt);
 
 int train_find_index(TrainList *L, const char *train_id);
+/* train_get 返回的指针在其它线程增删车次后失效；并发场景下请用 train_fare_info 等按值接口 */
 Train *train_get(TrainList *L, int idx);
 
+/* 在读锁下取出发车时间与 seat_class 的票价；车次不存在返回 -1 */
+int train_fare_info(TrainList *L, const char *train_id, int seat_class,
+                    char *depart_time, size_t depart_len, double *price);
+
 void train_list_all(TrainList *L);
 
 
+void train_set_alloc_policy(int policy);
+int train_get_alloc_policy(void);
+
 int train_allocate_seat(TrainList *TL, const char *train_id, const char *date,
                         const char *from, const char *to, int seat_class,
                         int *out_seat_index, int *out_from_idx, int *out_to_idx);
 
+/* 为 n 人在同一区间分配座位，优先连号；全部成功返回 0 并写出 n 个座位号，否则不占用任何座位返回 -1 */
+int train_allocate_seats(TrainList *TL, const char *train_id, const char *date,
+                         const char *from, const char *to, int seat_class, int n,
+                         int *out_seat_indexes, int *out_from_idx, int *out_to_idx);
+
 
 int train_release_seat(TrainList *TL, const char *train_id, const char *date,
                        int seat_class, int seat_index, int from_idx, int to_idx);
 
 
+/* 占用指定座位（载入与重放订单时用）；成功返回 0，座位已被占用、参数无效或槽位被另一个未过期日期占用返回 -1，
+   日期已归档（早于淘汰截止日，或已过且槽位已让给之后的日期）返回 -2 */
 int train_mark_seat(TrainList *TL, const char *train_id, const char *date,
                     int seat_class, int seat_index, int from_idx, int to_idx);
 
 
+/* from->to 全程空闲的座位数（由 seatmap 内的余票摘要回答，O(log^2 段数)）；尚未售票的日期为满座数；
+   参数无效、日期已被淘汰或不在日历窗口内返回 -1 */
+int train_remaining_seats(TrainList *TL, const char *train_id, const char *date,
+                          const char *from, const char *to, int seat_class);
+
+/* 某车次某日某等级所有区间的余票矩阵，out 至少 stop_count*stop_count 个 int，
+   out[i*stop_count+j] 为第 i 站到第 j 站（i<j）的余票，其余为 0；成功返回 0 */
+int train_availability_matrix(TrainList *TL, const char *train_id, const char *date,
+                              int seat_class, int *out);
+
+/* 同上，但复用上次结果，直到该车次该日有座位被分配/释放 */
+int train_availability_matrix_cached(TrainList *TL, const char *train_id, const char *date,
+                                     int seat_class, int *out);
+
+/* seatmap 内存统计（所有车次）：尚无售出的日期/等级不占座位存储 */
+typedef struct {
+    long long bytes;   /* 日历环与座位存储实际占用的堆内存字节数 */
+    int dates;         /* 已登记的车次-日期数 */
+    int classes;       /* 已分配存储的车次-日期-等级数 */
+    int chunks;        /* 已分配的座位块数（每块 SEATMAP_CHUNK_SEATS 座） */
+} SeatmapMemStats;
+
+void train_seatmap_mem_stats(SeatmapMemStats *out);
+
+/* 车次模块内存池（stops、站点索引、seatmap）的分配统计，两个池合计 */
+void train_alloc_stats(ArenaStats *out);
+
+/* 释放所有早于 date 的 seatmap，返回释放个数；此后早于 date 的日期不再售票、查询返回 -1（直到 trainlist_init）；
+   日期无效返回 -1 */
+int train_evict_before(TrainList *TL, const char *date);
+/* 以本地日期为 date 调用 train_evict_before：归档今天以前的日期，启动与载入数据后调用 */
+int train_evict_past(TrainList *TL);
+/* 本地日期的日序号 */
+int train_today(void);
+
+/* "YYYY-MM-DD" 与日序号（自 1970-01-01 起的天数）互转；格式或日期无效返回 -1 */
+int train_date_to_day(const char *date);
+void train_day_to_date(int day, char *out, size_t outlen);
+
+
 int train_find_stop_idx(Train *t, const char *station);
 
+/* 起止站查询结果：from 站在 to 站之前的一趟车 */
+typedef struct {
+    char train_id[ID_LEN];
+    int from_idx, to_idx;
+    char depart[TIME_LEN];   /* from 站发车时间 */
+    char arrive[TIME_LEN];   /* to 站到达时间 */
+    int running;
+    int remaining[4];        /* date 给定时为当日 from->to 各等级余票，否则（或该日已淘汰、不在窗口内）为 -1 */
+} TrainMatch;
+
+/* 经由站点倒排索引找出先经停 from、后经停 to 的车次，按车次表顺序写入 out（最多 max 个），
+   返回匹配总数；date 可为 NULL，日期无效返回 -1 */
+int train_find_between(TrainList *TL, const char *from, const char *to, const char *date,
+                       TrainMatch *out, int max);
+
+/* 先写 <filename>.tmp，fsync 后改名替换；失败时原文件不变 */
 int save_trains(const char *filename, TrainList *L);
+/* 格式错误或某趟车停靠站超过 MAX_STOPS 时返回 0，并在 stderr 报告车次与行列；之前读入的车次保留 */
 int load_trains(const char *filename, TrainList *L);
 
+/* 车次表的修改计数：增删改车次、载入与清空时增加（座位占用不计，随订单日志恢复），
+   增量保存据此判断快照里的车次是否过期 */
+long long train_version(void);
+
+/* 淘汰截止日、车次、stops 与全部 seatmap（占用字、段位图、余票摘要）原样写入快照，见 snapshot.h；
+   载入时 L 应为空表，数据无效返回 -1 */
+void train_snapshot_save(TrainList *L, SnapWriter *w);
+int train_snapshot_load(TrainList *L, SnapReader *r);
+
 #endif 
\ No newline at end of file
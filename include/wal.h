@@ -0,0 +1,60 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include "booking.h"
+
+/*
+ * 预写日志（WAL）：订票、退票与乘客增删改各追加一行记录，三个 txt 文件或 data.snap 视为快照，
+ * 启动时先载入快照再 wal_replay，即可恢复到最后一次落盘的操作。
+ *
+ * 行格式："<crc32，8 位十六进制> <类型>|<字段>\n"，类型：
+ *   B 订票（字段同 bookings.txt 一行）  C 退票（订单号）
+ *   P 新增乘客（字段同 passengers.txt）  U 修改乘客（原证件号|新字段）  D 删除乘客（证件号）
+ * 重放遇到不完整或校验失败的行即停止（宕机时写了一半的尾部），并把文件截到最后一个完好的行，
+ * 之后打开日志追加的记录不会排在残行后面。
+ *
+ * 组提交：wal_append 只把记录放进内存缓冲并返回序号（LSN），调用方释放业务锁后再 wal_commit；
+ * 第一个进入 wal_commit 的线程负责把缓冲一次写出并 fsync，期间到达的线程等待同一次或下一次落盘，
+ * 并发请求共用一次 fsync。写盘失败时打印错误并返回 -1，内存中的操作不回滚；
+ * 此后日志不再写出任何记录（文件尾可能是半行），提交一律返回 -1，
+ * 直到失败之后开始的一次检查点成功（或重新 wal_open）才恢复记日志。
+ *
+ * 保存快照时先 wal_checkpoint_begin（把当前日志改名为 <path>.old 并开新日志），
+ * 写完快照（或三个 txt）后 wal_checkpoint_end(1) 删除 .old；保存失败传 0 保留 .old，重放时先放 .old 再放新日志。
+ * 快照可能已包含新日志开头的操作，各类记录的重放都是幂等的（已有订单跳过、已退票跳过、乘客按证件号覆盖）。
+ */
+
+typedef struct {
+    long long records;   /* 追加的记录数 */
+    long long syncs;     /* fsync 次数；records / syncs 即平均每次落盘合并的记录数 */
+    long long bytes;     /* 写出的字节数 */
+    long long log_bytes; /* 日志（含 .old 与未写出的缓冲）当前的总长度，即下次启动要重放的字节数 */
+} WalStats;
+
+/* 以追加方式打开日志；已打开时先关闭。成功返回 0 */
+int wal_open(const char *path);
+/* 落盘尚未写出的记录后关闭 */
+void wal_close(void);
+int wal_is_open(void);
+
+/* 未打开日志时返回 0，调用方可照常调用 wal_commit(0) */
+long long wal_append(const char *rec);
+int wal_commit(long long lsn);
+/* 写出并 fsync 已追加的全部记录；未打开时返回 0，写盘失败返回 -1 */
+int wal_sync(void);
+
+/*
+ * 自上次成功的检查点以来有记录因写盘失败而未进入日志（重新 wal_open 也不清除）时返回 1：
+ * 此时快照加日志不等于内存状态，下次保存必须重写快照；失败之后开始的一次检查点成功后恢复为 0
+ */
+int wal_incomplete(void);
+
+int wal_checkpoint_begin(void);
+void wal_checkpoint_end(int snapshot_ok);
+
+/* 依次重放 <path>.old 与 path，返回应用的记录数；应在 wal_open 之前调用（也可在打开状态下重放，不会重复记日志） */
+int wal_replay(const char *path, TrainList *TL, PassengerList *PL, BookingList *BL);
+
+void wal_stats(WalStats *out);
+
+#endif /* WAL_H */
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ARENA_CHUNK_DEFAULT (256 * 1024)
+#define ARENA_ALIGN 16
+#define ARENA_SMALL_MAX (64 * 1024)
+#define ARENA_CLASSES 48	/* 16..256 共 16 级，256..64K 每个 2 的幂区间 4 级 */
+
+/* 系统内存块（大块或单独申请的大对象）串成双向链表，头部后即为数据区 */
+typedef struct Block {
+	struct Block *prev;
+	struct Block *next;
+	size_t size;
+	size_t pad;
+} Block;
+
+typedef struct FreeNode {
+	struct FreeNode *next;
+} FreeNode;
+
+struct Arena {
+	size_t chunk_size;
+	Block *blocks;
+	char *cur;		/* 当前大块中尚未切分的区域 */
+	char *end;
+	FreeNode *free_list[ARENA_CLASSES];
+	ArenaStats st;
+};
+
+/* n 所在的级别与该级对象大小；超过 ARENA_SMALL_MAX 返回 -1 */
+static int size_class(size_t n, size_t *csize)
+{
+	if (n == 0)
+		n = 1;
+	if (n > ARENA_SMALL_MAX)
+		return -1;
+
+	n = (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if (n <= 256) {
+		*csize = n;
+		return (int)(n / 16) - 1;
+	}
+
+	/* p < n <= 2p，步长 p/4 */
+	int k = 8;
+	while (((size_t)1 << (k + 1)) < n)
+		++k;
+	size_t step = ((size_t)1 << k) / 4;
+	size_t s = (n + step - 1) / step * step;
+	*csize = s;
+	return 16 + (k - 8) * 4 + (int)(s / step) - 5;
+}
+
+static Block *block_new(Arena *a, size_t size)
+{
+	Block *b = malloc(sizeof(Block) + size);
+	if (!b) {
+		perror("malloc");
+		exit(1);
+	}
+	b->size = size;
+	b->prev = NULL;
+	b->next = a->blocks;
+	if (a->blocks)
+		a->blocks->prev = b;
+	a->blocks = b;
+
+	a->st.sys_allocs++;
+	a->st.chunks++;
+	a->st.reserved += sizeof(Block) + size;
+	return b;
+}
+
+static void block_unlink(Arena *a, Block *b)
+{
+	if (b->prev)
+		b->prev->next = b->next;
+	else
+		a->blocks = b->next;
+	if (b->next)
+		b->next->prev = b->prev;
+
+	a->st.chunks--;
+	a->st.reserved -= sizeof(Block) + b->size;
+	free(b);
+}
+
+Arena *arena_create(size_t chunk_size)
+{
+	Arena *a = calloc(1, sizeof(Arena));
+	if (!a) {
+		perror("calloc");
+		return NULL;
+	}
+	a->chunk_size = chunk_size >= 2 * ARENA_SMALL_MAX ? chunk_size : ARENA_CHUNK_DEFAULT;
+	return a;
+}
+
+void arena_reset(Arena *a)
+{
+	if (!a)
+		return;
+
+	while (a->blocks)
+		block_unlink(a, a->blocks);
+	a->cur = a->end = NULL;
+	memset(a->free_list, 0, sizeof(a->free_list));
+	a->st.live = 0;
+}
+
+void arena_destroy(Arena *a)
+{
+	if (!a)
+		return;
+
+	arena_reset(a);
+	free(a);
+}
+
+void *arena_alloc(Arena *a, size_t n)
+{
+	size_t csize;
+	int c = size_class(n, &csize);
+
+	a->st.allocs++;
+	if (c < 0) {
+		Block *b = block_new(a, n);
+		a->st.live += n;
+		return b + 1;
+	}
+
+	a->st.live += csize;
+	FreeNode *f = a->free_list[c];
+	if (f) {
+		a->free_list[c] = f->next;
+		return f;
+	}
+
+	if ((size_t)(a->end - a->cur) < csize) {
+		Block *b = block_new(a, a->chunk_size);
+		a->cur = (char*)(b + 1);
+		a->end = a->cur + a->chunk_size;
+	}
+	void *p = a->cur;
+	a->cur += csize;
+	return p;
+}
+
+void *arena_calloc(Arena *a, size_t n)
+{
+	void *p = arena_alloc(a, n);
+	memset(p, 0, n);
+	return p;
+}
+
+void arena_release(Arena *a, void *p, size_t n)
+{
+	size_t csize;
+	int c;
+
+	if (!p)
+		return;
+
+	a->st.frees++;
+	c = size_class(n, &csize);
+	if (c < 0) {
+		a->st.live -= n;
+		block_unlink(a, (Block*)p - 1);
+		return;
+	}
+
+	a->st.live -= csize;
+	FreeNode *f = p;
+	f->next = a->free_list[c];
+	a->free_list[c] = f;
+}
+
+void *arena_realloc(Arena *a, void *p, size_t old_n, size_t n)
+{
+	size_t oc, nc;
+
+	if (!p)
+		return arena_alloc(a, n);
+
+	/* 同一级别内直接复用 */
+	int co = size_class(old_n, &oc), cn = size_class(n, &nc);
+	if (co >= 0 && co == cn)
+		return p;
+
+	void *q = arena_alloc(a, n);
+	memcpy(q, p, old_n < n ? old_n : n);
+	arena_release(a, p, old_n);
+	return q;
+}
+
+void arena_stats(Arena *a, ArenaStats *st)
+{
+	if (!a) {
+		memset(st, 0, sizeof(*st));
+		return;
+	}
+	*st = a->st;
+}
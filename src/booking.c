@@ -2,12 +2,71 @@
 #include <stdlib.h>
 #include <string.h>
 #include "booking.h"
+#include "arena.h"
 #include "hash.h"
+#include "intern.h"
+#include "scan.h"
+#include "sync.h"
+#include "wal.h"
 
+#define BOOKING_LINE_MAX 2048
 #define INITIAL_CAPACITY 8
 #define HASH_BUCKETS 1031
 
+/* booking_lock 保护订单数组与索引；锁顺序为 booking_lock -> 车次锁，分配座位时不持有 booking_lock */
 static HashTable *booking_ht = NULL;
+static SyncRWLock *booking_lock = NULL;
+/* 日志之外的修改计数：清空、载入文本，以及日志未打开时的订票/退票 */
+static volatile int64_t booking_version_seq = 0;
+
+/*
+ * 二级索引：键 -> 订单下标列表。订单只追加、从不删除（退票只置 canceled），
+ * 所以各列表按下标递增、只需在追加时登记。键分别为证件号、姓名、"车次|日期"
+ * （'|' 是存档文件的分隔符，不会出现在字段里）。
+ */
+typedef struct {
+	int *items;
+	int size;
+	int capacity;
+} IndexList;
+
+typedef struct {
+	HashTable *ht;		/* 键 -> lists 下标 */
+	IndexList *lists;
+	int size;
+	int capacity;
+} SecondaryIndex;
+
+static SecondaryIndex by_passenger_id;
+static SecondaryIndex by_passenger_name;
+static SecondaryIndex by_train_date;
+
+/* 各二级索引的下标列表（每个乘客、每个车次日期一张）取自同一内存池，bookinglist_init/free 整池归还 */
+static Arena *index_arena = NULL;
+
+/* 紧凑记录的字符串驻留池：text 存车次号、站名、发车时间与非标准订单号，people 存证件号与姓名 */
+static StrPool *text_pool = NULL;
+static StrPool *people_pool = NULL;
+
+/* 每个 "车次|日期" 已用到的最大订单序号；生成订单号 O(1)，载入时按已有订单号恢复 */
+static HashTable *seq_ht = NULL;
+static int *seq_vals = NULL;
+static int seq_count = 0;
+static int seq_capacity = 0;
+
+/*
+ * 列式副本：统计只读需要的几列，不必展开整条记录。与 data 同下标、同容量，
+ * 追加与退票时同步维护；canceled 为位图，第 i 位对应第 i 条订单。
+ */
+static struct {
+	int32_t *price_cents;
+	int32_t *day;
+	uint32_t *train_id;
+	uint8_t *seat_class;
+	uint8_t *from_stop;
+	uint8_t *to_stop;
+	uint64_t *canceled;
+} cols;
 
 static void *xmalloc(size_t n)
 {
@@ -24,14 +83,275 @@ static void *xmalloc(size_t n)
 	return p;
 }
 
+static void *xrealloc(void *p, size_t n)
+{
+	p = realloc(p, n);
+	if (!p) {
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+static void cols_free(void)
+{
+	free(cols.price_cents);
+	free(cols.day);
+	free(cols.train_id);
+	free(cols.seat_class);
+	free(cols.from_stop);
+	free(cols.to_stop);
+	free(cols.canceled);
+	memset(&cols, 0, sizeof(cols));
+}
+
+static void cols_resize(int old_cap, int cap)
+{
+	size_t ow = ((size_t)old_cap + 63) / 64, nw = ((size_t)cap + 63) / 64;
+
+	cols.price_cents = xrealloc(cols.price_cents, sizeof(int32_t) * cap);
+	cols.day = xrealloc(cols.day, sizeof(int32_t) * cap);
+	cols.train_id = xrealloc(cols.train_id, sizeof(uint32_t) * cap);
+	cols.seat_class = xrealloc(cols.seat_class, cap);
+	cols.from_stop = xrealloc(cols.from_stop, cap);
+	cols.to_stop = xrealloc(cols.to_stop, cap);
+	cols.canceled = xrealloc(cols.canceled, sizeof(uint64_t) * nw);
+	if (nw > ow)
+		memset(cols.canceled + ow, 0, sizeof(uint64_t) * (nw - ow));
+}
+
+static void cols_store(int idx, const BookingRec *r)
+{
+	uint64_t bit = (uint64_t)1 << (idx & 63);
+
+	cols.price_cents[idx] = r->price_cents;
+	cols.day[idx] = r->day;
+	cols.train_id[idx] = r->train_id;
+	cols.seat_class[idx] = r->seat_class;
+	cols.from_stop[idx] = r->from_stop_idx;
+	cols.to_stop[idx] = r->to_stop_idx;
+	if (r->canceled)
+		cols.canceled[idx >> 6] |= bit;
+	else
+		cols.canceled[idx >> 6] &= ~bit;
+}
+
+static void sindex_clear(SecondaryIndex *si)
+{
+	if (!si->ht)
+		si->ht = ht_create(HASH_BUCKETS);
+	else
+		ht_clear(si->ht);
+	si->size = 0;
+}
+
+static void sindex_free(SecondaryIndex *si)
+{
+	ht_free(si->ht);
+	free(si->lists);
+	memset(si, 0, sizeof(*si));
+}
+
+static void sindex_add(SecondaryIndex *si, const char *key, int idx)
+{
+	int li = ht_find(si->ht, key);
+
+	if (li == -1) {
+		if (si->size >= si->capacity) {
+			si->capacity = si->capacity ? si->capacity * 2 : INITIAL_CAPACITY;
+			si->lists = realloc(si->lists, sizeof(IndexList) * si->capacity);
+			if (!si->lists) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		li = si->size++;
+		memset(&si->lists[li], 0, sizeof(IndexList));
+		ht_insert(si->ht, key, li);
+	}
+
+	IndexList *l = &si->lists[li];
+	if (l->size >= l->capacity) {
+		int old = l->capacity;
+		l->capacity = l->capacity ? l->capacity * 2 : 4;
+		l->items = arena_realloc(index_arena, l->items, sizeof(int) * old, sizeof(int) * l->capacity);
+	}
+	l->items[l->size++] = idx;
+}
+
+static const IndexList *sindex_get(SecondaryIndex *si, const char *key)
+{
+	int li = si->ht ? ht_find(si->ht, key) : -1;
+	return li == -1 ? NULL : &si->lists[li];
+}
+
+static void train_date_key(char *out, size_t outlen, const char *train_id, const char *date)
+{
+	snprintf(out, outlen, "%s|%s", train_id, date);
+}
+
+static int *seq_slot(const char *train_id, const char *date)
+{
+	char key[ID_LEN + DATE_LEN + 1];
+	train_date_key(key, sizeof(key), train_id, date);
+
+	int i = ht_find(seq_ht, key);
+	if (i == -1) {
+		if (seq_count >= seq_capacity) {
+			seq_capacity = seq_capacity ? seq_capacity * 2 : INITIAL_CAPACITY;
+			seq_vals = realloc(seq_vals, sizeof(int) * seq_capacity);
+			if (!seq_vals) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		i = seq_count++;
+		seq_vals[i] = 0;
+		ht_insert(seq_ht, key, i);
+	}
+
+	return &seq_vals[i];
+}
+
+/* 载入的订单推进其车次/日期的序号；订单号不是本车次本日期的格式时按一单计 */
+static void seq_restore(const Booking *b)
+{
+	char date[DATE_LEN], train_id[ID_LEN];
+	int serial;
+	int *seq = seq_slot(b->train_id, b->date);
+
+	if (booking_decode_order_id(b->order_id, date, sizeof(date), train_id, sizeof(train_id), &serial) == 0 &&
+	    strcmp(date, b->date) == 0 && strcmp(train_id, b->train_id) == 0) {
+		if (serial > *seq)
+			*seq = serial;
+	} else {
+		(*seq)++;
+	}
+}
+
+static void bookinglist_expand(BookingList *L);
+
+static void rec_order_id(const BookingRec *r, char *out, size_t outlen)
+{
+	char date[DATE_LEN];
+
+	if (r->order_alt >= 0) {
+		snprintf(out, outlen, "%s", strpool_get(text_pool, r->order_alt));
+		return;
+	}
+	train_day_to_date(r->day, date, sizeof(date));
+	snprintf(out, outlen, "%s-%s-%04d", date, strpool_get(text_pool, r->train_id), r->serial);
+}
+
+/* 写锁下把展开的订单压成紧凑记录；b->date 必须是有效日期 */
+static void rec_pack(BookingRec *r, const Booking *b)
+{
+	char date[DATE_LEN], train_id[ID_LEN], regen[ORDER_ID_LEN];
+	int serial;
+
+	r->passenger_id = (uint32_t)strpool_intern(people_pool, b->passenger_id);
+	r->passenger_name = (uint32_t)strpool_intern(people_pool, b->passenger_name);
+	r->train_id = (uint32_t)strpool_intern(text_pool, b->train_id);
+	r->from = (uint32_t)strpool_intern(text_pool, b->from);
+	r->to = (uint32_t)strpool_intern(text_pool, b->to);
+	r->depart_time = (uint32_t)strpool_intern(text_pool, b->depart_time);
+	r->day = train_date_to_day(b->date);
+	r->price_cents = (int32_t)(b->price * 100.0 + (b->price < 0 ? -0.5 : 0.5));
+	r->seat_index = b->seat_index;
+	r->seat_class = (uint8_t)b->seat_class;
+	r->from_stop_idx = (uint8_t)b->from_stop_idx;
+	r->to_stop_idx = (uint8_t)b->to_stop_idx;
+	r->canceled = (uint8_t)(b->canceled != 0);
+
+	/* 订单号能由日期、车次与序号原样还原时只存序号 */
+	r->order_alt = -1;
+	r->serial = 0;
+	if (booking_decode_order_id(b->order_id, date, sizeof(date), train_id, sizeof(train_id), &serial) == 0 &&
+	    strcmp(date, b->date) == 0 && strcmp(train_id, b->train_id) == 0) {
+		r->serial = serial;
+		rec_order_id(r, regen, sizeof(regen));
+		if (strcmp(regen, b->order_id) == 0)
+			return;
+	}
+	r->order_alt = strpool_intern(text_pool, b->order_id);
+}
+
+static void rec_unpack(const BookingRec *r, Booking *b)
+{
+	rec_order_id(r, b->order_id, sizeof(b->order_id));
+	snprintf(b->passenger_id, sizeof(b->passenger_id), "%s", strpool_get(people_pool, r->passenger_id));
+	snprintf(b->passenger_name, sizeof(b->passenger_name), "%s", strpool_get(people_pool, r->passenger_name));
+	train_day_to_date(r->day, b->date, sizeof(b->date));
+	snprintf(b->train_id, sizeof(b->train_id), "%s", strpool_get(text_pool, r->train_id));
+	snprintf(b->from, sizeof(b->from), "%s", strpool_get(text_pool, r->from));
+	snprintf(b->to, sizeof(b->to), "%s", strpool_get(text_pool, r->to));
+	snprintf(b->depart_time, sizeof(b->depart_time), "%s", strpool_get(text_pool, r->depart_time));
+	b->price = r->price_cents / 100.0;
+	b->seat_class = r->seat_class;
+	b->seat_index = r->seat_index;
+	b->from_stop_idx = r->from_stop_idx;
+	b->to_stop_idx = r->to_stop_idx;
+	b->canceled = r->canceled;
+	if (b->seat_index >= 0)
+		snprintf(b->seat_no, sizeof(b->seat_no), "%d-%d", b->seat_class + 1, b->seat_index + 1);
+	else
+		snprintf(b->seat_no, sizeof(b->seat_no), "-");
+}
+
+/* 写锁下追加一条订单：压缩存入 data[size]，登记到订单号索引与各二级索引 */
+static void store_locked(BookingList *BL, const Booking *b)
+{
+	char key[ID_LEN + DATE_LEN + 1];
+	int idx = BL->size;
+
+	if (BL->size >= BL->capacity)
+		bookinglist_expand(BL);
+
+	rec_pack(&BL->data[idx], b);
+	cols_store(idx, &BL->data[idx]);
+	BL->size++;
+
+	ht_insert(booking_ht, b->order_id, idx);
+	sindex_add(&by_passenger_id, b->passenger_id, idx);
+	sindex_add(&by_passenger_name, b->passenger_name, idx);
+	train_date_key(key, sizeof(key), b->train_id, b->date);
+	sindex_add(&by_train_date, key, idx);
+}
+
 void bookinglist_init(BookingList *L)
 {
-	L->data = xmalloc(sizeof(Booking) * INITIAL_CAPACITY);
+	sync_fetch_add64(&booking_version_seq, 1);
+	L->data = xmalloc(sizeof(BookingRec) * INITIAL_CAPACITY);
 	L->size = 0;
 	L->capacity = INITIAL_CAPACITY;
+	cols_free();
+	cols_resize(0, INITIAL_CAPACITY);
 
 	if (!booking_ht)
 		booking_ht = ht_create(HASH_BUCKETS);
+	else
+		ht_clear(booking_ht);
+	if (!index_arena)
+		index_arena = arena_create(0);
+	else
+		arena_reset(index_arena);
+	sindex_clear(&by_passenger_id);
+	sindex_clear(&by_passenger_name);
+	sindex_clear(&by_train_date);
+	if (!seq_ht)
+		seq_ht = ht_create(HASH_BUCKETS);
+	else
+		ht_clear(seq_ht);
+	seq_count = 0;
+	if (!text_pool) {
+		text_pool = strpool_create();
+		people_pool = strpool_create();
+	} else {
+		strpool_clear(text_pool);
+		strpool_clear(people_pool);
+	}
+	if (!booking_lock)
+		booking_lock = sync_rwlock_create();
 }
 
 void bookinglist_free(BookingList *L)
@@ -39,65 +359,501 @@ void bookinglist_free(BookingList *L)
 	if (!L)
 		return;
 
+	sync_fetch_add64(&booking_version_seq, 1);
 	free(L->data);
 	L->data = NULL;
 	L->size = L->capacity = 0;
+	cols_free();
 
 	if (booking_ht) {
 		ht_free(booking_ht);
 		booking_ht = NULL;
 	}
+	sindex_free(&by_passenger_id);
+	sindex_free(&by_passenger_name);
+	sindex_free(&by_train_date);
+	arena_destroy(index_arena);
+	index_arena = NULL;
+	ht_free(seq_ht);
+	seq_ht = NULL;
+	free(seq_vals);
+	seq_vals = NULL;
+	seq_count = seq_capacity = 0;
+	strpool_free(text_pool);
+	strpool_free(people_pool);
+	text_pool = people_pool = NULL;
+
+	sync_rwlock_free(booking_lock);
+	booking_lock = NULL;
 }
 
 static void bookinglist_expand(BookingList *L)
 {
 	L->capacity *= 2;
-	L->data = realloc(L->data, sizeof(Booking) * L->capacity);
+	L->data = realloc(L->data, sizeof(BookingRec) * L->capacity);
 
 	if (!L->data) {
 		perror("realloc");
 		exit(1);
 	}
+	cols_resize(L->capacity / 2, L->capacity);
 }
 
-static void rebuild(BookingList *L)
+static int find_index(BookingList *BL, const char *order_id)
 {
-	if (!booking_ht)
-		booking_ht = ht_create(HASH_BUCKETS);
-	else
-		ht_clear(booking_ht);
-
-	for (int i = 0; i < L->size; ++i)
-		ht_insert(booking_ht, L->data[i].order_id, i);
+	(void)BL;
+	return booking_ht ? ht_find(booking_ht, order_id) : -1;
 }
 
 int booking_find_index(BookingList *BL, const char *order_id)
 {
-	if (booking_ht) {
-		int idx = ht_find(booking_ht, order_id);
-		if (idx != -1)
-			return idx;
+	sync_rwlock_rdlock(booking_lock);
+	int idx = find_index(BL, order_id);
+	sync_rwlock_rdunlock(booking_lock);
+	return idx;
+}
+
+/* 在读锁下按下标列表复制订单，返回匹配总数 */
+static int copy_hits(BookingList *BL, const IndexList *a, const IndexList *b, Booking *out, int max)
+{
+	int i = 0, j = 0, n = 0;
+	int na = a ? a->size : 0, nb = b ? b->size : 0;
+
+	/* 两个列表都按下标递增，归并去重 */
+	while (i < na || j < nb) {
+		int idx;
+		if (j >= nb || (i < na && a->items[i] < b->items[j]))
+			idx = a->items[i++];
+		else if (i >= na || b->items[j] < a->items[i])
+			idx = b->items[j++];
+		else {
+			idx = a->items[i++];
+			j++;
+		}
+		if (n < max)
+			rec_unpack(&BL->data[idx], &out[n]);
+		n++;
 	}
 
-	for (int i = 0; i < BL->size; ++i)
-		if (strcmp(BL->data[i].order_id, order_id) == 0)
-			return i;
+	return n;
+}
 
-	return -1;
+int booking_get(BookingList *BL, int idx, Booking *out)
+{
+	int res = -1;
+
+	sync_rwlock_rdlock(booking_lock);
+	if (idx >= 0 && idx < BL->size && out) {
+		rec_unpack(&BL->data[idx], out);
+		res = 0;
+	}
+	sync_rwlock_rdunlock(booking_lock);
+	return res;
+}
+
+void booking_alloc_stats(ArenaStats *out)
+{
+	if (!out)
+		return;
+	sync_rwlock_rdlock(booking_lock);
+	arena_stats(index_arena, out);
+	sync_rwlock_rdunlock(booking_lock);
+}
+
+size_t booking_storage_bytes(BookingList *BL)
+{
+	sync_rwlock_rdlock(booking_lock);
+	size_t n = sizeof(BookingRec) * (size_t)BL->capacity + strpool_bytes(text_pool) + strpool_bytes(people_pool);
+	sync_rwlock_rdunlock(booking_lock);
+	return n;
+}
+
+int booking_find_by_passenger(BookingList *BL, const char *passenger, Booking *out, int max)
+{
+	sync_rwlock_rdlock(booking_lock);
+	int n = copy_hits(BL, sindex_get(&by_passenger_id, passenger),
+			  sindex_get(&by_passenger_name, passenger), out, max);
+	sync_rwlock_rdunlock(booking_lock);
+	return n;
+}
+
+int booking_find_by_train_date(BookingList *BL, const char *train_id, const char *date, Booking *out, int max)
+{
+	char key[ID_LEN + DATE_LEN + 1];
+	train_date_key(key, sizeof(key), train_id, date);
+
+	sync_rwlock_rdlock(booking_lock);
+	int n = copy_hits(BL, sindex_get(&by_train_date, key), NULL, out, max);
+	sync_rwlock_rdunlock(booking_lock);
+	return n;
+}
+
+static int popcount64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(x);
+#else
+	int n = 0;
+	for (; x; x &= x - 1)
+		++n;
+	return n;
+#endif
+}
+
+static int ctz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	return popcount64((x & (~x + 1)) - 1);
+#endif
+}
+
+/* 第 w 个 64 条一组的订单中参与统计的位；末组超出 n 的位清零 */
+static uint64_t agg_mask(int w, int n, int filter)
+{
+	uint64_t m = filter == BOOKING_AGG_ACTIVE ? ~cols.canceled[w] :
+		     filter == BOOKING_AGG_CANCELED ? cols.canceled[w] : ~(uint64_t)0;
+	int rest = n - w * 64;
+
+	if (rest < 64)
+		m &= ((uint64_t)1 << rest) - 1;
+	return m;
+}
+
+/* 不分组：每 64 条一组按位图取掩码后直接累加，内层循环无分支 */
+static void agg_total(int n, int filter, BookingAggRow *r)
+{
+	long long cnt = 0, cents = 0, segs = 0;
+
+	for (int w = 0; w * 64 < n; ++w) {
+		uint64_t m = agg_mask(w, n, filter);
+		int base = w * 64, len = n - base < 64 ? n - base : 64;
+		const int32_t *price = cols.price_cents + base;
+		const uint8_t *from = cols.from_stop + base, *to = cols.to_stop + base;
+
+		for (int j = 0; j < len; ++j) {
+			int64_t sel = -(int64_t)((m >> j) & 1);
+			cents += (int64_t)price[j] & sel;
+			segs += (int64_t)(to[j] - from[j]) & sel;
+		}
+		cnt += popcount64(m);
+	}
+
+	r->count = cnt;
+	r->revenue_cents = cents;
+	r->segments = segs;
+}
+
+typedef struct {
+	uint64_t code;
+	long long count;
+	long long cents;
+	long long segs;
+} AggCell;
+
+static int agg_row_cmp(const void *a, const void *b)
+{
+	const BookingAggRow *x = a, *y = b;
+	int c = strcmp(x->train_id, y->train_id);
+
+	if (c)
+		return c;
+	c = strcmp(x->date, y->date);
+	if (c)
+		return c;
+	return x->seat_class - y->seat_class;
+}
+
+/*
+ * 分组：组号 code = (车次序号 * 日期跨度 + 日期偏移) * 等级数 + 等级，未参与分组的维度取 0。
+ * 组合数不超过订单数量级时直接以 code 为下标累加，否则用开放寻址表把 code 映射到稠密的组。
+ * 返回分组数，rows 由调用方释放。
+ */
+static int agg_grouped(int n, int group_by, int filter, BookingAggRow **rows)
+{
+	int by_t = group_by & BOOKING_BY_TRAIN, by_d = group_by & BOOKING_BY_DATE, by_c = group_by & BOOKING_BY_CLASS;
+	int ntr = 1, nd = 1, nc = 1, dmin = 0;
+	int *tmap = NULL;
+	uint32_t *tr_ids = NULL;
+
+	if (by_t) {
+		int np = strpool_count(text_pool);
+		tmap = xmalloc(sizeof(int) * (np ? np : 1));
+		tr_ids = xmalloc(sizeof(uint32_t) * (np ? np : 1));
+		memset(tmap, 0xff, sizeof(int) * (np ? np : 1));
+		ntr = 0;
+		for (int i = 0; i < n; ++i) {
+			uint32_t t = cols.train_id[i];
+			if (tmap[t] < 0) {
+				tmap[t] = ntr;
+				tr_ids[ntr++] = t;
+			}
+		}
+		if (!ntr)
+			ntr = 1;
+	}
+	if (by_d && n > 0) {
+		int lo = cols.day[0], hi = cols.day[0];
+		for (int i = 1; i < n; ++i) {
+			int d = cols.day[i];
+			lo = d < lo ? d : lo;
+			hi = d > hi ? d : hi;
+		}
+		dmin = lo;
+		nd = hi - lo + 1;
+	}
+	if (by_c) {
+		int hi = 0;
+		for (int i = 0; i < n; ++i)
+			hi = cols.seat_class[i] > hi ? cols.seat_class[i] : hi;
+		nc = hi + 1;
+	}
+
+	uint64_t cells = (uint64_t)ntr * (uint64_t)nd * (uint64_t)nc;
+	int dense = cells <= (uint64_t)n + 4096;
+	size_t ncell = dense ? (size_t)cells : (size_t)n;
+	AggCell *acc = calloc(ncell ? ncell : 1, sizeof(AggCell));
+	size_t hcap = 0;
+	uint64_t *hkeys = NULL;
+	int *hslot = NULL;
+	int used = 0;
+
+	if (!acc) {
+		perror("calloc");
+		exit(1);
+	}
+	if (!dense) {
+		for (hcap = 64; hcap < (size_t)n * 2; hcap <<= 1)
+			;
+		hkeys = xmalloc(sizeof(uint64_t) * hcap);
+		hslot = xmalloc(sizeof(int) * hcap);
+		memset(hslot, 0xff, sizeof(int) * hcap);
+	}
+
+	for (int w = 0; w * 64 < n; ++w) {
+		for (uint64_t m = agg_mask(w, n, filter); m; m &= m - 1) {
+			int i = w * 64 + ctz64(m);
+			uint64_t code = ((uint64_t)(by_t ? tmap[cols.train_id[i]] : 0) * nd +
+					 (uint64_t)(by_d ? cols.day[i] - dmin : 0)) * nc +
+					(uint64_t)(by_c ? cols.seat_class[i] : 0);
+			AggCell *c;
+
+			if (dense) {
+				c = &acc[code];
+			} else {
+				size_t h = (size_t)((code * 0x9E3779B97F4A7C15ULL) >> 17) & (hcap - 1);
+				while (hslot[h] >= 0 && hkeys[h] != code)
+					h = (h + 1) & (hcap - 1);
+				if (hslot[h] < 0) {
+					hkeys[h] = code;
+					hslot[h] = used++;
+				}
+				c = &acc[hslot[h]];
+			}
+			c->code = code;
+			c->count++;
+			c->cents += cols.price_cents[i];
+			c->segs += cols.to_stop[i] - cols.from_stop[i];
+		}
+	}
+
+	int ng = 0;
+	for (size_t k = 0; k < ncell; ++k)
+		if (acc[k].count)
+			++ng;
+
+	BookingAggRow *out = xmalloc(sizeof(BookingAggRow) * (ng ? ng : 1));
+	int g = 0;
+	for (size_t k = 0; k < ncell; ++k) {
+		const AggCell *c = &acc[k];
+		BookingAggRow *r;
+		if (!c->count)
+			continue;
+
+		r = &out[g++];
+		memset(r, 0, sizeof(*r));
+		if (by_t)
+			snprintf(r->train_id, sizeof(r->train_id), "%s",
+				 strpool_get(text_pool, (int)tr_ids[c->code / nc / nd]));
+		if (by_d)
+			train_day_to_date(dmin + (int)(c->code / nc % nd), r->date, sizeof(r->date));
+		r->seat_class = by_c ? (int)(c->code % nc) : -1;
+		r->count = c->count;
+		r->revenue_cents = c->cents;
+		r->segments = c->segs;
+	}
+	qsort(out, ng, sizeof(BookingAggRow), agg_row_cmp);
+
+	free(tmap);
+	free(tr_ids);
+	free(acc);
+	free(hkeys);
+	free(hslot);
+	*rows = out;
+	return ng;
+}
+
+int booking_aggregate(BookingList *BL, int group_by, int filter, BookingAggRow *out, int max)
+{
+	if (!BL || (group_by & ~(BOOKING_BY_TRAIN | BOOKING_BY_DATE | BOOKING_BY_CLASS)) ||
+	    filter < BOOKING_AGG_ALL || filter > BOOKING_AGG_CANCELED || (max > 0 && !out))
+		return -1;
+
+	sync_rwlock_rdlock(booking_lock);
+	int n = BL->size;
+
+	if (!group_by) {
+		BookingAggRow total;
+		memset(&total, 0, sizeof(total));
+		total.seat_class = -1;
+		agg_total(n, filter, &total);
+		sync_rwlock_rdunlock(booking_lock);
+		if (max > 0)
+			out[0] = total;
+		return 1;
+	}
+
+	BookingAggRow *rows;
+	int ng = agg_grouped(n, group_by, filter, &rows);
+	sync_rwlock_rdunlock(booking_lock);
+
+	if (max > 0)
+		memcpy(out, rows, sizeof(BookingAggRow) * (ng < max ? ng : max));
+	free(rows);
+	return ng;
 }
 
-static void generate_order_id(char *out, size_t outlen, BookingList *BL,
-			      const char *date, const char *train_id)
+static void generate_order_id(char *out, size_t outlen, const char *date, const char *train_id)
 {
-	int serial = 0;
+	int *seq = seq_slot(train_id, date);
+	snprintf(out, outlen, "%s-%s-%04d", date, train_id, ++*seq);
+}
 
-	for (int i = 0; i < BL->size; ++i) {
-		Booking *b = &BL->data[i];
-		if (strcmp(b->date, date) == 0 && strcmp(b->train_id, train_id) == 0)
-			serial++;
+int booking_decode_order_id(const char *order_id, char *date, size_t date_len,
+			    char *train_id, size_t train_len, int *serial)
+{
+	/* 日期固定 10 个字符；车次号可能含 '-'，序号取最后一个 '-' 之后 */
+	size_t n = order_id ? strlen(order_id) : 0;
+	if (n < 14 || order_id[10] != '-')
+		return -1;
+
+	const char *last = strrchr(order_id, '-');
+	if (last <= order_id + 11 || !last[1])
+		return -1;
+
+	char *end;
+	long v = strtol(last + 1, &end, 10);
+	if (*end || v <= 0 || v > 99999999)
+		return -1;
+
+	char d[DATE_LEN];
+	memcpy(d, order_id, 10);
+	d[10] = '\0';
+	if (train_date_to_day(d) < 0)
+		return -1;
+
+	size_t tl = (size_t)(last - (order_id + 11));
+	if (date) {
+		if (date_len < 11)
+			return -1;
+		memcpy(date, d, 11);
 	}
+	if (train_id) {
+		if (tl >= train_len)
+			return -1;
+		memcpy(train_id, order_id + 11, tl);
+		train_id[tl] = '\0';
+	}
+	if (serial)
+		*serial = (int)v;
+	return 0;
+}
 
-	snprintf(out, outlen, "%s-%s-%04d", date, train_id, serial + 1);
+/* 订单号之外的字段；depart_time/price 由调用方在持有 booking_lock 之前取好 */
+static void booking_fill(Booking *b, const Passenger *p,
+			 const char *date, const char *train_id, const char *from, const char *to,
+			 const char *depart_time, double price,
+			 int seat_class, int seat_index, int from_idx, int to_idx)
+{
+	strncpy(b->passenger_id, p->id_num, ID_LEN - 1);
+	b->passenger_id[ID_LEN - 1] = '\0';
+
+	strncpy(b->passenger_name, p->name, NAME_LEN - 1);
+	b->passenger_name[NAME_LEN - 1] = '\0';
+
+	strncpy(b->date, date, DATE_LEN - 1);
+	b->date[DATE_LEN - 1] = '\0';
+
+	strncpy(b->train_id, train_id, ID_LEN - 1);
+	b->train_id[ID_LEN - 1] = '\0';
+
+	strncpy(b->from, from, STATION_LEN - 1);
+	b->from[STATION_LEN - 1] = '\0';
+
+	strncpy(b->to, to, STATION_LEN - 1);
+	b->to[STATION_LEN - 1] = '\0';
+
+	snprintf(b->depart_time, sizeof(b->depart_time), "%s", depart_time);
+	b->price = price;
+
+	b->seat_class = seat_class;
+	b->seat_index = seat_index;
+	b->from_stop_idx = from_idx;
+	b->to_stop_idx = to_idx;
+	b->canceled = 0;
+
+	snprintf(b->seat_no, sizeof(b->seat_no), "%d-%d", seat_class + 1, seat_index + 1);
+}
+
+/* 按 bookings.txt 的一行格式化，供保存与日志共用 */
+static void format_booking(char *out, size_t outlen, const Booking *b)
+{
+	snprintf(out, outlen, "%s|%s|%s|%s|%s|%s|%s|%s|%.2f|%s|%d|%d|%d|%d|%d",
+		 b->order_id, b->passenger_id, b->passenger_name, b->date, b->train_id,
+		 b->from, b->to, b->depart_time, b->price, b->seat_no, b->seat_class,
+		 b->seat_index, b->from_stop_idx, b->to_stop_idx, b->canceled);
+}
+
+/* 从扫描器的当前行读出 format_booking 的各字段；字段不足、数字或日期无效时记错返回 -1 */
+static int parse_booking(Scanner *s, Booking *b)
+{
+	memset(b, 0, sizeof(*b));
+
+	scan_str(s, b->order_id, sizeof(b->order_id));
+	scan_str(s, b->passenger_id, sizeof(b->passenger_id));
+	scan_str(s, b->passenger_name, sizeof(b->passenger_name));
+	const char *date = s->fp;
+	scan_str(s, b->date, sizeof(b->date));
+	if (!s->err && train_date_to_day(b->date) < 0)
+		return scan_fail(s, date, "日期无效");
+	scan_str(s, b->train_id, sizeof(b->train_id));
+	scan_str(s, b->from, sizeof(b->from));
+	scan_str(s, b->to, sizeof(b->to));
+	scan_str(s, b->depart_time, sizeof(b->depart_time));
+	scan_double(s, &b->price);
+	scan_str(s, b->seat_no, sizeof(b->seat_no));
+	scan_int(s, &b->seat_class);
+	scan_int(s, &b->seat_index);
+	scan_int(s, &b->from_stop_idx);
+	scan_int(s, &b->to_stop_idx);
+	scan_int(s, &b->canceled);
+
+	return s->err ? -1 : 0;
+}
+
+/* 在 booking_lock 写锁下生成订单号并追加，只把新订单插入索引；返回日志序号，释放锁后交给 wal_commit */
+static long long append_locked(BookingList *BL, Booking *b)
+{
+	char rec[BOOKING_LINE_MAX] = "B|";
+
+	generate_order_id(b->order_id, sizeof(b->order_id), b->date, b->train_id);
+	store_locked(BL, b);
+	format_booking(rec + 2, sizeof(rec) - 2, b);
+	long long lsn = wal_append(rec);
+	if (!lsn)
+		sync_fetch_add64(&booking_version_seq, 1);
+	return lsn;
 }
 
 int booking_create(BookingList *BL, TrainList *TL, PassengerList *PL,
@@ -105,8 +861,10 @@ int booking_create(BookingList *BL, TrainList *TL, PassengerList *PL,
 		   const char *from, const char *to,
 		   const char *passenger_id, int seat_class, char *out_order_id, size_t order_len)
 {
-	int pidx = passenger_find_index(PL, passenger_id);
-	if (pidx == -1)
+	Passenger p;
+	if (!scan_field_ok(date) || !scan_field_ok(train_id) || !scan_field_ok(from) || !scan_field_ok(to))
+		return ERR_BAD_FIELD;
+	if (passenger_copy(PL, passenger_id, &p) != 0)
 		return -1;
 
 	int seat_index, from_idx, to_idx;
@@ -115,81 +873,170 @@ int booking_create(BookingList *BL, TrainList *TL, PassengerList *PL,
 	if (res != 0)
 		return -2;
 
-	if (BL->size >= BL->capacity)
-		bookinglist_expand(BL);
+	char depart_time[TIME_LEN] = "";
+	double price = 0.0;
+	train_fare_info(TL, train_id, seat_class, depart_time, sizeof(depart_time), &price);
 
 	Booking b;
 
-	generate_order_id(b.order_id, sizeof(b.order_id), BL, date, train_id);
+	booking_fill(&b, &p, date, train_id, from, to, depart_time, price,
+		     seat_class, seat_index, from_idx, to_idx);
 
-	strncpy(b.passenger_id, PL->data[pidx].id_num, ID_LEN - 1);
-	b.passenger_id[ID_LEN - 1] = '\0';
+	sync_rwlock_wrlock(booking_lock);
+	long long lsn = append_locked(BL, &b);
+	sync_rwlock_wrunlock(booking_lock);
+	int durable = wal_commit(lsn) == 0;
 
-	strncpy(b.passenger_name, PL->data[pidx].name, NAME_LEN - 1);
-	b.passenger_name[NAME_LEN - 1] = '\0';
+	if (out_order_id) {
+		strncpy(out_order_id, b.order_id, order_len - 1);
+		out_order_id[order_len - 1] = '\0';
+	}
 
-	strncpy(b.date, date, DATE_LEN - 1);
-	b.date[DATE_LEN - 1] = '\0';
+	return durable ? 0 : ERR_NOT_DURABLE;
+}
 
-	strncpy(b.train_id, train_id, ID_LEN - 1);
-	b.train_id[ID_LEN - 1] = '\0';
+int booking_create_group(BookingList *BL, TrainList *TL, PassengerList *PL,
+			 const char *date, const char *train_id,
+			 const char *from, const char *to,
+			 const char *const *passenger_ids, int n, int seat_class,
+			 char (*out_order_ids)[ORDER_ID_LEN])
+{
+	if (n <= 0 || n > GROUP_MAX_SIZE)
+		return -3;
+	if (!scan_field_ok(date) || !scan_field_ok(train_id) || !scan_field_ok(from) || !scan_field_ok(to))
+		return ERR_BAD_FIELD;
 
-	strncpy(b.from, from, STATION_LEN - 1);
-	b.from[STATION_LEN - 1] = '\0';
+	Passenger ps[GROUP_MAX_SIZE];
+	for (int k = 0; k < n; ++k)
+		if (passenger_copy(PL, passenger_ids[k], &ps[k]) != 0)
+			return -1;
 
-	strncpy(b.to, to, STATION_LEN - 1);
-	b.to[STATION_LEN - 1] = '\0';
+	int seats[GROUP_MAX_SIZE], from_idx, to_idx;
+	if (train_allocate_seats(TL, train_id, date, from, to, seat_class, n,
+				 seats, &from_idx, &to_idx) != 0)
+		return -2;
 
-	int tidx = train_find_index(TL, train_id);
-	if (tidx != -1) {
-		Train *t = train_get(TL, tidx);
-		strncpy(b.depart_time, t->depart_time, TIME_LEN - 1);
-		b.depart_time[TIME_LEN - 1] = '\0';
-		b.price = t->base_price * t->seat_price_coef[seat_class];
-	} else {
-		b.depart_time[0] = '\0';
-		b.price = 0.0;
+	char depart_time[TIME_LEN] = "";
+	double price = 0.0;
+	train_fare_info(TL, train_id, seat_class, depart_time, sizeof(depart_time), &price);
+
+	long long lsn = 0;
+	sync_rwlock_wrlock(booking_lock);
+	for (int k = 0; k < n; ++k) {
+		Booking b;
+		booking_fill(&b, &ps[k], date, train_id, from, to, depart_time, price,
+			     seat_class, seats[k], from_idx, to_idx);
+		lsn = append_locked(BL, &b);
+
+		if (out_order_ids)
+			snprintf(out_order_ids[k], ORDER_ID_LEN, "%s", b.order_id);
 	}
+	sync_rwlock_wrunlock(booking_lock);
 
-	b.seat_class = seat_class;
-	b.seat_index = seat_index;
-	b.from_stop_idx = from_idx;
-	b.to_stop_idx = to_idx;
-	b.canceled = 0;
+	return wal_commit(lsn) == 0 ? 0 : ERR_NOT_DURABLE;
+}
 
-	snprintf(b.seat_no, sizeof(b.seat_no), "%d-%d", seat_class + 1, seat_index + 1);
+/* log 为 0 时不记日志（重放） */
+static int cancel_order(BookingList *BL, const char *order_id, TrainList *TL, int log)
+{
+	char rec[ORDER_ID_LEN + 4];
+	long long lsn = 0;
 
-	BL->data[BL->size++] = b;
+	sync_rwlock_wrlock(booking_lock);
+	int idx = find_index(BL, order_id);
+	if (idx == -1) {
+		sync_rwlock_wrunlock(booking_lock);
+		return -1;
+	}
 
-	rebuild(BL);
+	Booking bk;
+	rec_unpack(&BL->data[idx], &bk);
+	if (bk.canceled) {
+		sync_rwlock_wrunlock(booking_lock);
+		return -2;
+	}
 
-	if (out_order_id) {
-		strncpy(out_order_id, b.order_id, order_len - 1);
-		out_order_id[order_len - 1] = '\0';
+	/* 先置退票标记再释放座位，保证同一订单并发退票只释放一次 */
+	BL->data[idx].canceled = 1;
+	cols.canceled[idx >> 6] |= (uint64_t)1 << (idx & 63);
+	if (log) {
+		snprintf(rec, sizeof(rec), "C|%s", bk.order_id);
+		lsn = wal_append(rec);
 	}
+	if (log && !lsn)
+		sync_fetch_add64(&booking_version_seq, 1);
+	sync_rwlock_wrunlock(booking_lock);
 
-	return 0;
+	int res = bk.seat_index < 0 ? 0 : train_release_seat(TL, bk.train_id, bk.date, bk.seat_class,
+							     bk.seat_index, bk.from_stop_idx, bk.to_stop_idx);
+	int durable = wal_commit(lsn) == 0;
+	if (res != 0)
+		return -3;
+
+	return durable ? 0 : ERR_NOT_DURABLE;
 }
 
 int booking_cancel(BookingList *BL, const char *order_id, TrainList *TL)
 {
-	int idx = booking_find_index(BL, order_id);
-	if (idx == -1)
+	return cancel_order(BL, order_id, TL, 1);
+}
+
+/*
+ * 载入或重放的有效订单重新占座。座位已被别的订单占用、或日期的日历槽被另一个未过期日期占着时，
+ * 把订单改记为未分配座位（seat_index 为 -1）并返回 -1，免得同一座位再被卖出；已归档的日期不占座也不算失败
+ */
+static int mark_loaded(TrainList *TL, Booking *b)
+{
+	if (train_mark_seat(TL, b->train_id, b->date, b->seat_class, b->seat_index,
+			    b->from_stop_idx, b->to_stop_idx) != -1)
+		return 0;
+	b->seat_index = -1;
+	snprintf(b->seat_no, sizeof(b->seat_no), "-");
+	return -1;
+}
+
+static void report_unseated(const char *filename, const char *order_id)
+{
+	fprintf(stderr, "%s: 订单 %s 的座位无法占用（已被占用、区间无效或日期不在售票窗口内），按未分配座位载入\n", filename, order_id);
+}
+
+/* 订单号已存在的 B 记录与已退票的 C 记录都已在快照中，跳过 */
+int booking_replay(BookingList *BL, TrainList *TL, const char *rec)
+{
+	Scanner sc;
+	Booking b;
+
+	if (strlen(rec) < 2 || rec[1] != '|')
 		return -1;
 
-	Booking *bk = &BL->data[idx];
-	if (bk->canceled)
-		return -2;
+	if (rec[0] == 'C') {
+		int res = cancel_order(BL, rec + 2, TL, 0);
+		return res == -1 || res == -2 ? 0 : 1;
+	}
+	if (rec[0] != 'B')
+		return -1;
 
-	int res = train_release_seat(TL, bk->train_id, bk->date, bk->seat_class,
-				     bk->seat_index, bk->from_stop_idx, bk->to_stop_idx);
-	if (res != 0) {
-		bk->canceled = 1;
-		return -3;
+	scan_init(&sc, rec + 2, strlen(rec + 2), 1);
+	if (!scan_line(&sc) || parse_booking(&sc, &b) != 0)
+		return -1;
+
+	sync_rwlock_wrlock(booking_lock);
+	int exists = find_index(BL, b.order_id) != -1, unseated = 0;
+	if (!exists) {
+		if (!b.canceled && b.seat_index >= 0 && mark_loaded(TL, &b) != 0) {
+			fprintf(stderr, "订单 %s 的座位无法占用（已被占用、区间无效或日期不在售票窗口内），按未分配座位载入\n", b.order_id);
+			unseated = 1;
+		}
+		store_locked(BL, &b);
+		seq_restore(&b);
 	}
+	sync_rwlock_wrunlock(booking_lock);
+	return exists ? 0 : unseated ? 2 : 1;
+}
 
-	bk->canceled = 1;
-	return 0;
+long long booking_version(void)
+{
+	return sync_fetch_add64(&booking_version_seq, 0);
 }
 
 void booking_list_all(BookingList *L)
@@ -199,121 +1046,415 @@ void booking_list_all(BookingList *L)
 		return;
 	}
 
+	sync_rwlock_rdlock(booking_lock);
 	for (int i = 0; i < L->size; ++i) {
-		Booking *b = &L->data[i];
+		Booking bk, *b = &bk;
+		rec_unpack(&L->data[i], b);
 		printf("---- [%d] ----\n", i + 1);
 		printf("订单号:%s  乘客:%s(%s)  日期:%s  车次:%s  %s->%s  发车:%s  票价:%.2f  座位:%s  等级:%d  状态:%s\n",
 		       b->order_id, b->passenger_name, b->passenger_id, b->date, b->train_id,
 		       b->from, b->to, b->depart_time, b->price, b->seat_no, b->seat_class,
 		       b->canceled ? "已退票" : "已出票");
 	}
+	sync_rwlock_rdunlock(booking_lock);
 }
 
 int save_bookings(const char *filename, BookingList *L)
 {
-	FILE *f = fopen(filename, "w");
+	char tmp[FILENAME_MAX + 8];
+	FILE *f = file_replace_begin(filename, tmp, sizeof(tmp));
 	if (!f)
 		return 0;
 
+	sync_rwlock_rdlock(booking_lock);
 	fprintf(f, "%d\n", L->size);
 
 	for (int i = 0; i < L->size; ++i) {
-		Booking *b = &L->data[i];
-		fprintf(f, "%s|%s|%s|%s|%s|%s|%s|%s|%.2f|%s|%d|%d|%d|%d|%d\n",
-			b->order_id, b->passenger_id, b->passenger_name, b->date, b->train_id,
-			b->from, b->to, b->depart_time, b->price, b->seat_no, b->seat_class,
-			b->seat_index, b->from_stop_idx, b->to_stop_idx, b->canceled);
+		Booking b;
+		char line[BOOKING_LINE_MAX];
+		rec_unpack(&L->data[i], &b);
+		format_booking(line, sizeof(line), &b);
+		fprintf(f, "%s\n", line);
 	}
+	sync_rwlock_rdunlock(booking_lock);
 
-	fclose(f);
-	return 1;
+	return file_replace_commit(f, tmp, filename, !ferror(f));
 }
 
 int load_bookings(const char *filename, BookingList *L, TrainList *TL)
 {
-	FILE *f = fopen(filename, "r");
-	if (!f)
-		return 0;
+	MappedFile m;
+	Scanner sc;
+	int count = 0, ok = 0, unseated = 0;
 
-	int count = 0;
-	if (fscanf(f, "%d\n", &count) != 1) {
-		fclose(f);
+	if (map_file(filename, &m) != 0)
 		return 0;
+	sync_fetch_add64(&booking_version_seq, 1);
+	scan_init(&sc, m.p, m.len, 1);
+	if (!scan_line(&sc) || scan_int(&sc, &count) != 0 || count < 0) {
+		scan_fail(&sc, sc.line, "记录数无效");
+		goto done;
 	}
 
-	char line[2048];
+	sync_rwlock_wrlock(booking_lock);
+	if (count > 0)
+		ht_reserve(booking_ht, L->size + count);
 
 	for (int i = 0; i < count; ++i) {
-		if (!fgets(line, sizeof(line), f)) {
-			fclose(f);
-			return 0;
+		Booking b;
+		if (!scan_line(&sc) || parse_booking(&sc, &b) != 0)
+			goto out;
+
+		if (!b.canceled && b.seat_index >= 0 && mark_loaded(TL, &b) != 0) {
+			report_unseated(filename, b.order_id);
+			unseated++;
 		}
+		store_locked(L, &b);
+		seq_restore(&b);
+	}
 
-		size_t ln = strlen(line);
-		if (ln && line[ln - 1] == '\n')
-			line[ln - 1] = '\0';
+	ok = 1;
+out:
+	sync_rwlock_wrunlock(booking_lock);
+done:
+	if (!ok)
+		scan_report(&sc, filename);
+	if (unseated) {
+		fprintf(stderr, "%s: 共 %d 个订单按未分配座位载入\n", filename, unseated);
+		ok = 0;
+	}
+	unmap_file(&m);
+	return ok;
+}
+
+/*
+ * 并行载入：文件整体映射后按块（约 LOAD_BLOCK 字节，行不跨块）切成行，分给各线程各自用扫描器解析，
+ * 再由主线程按文件顺序写入订单表与索引；与此同时各线程按 车次+日期 分组重放占座，
+ * 同一车次/日期只由一个线程处理，不同车次并行，互不争抢同一槽位的锁。
+ */
+#define LOAD_BLOCK (8 << 20)
+#define LOAD_MAX_THREADS 64
+
+typedef struct {
+	const char **lines;	/* 本块各行的起点，lines[n] 为块末 */
+	Booking *recs;
+	int *group;		/* 占座分组，解析失败为 -1 */
+	int begin, end;
+	long first_line;	/* lines[0] 的行号 */
+	int worker, nworkers;
+	TrainList *TL;
+	Scanner err;		/* 本线程遇到的第一个错误 */
+	int *unseated;		/* 座位无法占用的行号（块内下标），由主线程改记为未分配座位 */
+	int nunseated, unseated_cap;
+} LoadTask;
+
+static unsigned load_group_hash(const Booking *b)
+{
+	unsigned h = 2166136261u;
+
+	for (const char *p = b->train_id; *p; ++p)
+		h = (h ^ (unsigned char)*p) * 16777619u;
+	for (const char *p = b->date; *p; ++p)
+		h = (h ^ (unsigned char)*p) * 16777619u;
+	return h;
+}
 
-		char *parts[16];
-		int p = 0;
-		char *tok = strtok(line, "|");
-		while (tok && p < 16) {
-			parts[p++] = tok;
-			tok = strtok(NULL, "|");
+static void *load_parse_worker(void *arg)
+{
+	LoadTask *t = arg;
+	Scanner s;
+
+	scan_init(&s, t->lines[t->begin], (size_t)(t->lines[t->end] - t->lines[t->begin]), t->first_line + t->begin);
+	for (int i = t->begin; i < t->end; ++i)
+		t->group[i] = scan_line(&s) && parse_booking(&s, &t->recs[i]) == 0 ?
+			      (int)(load_group_hash(&t->recs[i]) % (unsigned)t->nworkers) : -1;
+	t->err = s;
+	return NULL;
+}
+
+static void *load_mark_worker(void *arg)
+{
+	LoadTask *t = arg;
+
+	t->nunseated = 0;
+	for (int i = 0; i < t->end; ++i) {
+		const Booking *b = &t->recs[i];
+		if (t->group[i] != t->worker || b->canceled || b->seat_index < 0 ||
+		    train_mark_seat(t->TL, b->train_id, b->date, b->seat_class, b->seat_index,
+				    b->from_stop_idx, b->to_stop_idx) != -1)
+			continue;
+		if (t->nunseated == t->unseated_cap) {
+			t->unseated_cap = t->unseated_cap ? t->unseated_cap * 2 : 16;
+			t->unseated = xrealloc(t->unseated, sizeof(int) * t->unseated_cap);
 		}
+		t->unseated[t->nunseated++] = i;
+	}
+	return NULL;
+}
 
-		if (p < 15) {
-			fclose(f);
-			return 0;
+/*
+ * 处理一块中的 n 行：返回成功写入的条数；遇到无效行时只写入它之前的行，错误位置复制到 err。
+ * 座位无法占用的订单在全部写入后改记为未分配座位，计入 *unseated 并在 stderr 列出
+ */
+static int load_round(BookingList *L, TrainList *TL, const char **lines, int n, long first_line,
+		      Booking *recs, int *group, int threads, Scanner *err,
+		      const char *filename, int *unseated)
+{
+	LoadTask tasks[LOAD_MAX_THREADS];
+	SyncThread *th[LOAD_MAX_THREADS];
+	int ok = n, base = L->size;
+
+	for (int w = 0; w < threads; ++w) {
+		LoadTask *t = &tasks[w];
+		t->lines = lines;
+		t->recs = recs;
+		t->group = group;
+		t->begin = (int)((long long)n * w / threads);
+		t->end = (int)((long long)n * (w + 1) / threads);
+		t->first_line = first_line;
+		t->worker = w;
+		t->nworkers = threads;
+		t->TL = TL;
+		t->unseated = NULL;
+		t->nunseated = t->unseated_cap = 0;
+		th[w] = sync_thread_start(load_parse_worker, t);
+	}
+	for (int w = 0; w < threads; ++w)
+		sync_thread_join(th[w]);
+
+	for (int w = 0; w < threads && ok == n; ++w)
+		for (int i = tasks[w].begin; i < tasks[w].end; ++i)
+			if (group[i] < 0) {
+				ok = i;
+				*err = tasks[w].err;
+				break;
+			}
+
+	for (int w = 0; w < threads; ++w) {
+		tasks[w].end = ok;
+		th[w] = sync_thread_start(load_mark_worker, &tasks[w]);
+	}
+	for (int i = 0; i < ok; ++i) {
+		store_locked(L, &recs[i]);
+		seq_restore(&recs[i]);
+	}
+	for (int w = 0; w < threads; ++w)
+		sync_thread_join(th[w]);
+
+	for (int w = 0; w < threads; ++w) {
+		for (int k = 0; k < tasks[w].nunseated; ++k) {
+			int i = tasks[w].unseated[k];
+			L->data[base + i].seat_index = -1;
+			report_unseated(filename, recs[i].order_id);
 		}
+		*unseated += tasks[w].nunseated;
+		free(tasks[w].unseated);
+	}
+	return ok;
+}
 
-		Booking b;
-		memset(&b, 0, sizeof(b));
+int load_bookings_parallel(const char *filename, BookingList *L, TrainList *TL, int threads)
+{
+	MappedFile m;
+	Scanner sc;
+	int count = 0, done = 0, ok = 0, unseated = 0;
 
-		strncpy(b.order_id, parts[0], ORDER_ID_LEN - 1);
-		b.order_id[ORDER_ID_LEN - 1] = '\0';
+	if (map_file(filename, &m) != 0)
+		return 0;
+	sync_fetch_add64(&booking_version_seq, 1);
+	if (threads <= 0)
+		threads = sync_cpu_count();
+	if (threads > LOAD_MAX_THREADS)
+		threads = LOAD_MAX_THREADS;
+
+	scan_init(&sc, m.p, m.len, 1);
+	if (!scan_line(&sc) || scan_int(&sc, &count) != 0 || count < 0) {
+		scan_fail(&sc, sc.line, "记录数无效");
+		scan_report(&sc, filename);
+		unmap_file(&m);
+		return 0;
+	}
 
-		strncpy(b.passenger_id, parts[1], ID_LEN - 1);
-		b.passenger_id[ID_LEN - 1] = '\0';
+	const char *p = sc.cur, *end = m.p + m.len;
+	const char **lines = NULL;
+	Booking *recs = NULL;
+	int *group = NULL;
+	int lines_cap = 0;
+	long lineno = 2;
+
+	sync_rwlock_wrlock(booking_lock);
+	if (count > 0)
+		ht_reserve(booking_ht, L->size + count);
+
+	while (done < count) {
+		if (p == end) {
+			scan_init(&sc, end, 0, lineno);
+			scan_line(&sc);
+			goto out;
+		}
 
-		strncpy(b.passenger_name, parts[2], NAME_LEN - 1);
-		b.passenger_name[NAME_LEN - 1] = '\0';
+		/* 切出本块的各行（至少一行），不超过剩余的记录数 */
+		const char *stop = (size_t)(end - p) > LOAD_BLOCK ? p + LOAD_BLOCK : end;
+		int n = 0;
+		while (p < end && n < count - done && (n == 0 || p < stop)) {
+			if (n + 1 >= lines_cap) {
+				lines_cap = lines_cap ? lines_cap * 2 : 4096;
+				lines = xrealloc(lines, sizeof(char *) * lines_cap);
+				recs = xrealloc(recs, sizeof(Booking) * lines_cap);
+				group = xrealloc(group, sizeof(int) * lines_cap);
+			}
+			lines[n++] = p;
+			const char *nl = memchr(p, '\n', (size_t)(end - p));
+			p = nl ? nl + 1 : end;
+		}
+		lines[n] = p;
 
-		strncpy(b.date, parts[3], DATE_LEN - 1);
-		b.date[DATE_LEN - 1] = '\0';
+		int stored = load_round(L, TL, lines, n, lineno, recs, group, threads, &sc, filename, &unseated);
+		done += stored;
+		lineno += n;
+		if (stored < n)
+			goto out;
+	}
+	ok = 1;
+out:
+	sync_rwlock_wrunlock(booking_lock);
+	if (!ok)
+		scan_report(&sc, filename);
+	if (unseated) {
+		fprintf(stderr, "%s: 共 %d 个订单按未分配座位载入\n", filename, unseated);
+		ok = 0;
+	}
+	free(lines);
+	free(recs);
+	free(group);
+	unmap_file(&m);
+	return ok;
+}
 
-		strncpy(b.train_id, parts[4], ID_LEN - 1);
-		b.train_id[ID_LEN - 1] = '\0';
+static void sindex_snapshot_save(SecondaryIndex *si, SnapWriter *w)
+{
+	ht_snapshot_save(si->ht, w);
+	snap_put_u64(w, (uint64_t)si->size);
+	for (int i = 0; i < si->size; ++i)
+		snap_put_u64(w, (uint64_t)si->lists[i].size);
+	for (int i = 0; i < si->size; ++i)
+		snap_write(w, si->lists[i].items, sizeof(int) * si->lists[i].size);
+}
 
-		strncpy(b.from, parts[5], STATION_LEN - 1);
-		b.from[STATION_LEN - 1] = '\0';
+/* 每张下标列表按原长度从 index_arena 分配后整段复制；下标必须小于订单数 */
+static int sindex_snapshot_load(SecondaryIndex *si, SnapReader *r, int nrec)
+{
+	if (ht_snapshot_load(si->ht, r) != 0)
+		return -1;
 
-		strncpy(b.to, parts[6], STATION_LEN - 1);
-		b.to[STATION_LEN - 1] = '\0';
+	size_t n = snap_get_count(r, (size_t)ht_count(si->ht));
+	const uint64_t *sizes = snap_read(r, sizeof(uint64_t) * n);
+	if (!sizes || n != (size_t)ht_count(si->ht))
+		return -1;
 
-		strncpy(b.depart_time, parts[7], TIME_LEN - 1);
-		b.depart_time[TIME_LEN - 1] = '\0';
+	if ((int)n > si->capacity) {
+		si->lists = xrealloc(si->lists, sizeof(IndexList) * n);
+		si->capacity = (int)n;
+	}
+	si->size = 0;
+	for (size_t i = 0; i < n; ++i) {
+		IndexList *l = &si->lists[i];
+		const int *items = sizes[i] <= (uint64_t)nrec ? snap_read(r, sizeof(int) * sizes[i]) : NULL;
+		if (!items || !sizes[i])
+			return -1;
+		l->size = l->capacity = (int)sizes[i];
+		l->items = arena_alloc(index_arena, sizeof(int) * l->capacity);
+		memcpy(l->items, items, sizeof(int) * l->size);
+		si->size++;
+		for (int k = 0; k < l->size; ++k)
+			if (l->items[k] < 0 || l->items[k] >= nrec)
+				return -1;
+	}
+	return ht_check_index(si->ht, si->size);
+}
 
-		b.price = atof(parts[8]);
+/*
+ * 快照：紧凑记录数组、两个驻留池、订单号索引、序号计数器与三张二级索引原样写出；
+ * 载入时整段复制，列式副本由记录一次扫描重建，不再逐条解析、插索引。
+ */
+void booking_snapshot_save(BookingList *L, SnapWriter *w)
+{
+	sync_rwlock_rdlock(booking_lock);
+	snap_put_u64(w, (uint64_t)L->size);
+	snap_write(w, L->data, sizeof(BookingRec) * L->size);
+	ht_snapshot_save(booking_ht, w);
+	strpool_snapshot_save(text_pool, w);
+	strpool_snapshot_save(people_pool, w);
+	ht_snapshot_save(seq_ht, w);
+	snap_put_u64(w, (uint64_t)seq_count);
+	snap_write(w, seq_vals, sizeof(int) * seq_count);
+	sindex_snapshot_save(&by_passenger_id, w);
+	sindex_snapshot_save(&by_passenger_name, w);
+	sindex_snapshot_save(&by_train_date, w);
+	sync_rwlock_rdunlock(booking_lock);
+}
 
-		strncpy(b.seat_no, parts[9], sizeof(b.seat_no) - 1);
-		b.seat_no[sizeof(b.seat_no) - 1] = '\0';
+/* 记录里的驻留池编号必须在池内，否则 booking_get 会读出空串、统计按编号分组会越界 */
+static int recs_check_pools(const BookingList *L)
+{
+	uint32_t nt = (uint32_t)strpool_count(text_pool), np = (uint32_t)strpool_count(people_pool);
 
-		b.seat_class = atoi(parts[10]);
-		b.seat_index = atoi(parts[11]);
-		b.from_stop_idx = atoi(parts[12]);
-		b.to_stop_idx = atoi(parts[13]);
-		b.canceled = atoi(parts[14]);
+	for (int i = 0; i < L->size; ++i) {
+		const BookingRec *b = &L->data[i];
+		if (b->passenger_id >= np || b->passenger_name >= np ||
+		    b->train_id >= nt || b->from >= nt || b->to >= nt || b->depart_time >= nt ||
+		    b->order_alt < -1 || (b->order_alt >= 0 && (uint32_t)b->order_alt >= nt))
+			return -1;
+	}
+	return 0;
+}
 
-		if (L->size >= L->capacity)
-			bookinglist_expand(L);
+static int snapshot_load_locked(BookingList *L, SnapReader *r)
+{
+	size_t n = snap_get_count(r, INT32_MAX);
+	const BookingRec *recs = snap_read(r, sizeof(BookingRec) * n);
+	if (!recs)
+		return -1;
+
+	while ((size_t)L->capacity < n)
+		bookinglist_expand(L);
+	if (n)
+		memcpy(L->data, recs, sizeof(BookingRec) * n);
+	L->size = (int)n;
+	for (int i = 0; i < L->size; ++i)
+		cols_store(i, &L->data[i]);
 
-		L->data[L->size++] = b;
+	if (ht_snapshot_load(booking_ht, r) != 0 || ht_count(booking_ht) > L->size ||
+	    ht_check_index(booking_ht, L->size) != 0 ||
+	    strpool_snapshot_load(text_pool, r) != 0 || strpool_snapshot_load(people_pool, r) != 0 ||
+	    recs_check_pools(L) != 0 || ht_snapshot_load(seq_ht, r) != 0)
+		return -1;
 
-		if (!b.canceled)
-			train_mark_seat(TL, b.train_id, b.date, b.seat_class, b.seat_index, b.from_stop_idx, b.to_stop_idx);
+	size_t ns = snap_get_count(r, (size_t)ht_count(seq_ht));
+	const int *vals = snap_read(r, sizeof(int) * ns);
+	if (!vals || ns != (size_t)ht_count(seq_ht))
+		return -1;
+	if ((int)ns > seq_capacity) {
+		seq_vals = xrealloc(seq_vals, sizeof(int) * ns);
+		seq_capacity = (int)ns;
 	}
+	if (ns)
+		memcpy(seq_vals, vals, sizeof(int) * ns);
+	seq_count = (int)ns;
+	if (ht_check_index(seq_ht, seq_count) != 0)
+		return -1;
 
-	rebuild(L);
-	fclose(f);
-	return 1;
-}
\ No newline at end of file
+	if (sindex_snapshot_load(&by_passenger_id, r, L->size) != 0 ||
+	    sindex_snapshot_load(&by_passenger_name, r, L->size) != 0 ||
+	    sindex_snapshot_load(&by_train_date, r, L->size) != 0)
+		return -1;
+	return 0;
+}
+
+int booking_snapshot_load(BookingList *L, SnapReader *r)
+{
+	sync_rwlock_wrlock(booking_lock);
+	int res = snapshot_load_locked(L, r);
+	sync_rwlock_wrunlock(booking_lock);
+	return res;
+}
@@ -1,37 +1,180 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "hash.h"
 
-typedef struct HashNode {
-	char *key;
+/*
+ * 开放寻址（Robin Hood）字符串哈希表：
+ * 槽位连续存放 32 位哈希、键在 arena 中的偏移与值，查找时先比哈希再比键，不追指针；
+ * 插入时探测距离更短的元素让位给更远的元素，删除时把后继元素整体前移（不留墓碑）。
+ * 键以 '\0' 结尾连续存放在 arena 里，删除留下的空洞在扩容时或超过一半时整理。
+ * 装载因子超过 7/8 时容量翻倍。
+ */
+
+#define HT_MIN_CAPACITY 16
+
+typedef struct {
+	uint32_t hash;		/* 0 表示空槽 */
+	uint32_t key_off;
 	int idx;
-	struct HashNode *next;
-} HashNode;
+} HashSlot;
 
 struct HashTable {
-	HashNode **buckets;
-	int bucket_count;
+	HashSlot *slots;
+	uint32_t mask;
+	uint32_t count;
+	char *arena;
+	size_t arena_len;
+	size_t arena_cap;
+	size_t arena_dead;
 };
 
-static unsigned long hash_str(const char *str)
+static uint32_t hash_str(const char *str)
 {
-	unsigned long hash = 5381;
+	uint32_t h = 2166136261u;
 	int c;
 
 	while ((c = (unsigned char)*str++))
-		hash = ((hash << 5) + hash) + c;
+		h = (h ^ (uint32_t)c) * 16777619u;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+
+	return h ? h : 1;
+}
+
+static void *xcalloc(size_t n, size_t size)
+{
+	void *p = calloc(n, size);
+	if (!p) {
+		perror("calloc");
+		exit(1);
+	}
+	return p;
+}
+
+static uint32_t arena_put(HashTable *ht, const char *key)
+{
+	size_t len = strlen(key) + 1;
+
+	if (ht->arena_len + len > ht->arena_cap) {
+		size_t cap = ht->arena_cap ? ht->arena_cap : 256;
+		while (ht->arena_len + len > cap)
+			cap *= 2;
+		char *p = realloc(ht->arena, cap);
+		if (!p) {
+			perror("realloc");
+			exit(1);
+		}
+		ht->arena = p;
+		ht->arena_cap = cap;
+	}
+
+	uint32_t off = (uint32_t)ht->arena_len;
+	memcpy(ht->arena + off, key, len);
+	ht->arena_len += len;
+	return off;
+}
+
+static uint32_t probe_dist(const HashTable *ht, uint32_t hash, uint32_t pos)
+{
+	return (pos - (hash & ht->mask)) & ht->mask;
+}
+
+/* 放入一个已知不存在的键（键已在 arena 中） */
+static void place(HashTable *ht, HashSlot s)
+{
+	uint32_t pos = s.hash & ht->mask, dist = 0;
 
-	return hash;
+	for (;;) {
+		HashSlot *cur = &ht->slots[pos];
+		if (!cur->hash) {
+			*cur = s;
+			ht->count++;
+			return;
+		}
+		uint32_t cd = probe_dist(ht, cur->hash, pos);
+		if (cd < dist) {
+			HashSlot t = *cur;
+			*cur = s;
+			s = t;
+			dist = cd;
+		}
+		pos = (pos + 1) & ht->mask;
+		dist++;
+	}
+}
+
+/* 重新分配槽位，同时把仍在使用的键搬进新的紧凑 arena */
+static void rehash(HashTable *ht, uint32_t capacity)
+{
+	HashSlot *old = ht->slots;
+	uint32_t old_cap = old ? ht->mask + 1 : 0;
+	char *old_arena = ht->arena;
+
+	ht->slots = xcalloc(capacity, sizeof(HashSlot));
+	ht->mask = capacity - 1;
+	ht->count = 0;
+	ht->arena = NULL;
+	ht->arena_cap = ht->arena_len - ht->arena_dead;
+	ht->arena_len = 0;
+	ht->arena_dead = 0;
+	if (ht->arena_cap) {
+		ht->arena = malloc(ht->arena_cap);
+		if (!ht->arena) {
+			perror("malloc");
+			exit(1);
+		}
+	}
+
+	for (uint32_t i = 0; i < old_cap; ++i) {
+		if (!old[i].hash)
+			continue;
+		HashSlot s = old[i];
+		s.key_off = arena_put(ht, old_arena + old[i].key_off);
+		place(ht, s);
+	}
+
+	free(old);
+	free(old_arena);
+}
+
+static uint32_t round_capacity(int n)
+{
+	uint32_t cap = HT_MIN_CAPACITY;
+	while (cap < (uint32_t)n)
+		cap <<= 1;
+	return cap;
+}
+
+/* 返回键所在槽位，不存在返回 -1 */
+static long lookup(const HashTable *ht, const char *key, uint32_t hash)
+{
+	uint32_t pos = hash & ht->mask, dist = 0;
+
+	for (;;) {
+		const HashSlot *cur = &ht->slots[pos];
+		if (!cur->hash || probe_dist(ht, cur->hash, pos) < dist)
+			return -1;
+		if (cur->hash == hash && strcmp(ht->arena + cur->key_off, key) == 0)
+			return (long)pos;
+		pos = (pos + 1) & ht->mask;
+		dist++;
+	}
 }
 
 HashTable *ht_create(int buckets)
 {
 	HashTable *ht = malloc(sizeof(HashTable));
 	if (!ht) { perror("malloc"); return NULL; }
-	ht->bucket_count = buckets;
-	ht->buckets = calloc(buckets, sizeof(HashNode*));
-	if (!ht->buckets) { free(ht); perror("calloc"); return NULL; }
+	memset(ht, 0, sizeof(*ht));
+	uint32_t cap = round_capacity(buckets);
+	ht->slots = xcalloc(cap, sizeof(HashSlot));
+	ht->mask = cap - 1;
 	return ht;
 }
 
@@ -40,17 +183,8 @@ void ht_free(HashTable *ht)
 	if (!ht)
 		return;
 
-	for (int i = 0; i < ht->bucket_count; ++i) {
-		HashNode *n = ht->buckets[i];
-		while (n) {
-			HashNode *t = n->next;
-			free(n->key);
-			free(n);
-			n = t;
-		}
-	}
-
-	free(ht->buckets);
+	free(ht->slots);
+	free(ht->arena);
 	free(ht);
 }
 
@@ -59,16 +193,20 @@ void ht_clear(HashTable *ht)
 	if (!ht)
 		return;
 
-	for (int i = 0; i < ht->bucket_count; ++i) {
-		HashNode *n = ht->buckets[i];
-		while (n) {
-			HashNode *t = n->next;
-			free(n->key);
-			free(n);
-			n = t;
-		}
-		ht->buckets[i] = NULL;
-	}
+	memset(ht->slots, 0, sizeof(HashSlot) * (ht->mask + 1));
+	ht->count = 0;
+	ht->arena_len = 0;
+	ht->arena_dead = 0;
+}
+
+void ht_reserve(HashTable *ht, int n)
+{
+	if (!ht || n <= 0)
+		return;
+
+	uint32_t need = round_capacity(n + n / 7 + 1);
+	if (need > ht->mask + 1)
+		rehash(ht, need);
 }
 
 void ht_insert(HashTable *ht, const char *key, int idx)
@@ -76,15 +214,21 @@ void ht_insert(HashTable *ht, const char *key, int idx)
 	if (!ht || !key)
 		return;
 
-	unsigned long h = hash_str(key) % ht->bucket_count;
-	HashNode *n = malloc(sizeof(HashNode));
-	if (!n)
+	uint32_t h = hash_str(key);
+	long pos = lookup(ht, key, h);
+	if (pos >= 0) {
+		ht->slots[pos].idx = idx;
 		return;
+	}
+
+	if ((ht->count + 1) * 8 > (ht->mask + 1) * 7)
+		rehash(ht, (ht->mask + 1) * 2);
 
-	n->key = strdup(key);
-	n->idx = idx;
-	n->next = ht->buckets[h];
-	ht->buckets[h] = n;
+	HashSlot s;
+	s.hash = h;
+	s.key_off = arena_put(ht, key);
+	s.idx = idx;
+	place(ht, s);
 }
 
 int ht_find(HashTable *ht, const char *key)
@@ -92,14 +236,118 @@ int ht_find(HashTable *ht, const char *key)
 	if (!ht || !key)
 		return -1;
 
-	unsigned long h = hash_str(key) % ht->bucket_count;
-	HashNode *n = ht->buckets[h];
+	long pos = lookup(ht, key, hash_str(key));
+	return pos >= 0 ? ht->slots[pos].idx : -1;
+}
+
+int ht_update(HashTable *ht, const char *key, int idx)
+{
+	if (!ht || !key)
+		return -1;
+
+	long pos = lookup(ht, key, hash_str(key));
+	if (pos < 0)
+		return -1;
+
+	ht->slots[pos].idx = idx;
+	return 0;
+}
+
+int ht_remove(HashTable *ht, const char *key)
+{
+	if (!ht || !key)
+		return -1;
+
+	long found = lookup(ht, key, hash_str(key));
+	if (found < 0)
+		return -1;
 
-	while (n) {
-		if (strcmp(n->key, key) == 0)
-			return n->idx;
-		n = n->next;
+	uint32_t pos = (uint32_t)found;
+	ht->arena_dead += strlen(ht->arena + ht->slots[pos].key_off) + 1;
+
+	/* 后继元素逐个前移，直到遇到空槽或已在理想位置的元素 */
+	for (;;) {
+		uint32_t next = (pos + 1) & ht->mask;
+		HashSlot *n = &ht->slots[next];
+		if (!n->hash || probe_dist(ht, n->hash, next) == 0)
+			break;
+		ht->slots[pos] = *n;
+		pos = next;
 	}
+	ht->slots[pos].hash = 0;
+	ht->count--;
+
+	if (ht->arena_dead > 4096 && ht->arena_dead * 2 > ht->arena_len)
+		rehash(ht, ht->mask + 1);
 
-	return -1;
-}
\ No newline at end of file
+	return 0;
+}
+
+int ht_count(HashTable *ht)
+{
+	return ht ? (int)ht->count : 0;
+}
+
+int ht_check_index(HashTable *ht, int n)
+{
+	for (uint32_t i = 0; i <= ht->mask; ++i)
+		if (ht->slots[i].hash && (ht->slots[i].idx < 0 || ht->slots[i].idx >= n))
+			return -1;
+	return 0;
+}
+
+size_t ht_bytes(HashTable *ht)
+{
+	if (!ht)
+		return 0;
+
+	return sizeof(HashTable) + sizeof(HashSlot) * (ht->mask + 1) + ht->arena_cap;
+}
+
+void ht_snapshot_save(HashTable *ht, SnapWriter *w)
+{
+	snap_put_u64(w, ht->mask + 1);
+	snap_put_u64(w, ht->count);
+	snap_put_u64(w, ht->arena_len);
+	snap_put_u64(w, ht->arena_dead);
+	snap_write(w, ht->slots, sizeof(HashSlot) * (ht->mask + 1));
+	snap_write(w, ht->arena, ht->arena_len);
+}
+
+int ht_snapshot_load(HashTable *ht, SnapReader *r)
+{
+	size_t cap = snap_get_count(r, (size_t)1 << 31);
+	size_t count = snap_get_count(r, cap);
+	size_t len = snap_get_count(r, UINT32_MAX);
+	size_t dead = snap_get_count(r, len);
+	const HashSlot *slots = snap_read(r, sizeof(HashSlot) * cap);
+	const char *keys = snap_read(r, len);
+
+	if (r->err || cap < HT_MIN_CAPACITY || (cap & (cap - 1)) || (len && keys[len - 1]))
+		return -1;
+	for (size_t i = 0; i < cap; ++i)
+		if (slots[i].hash && slots[i].key_off >= len)
+			return -1;
+
+	if (cap != ht->mask + 1) {
+		free(ht->slots);
+		ht->slots = xcalloc(cap, sizeof(HashSlot));
+		ht->mask = (uint32_t)cap - 1;
+	}
+	memcpy(ht->slots, slots, sizeof(HashSlot) * cap);
+	if (len > ht->arena_cap) {
+		free(ht->arena);
+		ht->arena = malloc(len);
+		if (!ht->arena) {
+			perror("malloc");
+			exit(1);
+		}
+		ht->arena_cap = len;
+	}
+	if (len)
+		memcpy(ht->arena, keys, len);
+	ht->count = (uint32_t)count;
+	ht->arena_len = len;
+	ht->arena_dead = dead;
+	return 0;
+}
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "intern.h"
+#include "hash.h"
+
+#define HASH_BUCKETS 1031
+
+/* 字符串连续存放在 text 中，offs[id] 为第 id 个字符串的起始偏移；hash 表把字符串映射回编号 */
+struct StrPool {
+	HashTable *ht;
+	char *text;
+	size_t text_len;
+	size_t text_cap;
+	size_t *offs;
+	int count;
+	int capacity;
+};
+
+static void *xrealloc(void *p, size_t n)
+{
+	p = realloc(p, n);
+	if (!p) {
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+StrPool *strpool_create(void)
+{
+	StrPool *p = calloc(1, sizeof(StrPool));
+	if (!p) {
+		perror("calloc");
+		return NULL;
+	}
+	p->ht = ht_create(HASH_BUCKETS);
+	return p;
+}
+
+void strpool_free(StrPool *p)
+{
+	if (!p)
+		return;
+
+	ht_free(p->ht);
+	free(p->text);
+	free(p->offs);
+	free(p);
+}
+
+void strpool_clear(StrPool *p)
+{
+	if (!p)
+		return;
+
+	ht_clear(p->ht);
+	p->text_len = 0;
+	p->count = 0;
+}
+
+int strpool_find(StrPool *p, const char *s)
+{
+	return (p && s) ? ht_find(p->ht, s) : -1;
+}
+
+int strpool_intern(StrPool *p, const char *s)
+{
+	if (!p || !s)
+		return -1;
+
+	int id = ht_find(p->ht, s);
+	if (id != -1)
+		return id;
+
+	size_t len = strlen(s) + 1;
+	if (p->text_len + len > p->text_cap) {
+		size_t cap = p->text_cap ? p->text_cap : 1024;
+		while (p->text_len + len > cap)
+			cap *= 2;
+		p->text = xrealloc(p->text, cap);
+		p->text_cap = cap;
+	}
+	if (p->count >= p->capacity) {
+		p->capacity = p->capacity ? p->capacity * 2 : 64;
+		p->offs = xrealloc(p->offs, sizeof(size_t) * p->capacity);
+	}
+
+	id = p->count++;
+	p->offs[id] = p->text_len;
+	memcpy(p->text + p->text_len, s, len);
+	p->text_len += len;
+	ht_insert(p->ht, s, id);
+	return id;
+}
+
+const char *strpool_get(StrPool *p, int id)
+{
+	if (!p || id < 0 || id >= p->count)
+		return "";
+	return p->text + p->offs[id];
+}
+
+int strpool_count(StrPool *p)
+{
+	return p ? p->count : 0;
+}
+
+size_t strpool_bytes(StrPool *p)
+{
+	if (!p)
+		return 0;
+
+	return sizeof(StrPool) + p->text_cap + sizeof(size_t) * p->capacity + ht_bytes(p->ht);
+}
+
+void strpool_snapshot_save(StrPool *p, SnapWriter *w)
+{
+	snap_put_u64(w, (uint64_t)p->count);
+	snap_put_u64(w, p->text_len);
+	snap_write(w, p->offs, sizeof(size_t) * p->count);
+	snap_write(w, p->text, p->text_len);
+	ht_snapshot_save(p->ht, w);
+}
+
+int strpool_snapshot_load(StrPool *p, SnapReader *r)
+{
+	size_t count = snap_get_count(r, INT32_MAX);
+	size_t len = snap_get_count(r, SIZE_MAX / 2);
+	const size_t *offs = snap_read(r, sizeof(size_t) * count);
+	const char *text = snap_read(r, len);
+
+	if (r->err || (len && text[len - 1]))
+		return -1;
+	for (size_t i = 0; i < count; ++i)
+		if (offs[i] >= len)
+			return -1;
+
+	if (len > p->text_cap) {
+		p->text = xrealloc(p->text, len);
+		p->text_cap = len;
+	}
+	if ((int)count > p->capacity) {
+		p->offs = xrealloc(p->offs, sizeof(size_t) * count);
+		p->capacity = (int)count;
+	}
+	if (len)
+		memcpy(p->text, text, len);
+	if (count)
+		memcpy(p->offs, offs, sizeof(size_t) * count);
+	p->text_len = len;
+	p->count = (int)count;
+	if (ht_snapshot_load(p->ht, r) != 0 || ht_check_index(p->ht, p->count) != 0)
+		return -1;
+	return 0;
+}
@@ -5,6 +5,8 @@
 #include "train.h"
 #include "passenger.h"
 #include "booking.h"
+#include "wal.h"
+#include "snapshot.h"
 
 static void input_line(const char *prompt, char *buf, size_t buflen)
 {
@@ -29,6 +31,28 @@ static double input_double(const char *prompt)
 	return atof(buf);
 }
 
+/* 按乘客（证件号或姓名）或车次+日期查订单，走二级索引 */
+static void print_booking_hits(BookingList *BL, const char *passenger, const char *train_id, const char *date)
+{
+	int n = passenger ? booking_find_by_passenger(BL, passenger, NULL, 0)
+			  : booking_find_by_train_date(BL, train_id, date, NULL, 0);
+	if (!n) {
+		puts("未找到");
+		return;
+	}
+
+	Booking *hits = malloc(sizeof(Booking) * n);
+	if (!hits)
+		return;
+	int m = passenger ? booking_find_by_passenger(BL, passenger, hits, n)
+			  : booking_find_by_train_date(BL, train_id, date, hits, n);
+	if (m < n)
+		n = m;
+	for (int i = 0; i < n; ++i)
+		printf("订单:%s  %s->%s  %s\n", hits[i].order_id, hits[i].from, hits[i].to, hits[i].seat_no);
+	free(hits);
+}
+
 /* menus */
 int main_menu()
 {
@@ -38,6 +62,8 @@ int main_menu()
 	puts("3. 订票信息管理");
 	puts("4. 保存所有数据");
 	puts("5. 载入所有数据");
+	puts("6. 导出为文本文件（trains/passengers/bookings.txt）");
+	puts("7. 从文本文件导入");
 	puts("0. 退出");
 	return input_int("请选择: ");
 }
@@ -50,6 +76,7 @@ int train_menu()
 	puts("3. 修改车次信息");
 	puts("4. 查询（按车次）");
 	puts("5. 输出所有车次");
+	puts("6. 按起止站查询");
 	puts("0. 返回");
 	return input_int("选择: ");
 }
@@ -72,15 +99,31 @@ int booking_menu()
 	puts("1. 订票");
 	puts("2. 退票（按订单号）");
 	puts("3. 订单查询（按订单号）");
-	puts("4. 订单查询（按姓名）");
+	puts("4. 订单查询（按姓名/证件号）");
 	puts("5. 订单查询（按车次+日期）");
 	puts("6. 余票查询（按车次+日期）");
 	puts("7. 输出所有订单");
+	puts("8. 订单统计（按车次/日期/等级分组）");
 	puts("0. 返回");
 	return input_int("选择: ");
 }
 
+#define WAL_FILE "bookings.wal"
+#define SNAPSHOT_FILE "data.snap"
+
+/* 修改都已在日志里时只落盘日志，否则重写快照（见 save_snapshot_incremental） */
 void save_all(TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	int res = save_snapshot_incremental(SNAPSHOT_FILE, TL, PL, BL);
+	if (res == SNAPSHOT_LOGGED)
+		printf("已保存（改动已在 %s 中，未重写快照）\n", WAL_FILE);
+	else if (res == SNAPSHOT_WRITTEN)
+		printf("已保存 %s\n", SNAPSHOT_FILE);
+	else
+		printf("保存 %s 失败\n", SNAPSHOT_FILE);
+}
+
+void export_text(TrainList *TL, PassengerList *PL, BookingList *BL)
 {
 	if (save_trains("trains.txt", TL))
 		printf("已保存 trains.txt\n");
@@ -98,8 +141,20 @@ void save_all(TrainList *TL, PassengerList *PL, BookingList *BL)
 		printf("保存 bookings.txt 失败\n");
 }
 
-void load_all(TrainList *TL, PassengerList *PL, BookingList *BL)
+static void reset_all(TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	trainlist_free(TL);
+	passengerlist_free(PL);
+	bookinglist_free(BL);
+	trainlist_init(TL);
+	passengerlist_init(PL);
+	bookinglist_init(BL);
+}
+
+void import_text(TrainList *TL, PassengerList *PL, BookingList *BL)
 {
+	reset_all(TL, PL, BL);
+
 	if (load_trains("trains.txt", TL))
 		printf("已载入 trains.txt\n");
 	else
@@ -110,12 +165,27 @@ void load_all(TrainList *TL, PassengerList *PL, BookingList *BL)
 	else
 		printf("未找到 passengers.txt 或载入失败\n");
 
-	if (load_bookings("bookings.txt", BL, TL))
+	if (load_bookings_parallel("bookings.txt", BL, TL, 0))
 		printf("已载入 bookings.txt 并重建座位占用\n");
 	else
 		printf("未找到 bookings.txt 或载入失败\n");
 }
 
+/* 优先载入二进制快照，没有或无效时从文本文件导入；随后重放快照之后的日志，并归档今天以前的座位图 */
+void load_all(TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	reset_all(TL, PL, BL);
+	if (load_snapshot(SNAPSHOT_FILE, TL, PL, BL))
+		printf("已载入 %s\n", SNAPSHOT_FILE);
+	else
+		import_text(TL, PL, BL);
+
+	int n = wal_replay(WAL_FILE, TL, PL, BL);
+	if (n > 0)
+		printf("已从 %s 重放 %d 条操作\n", WAL_FILE, n);
+	train_evict_past(TL);
+}
+
 int main(void)
 {
 	TrainList TL;
@@ -127,6 +197,8 @@ int main(void)
 	bookinglist_init(&BL);
 
 	load_all(&TL, &PL, &BL);
+	if (wal_open(WAL_FILE) != 0)
+		printf("无法打开 %s，本次运行的操作只在保存时落盘\n", WAL_FILE);
 
 	for (;;) {
 		int ch = main_menu();
@@ -214,6 +286,29 @@ int main(void)
 					}
 				} else if (c == 5) {
 					train_list_all(&TL);
+				} else if (c == 6) {
+					char from[STATION_LEN], to[STATION_LEN], date[DATE_LEN];
+					input_line("出发站: ", from, sizeof(from));
+					input_line("到达站: ", to, sizeof(to));
+					input_line("日期(YYYY-MM-DD，回车不查余票): ", date, sizeof(date));
+					int n = train_find_between(&TL, from, to, strlen(date) ? date : NULL, NULL, 0);
+					if (n <= 0) {
+						puts(n < 0 ? "日期无效" : "未找到");
+						continue;
+					}
+					TrainMatch *hits = malloc(sizeof(TrainMatch) * n);
+					if (!hits)
+						continue;
+					int m = train_find_between(&TL, from, to, strlen(date) ? date : NULL, hits, n);
+					if (m < n)
+						n = m;
+					for (int i = 0; i < n; ++i) {
+						printf("车次: %s  %s %s -> %s %s", hits[i].train_id, from, hits[i].depart, to, hits[i].arrive);
+						if (strlen(date))
+							printf("  余票: %d/%d/%d/%d", hits[i].remaining[0], hits[i].remaining[1], hits[i].remaining[2], hits[i].remaining[3]);
+						putchar('\n');
+					}
+					free(hits);
 				} else {
 					puts("无效选项");
 				}
@@ -232,13 +327,21 @@ int main(void)
 					input_line("手机号: ", p.phone, sizeof(p.phone));
 					input_line("紧急联系人: ", p.emergency_contact, sizeof(p.emergency_contact));
 					input_line("紧急联系人电话: ", p.emergency_phone, sizeof(p.emergency_phone));
-					passenger_add(&PL, &p);
-					puts("添加成功");
+					int res = passenger_add(&PL, &p);
+					if (res == ERR_BAD_FIELD)
+						puts("各项不能包含 |");
+					else if (res == ERR_NOT_DURABLE)
+						puts("已添加，但写日志失败，请尽快保存（菜单 4）");
+					else
+						puts("添加成功");
 				} else if (c == 2) {
 					char id[ID_LEN];
 					input_line("证件号: ", id, sizeof(id));
-					if (passenger_delete(&PL, id) == 0)
+					int res = passenger_delete(&PL, id);
+					if (res == 0)
 						puts("删除成功");
+					else if (res == ERR_NOT_DURABLE)
+						puts("已删除，但写日志失败，请尽快保存（菜单 4）");
 					else
 						puts("未找到");
 				} else if (c == 3) {
@@ -260,8 +363,13 @@ int main(void)
 					input_line("紧急联系人电话（回车保留）: ", buf, sizeof(buf));
 					if (strlen(buf))
 						strncpy(p.emergency_phone, buf, sizeof(p.emergency_phone)-1);
-					passenger_update(&PL, id, &p);
-					puts("修改成功");
+					int res = passenger_update(&PL, id, &p);
+					if (res == ERR_BAD_FIELD)
+						puts("各项不能包含 |");
+					else if (res == ERR_NOT_DURABLE)
+						puts("已修改，但写日志失败，请尽快保存（菜单 4）");
+					else
+						puts("修改成功");
 				} else if (c == 4) {
 					char id[ID_LEN];
 					input_line("证件号: ", id, sizeof(id));
@@ -295,10 +403,14 @@ int main(void)
 					int res = booking_create(&BL, &TL, &PL, date, train_id, from, to, pid, cls, orderid, sizeof(orderid));
 					if (res == 0)
 						printf("订票成功，订单号: %s\n", orderid);
+					else if (res == ERR_NOT_DURABLE)
+						printf("已订票（订单号: %s），但写日志失败，请尽快保存（菜单 4）\n", orderid);
 					else if (res == -1)
 						puts("乘客不存在");
 					else if (res == -2)
 						puts("无余票/分配失败");
+					else if (res == ERR_BAD_FIELD)
+						puts("车次、站名与日期不能包含 |");
 					else
 						puts("订票失败");
 				} else if (c == 2) {
@@ -307,6 +419,8 @@ int main(void)
 					int res = booking_cancel(&BL, oid, &TL);
 					if (res == 0)
 						puts("退票成功");
+					else if (res == ERR_NOT_DURABLE)
+						puts("已退票，但写日志失败，请尽快保存（菜单 4）");
 					else if (res == -1)
 						puts("未找到订单");
 					else if (res == -2)
@@ -316,59 +430,68 @@ int main(void)
 				} else if (c == 3) {
 					char oid[ORDER_ID_LEN];
 					input_line("订单号: ", oid, sizeof(oid));
-					int idx = booking_find_index(&BL, oid);
-					if (idx == -1)
+					Booking bk, *b = &bk;
+					if (booking_get(&BL, booking_find_index(&BL, oid), b) != 0)
 						puts("未找到订单");
 					else {
-						Booking *b = &BL.data[idx];
 						printf("订单号:%s  乘客:%s  日期:%s  车次:%s  %s->%s  座位:%s  状态:%s\n",
 							   b->order_id, b->passenger_name, b->date, b->train_id, b->from, b->to, b->seat_no, b->canceled ? "已退票":"已出票");
 					}
 				} else if (c == 4) {
 					char name[NAME_LEN];
 					input_line("姓名: ", name, sizeof(name));
-					int found = 0;
-					for (int i = 0; i < BL.size; ++i)
-						if (strcmp(BL.data[i].passenger_name, name) == 0) {
-							printf("订单:%s  %s->%s  %s\n", BL.data[i].order_id, BL.data[i].from, BL.data[i].to, BL.data[i].seat_no);
-							found++;
-						}
-					if (!found)
-						puts("未找到");
+					print_booking_hits(&BL, name, NULL, NULL);
 				} else if (c == 5) {
 					char train_id[ID_LEN], date[DATE_LEN];
 					input_line("车次号: ", train_id, sizeof(train_id));
 					input_line("日期(YYYY-MM-DD): ", date, sizeof(date));
-					int found = 0;
-					for (int i = 0; i < BL.size; ++i)
-						if (strcmp(BL.data[i].train_id, train_id) == 0 && strcmp(BL.data[i].date, date) == 0) {
-							printf("订单:%s  %s->%s  %s\n", BL.data[i].order_id, BL.data[i].from, BL.data[i].to, BL.data[i].seat_no);
-							found++;
-						}
-					if (!found)
-						puts("未找到");
+					print_booking_hits(&BL, NULL, train_id, date);
 				} else if (c == 6) {
-					char train_id[ID_LEN], date[DATE_LEN];
+					char train_id[ID_LEN], date[DATE_LEN], from[STATION_LEN], to[STATION_LEN];
 					input_line("车次号: ", train_id, sizeof(train_id));
 					input_line("日期(YYYY-MM-DD): ", date, sizeof(date));
 					int idx = train_find_index(&TL, train_id);
 					if (idx == -1) { puts("未找到车次"); continue; }
 					Train *t = train_get(&TL, idx);
-					printf("车次 %s 在 %s 的余票（按等级）:\n", train_id, date);
+					if (t->stop_count < 2) { puts("车次无停靠站"); continue; }
+					input_line("起点站（回车为始发站）: ", from, sizeof(from));
+					input_line("终点站（回车为终到站）: ", to, sizeof(to));
+					if (!strlen(from))
+						snprintf(from, sizeof(from), "%s", t->stops[0].name);
+					if (!strlen(to))
+						snprintf(to, sizeof(to), "%s", t->stops[t->stop_count-1].name);
+					int fi = train_find_stop_idx(t, from), ti = train_find_stop_idx(t, to);
+					if (fi < 0 || ti < 0 || fi >= ti) { puts("站名无效"); continue; }
+					if (train_date_to_day(date) < 0) { puts("日期无效"); continue; }
+					printf("车次 %s 在 %s 的余票 %s->%s（按等级）:\n", train_id, date, from, to);
 					for (int cls = 0; cls < 4; ++cls) {
-						/* 计算被占用座位数（通过扫描 booking list，以保持主程序简洁） */
-						int used = 0;
-						for (int i = 0; i < BL.size; ++i) {
-							if (!BL.data[i].canceled && strcmp(BL.data[i].train_id, train_id)==0 && strcmp(BL.data[i].date, date)==0 && BL.data[i].seat_class==cls)
-								used++;
-						}
-						int remain = t->seat_count[cls] - used;
-						if (remain < 0)
-							remain = 0;
+						int remain = train_remaining_seats(&TL, train_id, date, from, to, cls);
+						if (remain < 0) { puts("  该日期不可查询（已归档，或日历槽被另一个未来日期占着）"); break; }
 						printf("  等级 %d: %d / %d\n", cls, remain, t->seat_count[cls]);
 					}
 				} else if (c == 7) {
 					booking_list_all(&BL);
+				} else if (c == 8) {
+					char by[16];
+					int group_by = 0;
+					input_line("分组（t=车次 d=日期 c=等级，可组合，回车为合计）: ", by, sizeof(by));
+					if (strchr(by, 't')) group_by |= BOOKING_BY_TRAIN;
+					if (strchr(by, 'd')) group_by |= BOOKING_BY_DATE;
+					if (strchr(by, 'c')) group_by |= BOOKING_BY_CLASS;
+					int n = booking_aggregate(&BL, group_by, BOOKING_AGG_ACTIVE, NULL, 0);
+					BookingAggRow *rows = malloc(sizeof(BookingAggRow) * (n > 0 ? n : 1));
+					int m = booking_aggregate(&BL, group_by, BOOKING_AGG_ACTIVE, rows, n);
+					if (m < n)
+						n = m;
+					printf("有效订单统计（%d 组）:\n", n);
+					for (int i = 0; i < n; ++i) {
+						BookingAggRow *r = &rows[i];
+						printf("  %s %s", r->train_id, r->date);
+						if (r->seat_class >= 0)
+							printf(" 等级%d", r->seat_class);
+						printf("  张数:%lld  票款:%.2f  座·段:%lld\n", r->count, r->revenue_cents / 100.0, r->segments);
+					}
+					free(rows);
 				} else {
 					puts("无效选项");
 				}
@@ -377,11 +500,18 @@ int main(void)
 			save_all(&TL, &PL, &BL);
 		} else if (ch == 5) {
 			load_all(&TL, &PL, &BL);
+		} else if (ch == 6) {
+			export_text(&TL, &PL, &BL);
+		} else if (ch == 7) {
+			import_text(&TL, &PL, &BL);
+			train_evict_past(&TL);
+			puts("导入的数据在保存（4）之后才会写入快照");
 		} else {
 			puts("无效选项");
 		}
 	}
 
+	wal_close();
 	trainlist_free(&TL);
 	passengerlist_free(&PL);
 	bookinglist_free(&BL);
@@ -4,21 +4,32 @@
 #include <string.h>
 #include "passenger.h"
 #include "hash.h"
+#include "scan.h"
+#include "sync.h"
+#include "wal.h"
 
 #define INITIAL_CAPACITY 8
 #define HASH_BUCKETS 1031
 
 static HashTable *passenger_ht = NULL;
+static SyncRWLock *passenger_lock = NULL;
+/* 日志之外的修改计数：清空、载入文本，以及日志未打开时的增删改 */
+static volatile int64_t passenger_version_seq = 0;
 static void *xmalloc(size_t n) { void *p = malloc(n); if (!p) { perror("malloc"); exit(1);} return p; }
 
 void passengerlist_init(PassengerList *L)
 {
+	sync_fetch_add64(&passenger_version_seq, 1);
 	L->data = xmalloc(sizeof(Passenger) * INITIAL_CAPACITY);
 	L->size = 0;
 	L->capacity = INITIAL_CAPACITY;
 
 	if (!passenger_ht)
 		passenger_ht = ht_create(HASH_BUCKETS);
+	else
+		ht_clear(passenger_ht);
+	if (!passenger_lock)
+		passenger_lock = sync_rwlock_create();
 }
 
 void passengerlist_free(PassengerList *L)
@@ -26,6 +37,7 @@ void passengerlist_free(PassengerList *L)
 	if (!L)
 		return;
 
+	sync_fetch_add64(&passenger_version_seq, 1);
 	free(L->data);
 	L->data = NULL;
 	L->size = L->capacity = 0;
@@ -34,6 +46,9 @@ void passengerlist_free(PassengerList *L)
 		ht_free(passenger_ht);
 		passenger_ht = NULL;
 	}
+
+	sync_rwlock_free(passenger_lock);
+	passenger_lock = NULL;
 }
 
 static void passengerlist_expand(PassengerList *L)
@@ -43,65 +58,244 @@ static void passengerlist_expand(PassengerList *L)
 	if (!L->data) { perror("realloc"); exit(1); }
 }
 
-static void rebuild(PassengerList *L)
+/*
+ * 索引随增删改增量维护。证件号重复时索引指向下标最大的那一个；
+ * 被删除/改号的乘客若正是索引指向的那个，就从剩下的乘客里找同号者补上。
+ */
+static void index_drop(PassengerList *L, const char *id_num, int idx)
 {
-	if (!passenger_ht)
-		passenger_ht = ht_create(HASH_BUCKETS);
-	else
-		ht_clear(passenger_ht);
+	if (ht_find(passenger_ht, id_num) != idx)
+		return;
+
+	ht_remove(passenger_ht, id_num);
+	for (int i = L->size - 1; i >= 0; --i) {
+		if (i != idx && strcmp(L->data[i].id_num, id_num) == 0) {
+			ht_insert(passenger_ht, id_num, i);
+			break;
+		}
+	}
+}
+
+/* data[idx] 已被删除、其后元素前移一位之后调用；id_num 为被删证件号的副本 */
+static void index_erase_shift(PassengerList *L, const char *id_num, int idx)
+{
+	index_drop(L, id_num, idx);
+
+	for (int i = idx; i < L->size; ++i)
+		if (ht_find(passenger_ht, L->data[i].id_num) == i + 1)
+			ht_update(passenger_ht, L->data[i].id_num, i);
+}
+
+static int find_index(PassengerList *L, const char *id_num)
+{
+	if (passenger_ht)
+		return ht_find(passenger_ht, id_num);
 
 	for (int i = 0; i < L->size; ++i)
-		ht_insert(passenger_ht, L->data[i].id_num, i);
+		if (strcmp(L->data[i].id_num, id_num) == 0)
+			return i;
+
+	return -1;
 }
 
-int passenger_add(PassengerList *L, Passenger *p)
+/* 按 passengers.txt 的一行格式化，供保存与日志共用 */
+static void format_passenger(char *out, size_t outlen, const Passenger *p)
+{
+	snprintf(out, outlen, "%s|%s|%s|%s|%s|%s",
+	         p->id_type, p->id_num, p->name, p->phone, p->emergency_contact, p->emergency_phone);
+}
+
+/* 各字段都能原样写进一行记录 */
+static int fields_ok(const Passenger *p)
+{
+	return scan_field_ok(p->id_type) && scan_field_ok(p->id_num) && scan_field_ok(p->name) &&
+	       scan_field_ok(p->phone) && scan_field_ok(p->emergency_contact) && scan_field_ok(p->emergency_phone);
+}
+
+/* 从扫描器的当前行读出 format_passenger 的各字段；字段不足时记错返回 -1 */
+static int parse_passenger(Scanner *s, Passenger *pp)
+{
+	memset(pp, 0, sizeof(*pp));
+	scan_str(s, pp->id_type, sizeof(pp->id_type));
+	scan_str(s, pp->id_num, sizeof(pp->id_num));
+	scan_str(s, pp->name, sizeof(pp->name));
+	scan_str(s, pp->phone, sizeof(pp->phone));
+	scan_str(s, pp->emergency_contact, sizeof(pp->emergency_contact));
+	scan_str(s, pp->emergency_phone, sizeof(pp->emergency_phone));
+	return s->err ? -1 : 0;
+}
+
+static void add_locked(PassengerList *L, const Passenger *p)
 {
 	if (L->size >= L->capacity)
 		passengerlist_expand(L);
 
-	L->data[L->size++] = *p;
-	rebuild(L);
-	return 0;
+	L->data[L->size] = *p;
+	ht_insert(passenger_ht, p->id_num, L->size);
+	L->size++;
+}
+
+static void delete_locked(PassengerList *L, int idx)
+{
+	char key[sizeof(L->data[idx].id_num)];
+	memcpy(key, L->data[idx].id_num, sizeof(key));
+
+	memmove(&L->data[idx], &L->data[idx + 1], sizeof(Passenger) * (L->size - idx - 1));
+	L->size--;
+	index_erase_shift(L, key, idx);
+}
+
+static void update_locked(PassengerList *L, int idx, const Passenger *pnew)
+{
+	if (strcmp(L->data[idx].id_num, pnew->id_num) != 0) {
+		char key[sizeof(L->data[idx].id_num)];
+		memcpy(key, L->data[idx].id_num, sizeof(key));
+
+		L->data[idx] = *pnew;
+		index_drop(L, key, idx);
+		ht_insert(passenger_ht, pnew->id_num, idx);
+	} else {
+		L->data[idx] = *pnew;
+	}
+}
+
+/* 增删改在写锁内追加日志记录，释放锁后再等落盘，并发请求可共用一次 fsync */
+int passenger_add(PassengerList *L, Passenger *p)
+{
+	char rec[512] = "P|";
+
+	if (!fields_ok(p))
+		return ERR_BAD_FIELD;
+	format_passenger(rec + 2, sizeof(rec) - 2, p);
+	sync_rwlock_wrlock(passenger_lock);
+	add_locked(L, p);
+	long long lsn = wal_append(rec);
+	if (!lsn)
+		sync_fetch_add64(&passenger_version_seq, 1);
+	sync_rwlock_wrunlock(passenger_lock);
+	return wal_commit(lsn) == 0 ? 0 : ERR_NOT_DURABLE;
 }
 
 int passenger_delete(PassengerList *L, const char *id_num)
 {
-	int idx = passenger_find_index(L, id_num);
-	if (idx == -1)
-		return -1;
+	char rec[ID_LEN + 8];
 
-	for (int i = idx; i < L->size - 1; ++i)
-		L->data[i] = L->data[i+1];
+	sync_rwlock_wrlock(passenger_lock);
+	int idx = find_index(L, id_num);
+	if (idx == -1) {
+		sync_rwlock_wrunlock(passenger_lock);
+		return -1;
+	}
 
-	L->size--;
-	rebuild(L);
-	return 0;
+	delete_locked(L, idx);
+	snprintf(rec, sizeof(rec), "D|%s", id_num);
+	long long lsn = wal_append(rec);
+	if (!lsn)
+		sync_fetch_add64(&passenger_version_seq, 1);
+	sync_rwlock_wrunlock(passenger_lock);
+	return wal_commit(lsn) == 0 ? 0 : ERR_NOT_DURABLE;
 }
 
 int passenger_update(PassengerList *L, const char *id_num, Passenger *pnew)
 {
-	int idx = passenger_find_index(L, id_num);
-	if (idx == -1)
+	char rec[600];
+
+	if (!scan_field_ok(id_num) || !fields_ok(pnew))
+		return ERR_BAD_FIELD;
+	int n = snprintf(rec, sizeof(rec), "U|%s|", id_num);
+	format_passenger(rec + n, sizeof(rec) - n, pnew);
+	sync_rwlock_wrlock(passenger_lock);
+	int idx = find_index(L, id_num);
+	if (idx == -1) {
+		sync_rwlock_wrunlock(passenger_lock);
 		return -1;
+	}
 
-	L->data[idx] = *pnew;
-	rebuild(L);
-	return 0;
+	update_locked(L, idx, pnew);
+	long long lsn = wal_append(rec);
+	if (!lsn)
+		sync_fetch_add64(&passenger_version_seq, 1);
+	sync_rwlock_wrunlock(passenger_lock);
+	return wal_commit(lsn) == 0 ? 0 : ERR_NOT_DURABLE;
 }
 
-int passenger_find_index(PassengerList *L, const char *id_num)
+/*
+ * 重放一条乘客日志记录（不再记日志）。快照可能已包含该操作，因此：
+ * P 证件号已存在时覆盖；U 原证件号不在而新证件号在时覆盖新证件号那条；D 不存在时跳过。
+ */
+int passenger_replay(PassengerList *L, const char *rec)
 {
-	if (passenger_ht) {
-		int idx = ht_find(passenger_ht, id_num);
-		if (idx != -1)
-			return idx;
+	Scanner sc;
+	Passenger p;
+	char old_id[sizeof(p.id_num)];
+	int idx, applied = 1;
+
+	if (strlen(rec) < 2 || rec[1] != '|')
+		return -1;
+	scan_init(&sc, rec + 2, strlen(rec + 2), 1);
+	scan_line(&sc);
+
+	sync_rwlock_wrlock(passenger_lock);
+	switch (rec[0]) {
+	case 'P':
+		if (parse_passenger(&sc, &p) != 0) {
+			applied = -1;
+			break;
+		}
+		idx = find_index(L, p.id_num);
+		if (idx == -1)
+			add_locked(L, &p);
+		else
+			L->data[idx] = p;
+		break;
+	case 'U':
+		if (scan_str(&sc, old_id, sizeof(old_id)) != 0 || parse_passenger(&sc, &p) != 0) {
+			applied = -1;
+			break;
+		}
+		idx = find_index(L, old_id);
+		if (idx == -1)
+			idx = find_index(L, p.id_num);
+		if (idx == -1)
+			applied = 0;
+		else
+			update_locked(L, idx, &p);
+		break;
+	case 'D':
+		idx = find_index(L, rec + 2);
+		if (idx == -1)
+			applied = 0;
+		else
+			delete_locked(L, idx);
+		break;
+	default:
+		applied = -1;
 	}
+	sync_rwlock_wrunlock(passenger_lock);
+	return applied;
+}
 
-	for (int i = 0; i < L->size; ++i)
-		if (strcmp(L->data[i].id_num, id_num) == 0)
-			return i;
+long long passenger_version(void)
+{
+	return sync_fetch_add64(&passenger_version_seq, 0);
+}
 
-	return -1;
+int passenger_find_index(PassengerList *L, const char *id_num)
+{
+	sync_rwlock_rdlock(passenger_lock);
+	int idx = find_index(L, id_num);
+	sync_rwlock_rdunlock(passenger_lock);
+	return idx;
+}
+
+int passenger_copy(PassengerList *L, const char *id_num, Passenger *out)
+{
+	sync_rwlock_rdlock(passenger_lock);
+	int idx = find_index(L, id_num);
+	if (idx != -1)
+		*out = L->data[idx];
+	sync_rwlock_rdunlock(passenger_lock);
+	return idx == -1 ? -1 : 0;
 }
 
 void passenger_list_all(PassengerList *L)
@@ -111,63 +305,100 @@ void passenger_list_all(PassengerList *L)
 		return;
 	}
 
+	sync_rwlock_rdlock(passenger_lock);
 	for (int i = 0; i < L->size; ++i) {
 		Passenger *p = &L->data[i];
 		printf("---- [%d] ----\n", i+1);
 		printf("姓名:%s  证件:%s(%s)  手机:%s  紧急联系人:%s(%s)\n",
 		       p->name, p->id_num, p->id_type, p->phone, p->emergency_contact, p->emergency_phone);
 	}
+	sync_rwlock_rdunlock(passenger_lock);
 }
 
 int save_passengers(const char *filename, PassengerList *L)
 {
-	FILE *f = fopen(filename, "w");
+	char tmp[FILENAME_MAX + 8];
+	FILE *f = file_replace_begin(filename, tmp, sizeof(tmp));
 	if (!f)
 		return 0;
 
+	sync_rwlock_rdlock(passenger_lock);
 	fprintf(f, "%d\n", L->size);
 	for (int i = 0; i < L->size; ++i) {
-		Passenger *p = &L->data[i];
-		fprintf(f, "%s|%s|%s|%s|%s|%s\n",
-		        p->id_type, p->id_num, p->name, p->phone, p->emergency_contact, p->emergency_phone);
+		char line[512];
+		format_passenger(line, sizeof(line), &L->data[i]);
+		fprintf(f, "%s\n", line);
 	}
-	fclose(f);
-	return 1;
+	sync_rwlock_rdunlock(passenger_lock);
+	return file_replace_commit(f, tmp, filename, !ferror(f));
 }
 
 int load_passengers(const char *filename, PassengerList *L)
 {
-	FILE *f = fopen(filename, "r");
-	if (!f)
+	MappedFile m;
+	Scanner sc;
+	int count = 0, ok = 1;
+
+	if (map_file(filename, &m) != 0)
 		return 0;
+	sync_fetch_add64(&passenger_version_seq, 1);
+	scan_init(&sc, m.p, m.len, 1);
+	if (!scan_line(&sc) || scan_int(&sc, &count) != 0 || count < 0) {
+		scan_fail(&sc, sc.line, "记录数无效");
+		ok = 0;
+	}
+
+	for (int i = 0; ok && i < count; ++i) {
+		Passenger pp;
+		if (!scan_line(&sc) || parse_passenger(&sc, &pp) != 0) {
+			ok = 0;
+			break;
+		}
+		sync_rwlock_wrlock(passenger_lock);
+		add_locked(L, &pp);
+		sync_rwlock_wrunlock(passenger_lock);
+	}
+
+	if (!ok)
+		scan_report(&sc, filename);
+	unmap_file(&m);
+	return ok;
+}
 
-	int count = 0;
-	if (fscanf(f, "%d\n", &count) != 1) { fclose(f); return 0; }
-	char line[512];
+void passenger_snapshot_save(PassengerList *L, SnapWriter *w)
+{
+	sync_rwlock_rdlock(passenger_lock);
+	snap_put_u64(w, (uint64_t)L->size);
+	snap_write(w, L->data, sizeof(Passenger) * L->size);
+	ht_snapshot_save(passenger_ht, w);
+	sync_rwlock_rdunlock(passenger_lock);
+}
 
-	for (int i = 0; i < count; ++i) {
-		if (!fgets(line, sizeof(line), f)) { fclose(f); return 0; }
-		size_t ln = strlen(line);
-		if (ln && line[ln-1]=='\n')
-			line[ln-1]=0;
+int passenger_snapshot_load(PassengerList *L, SnapReader *r)
+{
+	size_t n = snap_get_count(r, INT32_MAX);
+	const Passenger *src = snap_read(r, sizeof(Passenger) * n);
 
-		char *parts[6];
-		int p = 0;
-		char *tok = strtok(line, "|");
-		while (tok && p < 6) { parts[p++] = tok; tok = strtok(NULL, "|"); }
-		if (p < 6) { fclose(f); return 0; }
+	if (!src)
+		return -1;
 
-		Passenger pp;
-		memset(&pp, 0, sizeof(pp));
-		strncpy(pp.id_type, parts[0], sizeof(pp.id_type)-1);
-		strncpy(pp.id_num, parts[1], sizeof(pp.id_num)-1);
-		strncpy(pp.name, parts[2], sizeof(pp.name)-1);
-		strncpy(pp.phone, parts[3], sizeof(pp.phone)-1);
-		strncpy(pp.emergency_contact, parts[4], sizeof(pp.emergency_contact)-1);
-		strncpy(pp.emergency_phone, parts[5], sizeof(pp.emergency_phone)-1);
-		passenger_add(L, &pp);
+	sync_rwlock_wrlock(passenger_lock);
+	while ((size_t)L->capacity < n)
+		passengerlist_expand(L);
+	if (n)
+		memcpy(L->data, src, sizeof(Passenger) * n);
+	L->size = (int)n;
+	for (int i = 0; i < L->size; ++i) {
+		Passenger *p = &L->data[i];
+		p->id_type[sizeof(p->id_type) - 1] = 0;
+		p->id_num[ID_LEN - 1] = 0;
+		p->name[NAME_LEN - 1] = 0;
+		p->phone[sizeof(p->phone) - 1] = 0;
+		p->emergency_contact[NAME_LEN - 1] = 0;
+		p->emergency_phone[sizeof(p->emergency_phone) - 1] = 0;
 	}
-
-	fclose(f);
-	return 1;
-}
\ No newline at end of file
+	int res = ht_snapshot_load(passenger_ht, r) == 0 && ht_count(passenger_ht) <= L->size &&
+		  ht_check_index(passenger_ht, L->size) == 0 ? 0 : -1;
+	sync_rwlock_wrunlock(passenger_lock);
+	return res;
+}
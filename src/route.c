@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "route.h"
+#include "hash.h"
+
+#define HASH_BUCKETS 1031
+#define DAY_MINUTES 1440
+#define INF INT_MAX
+
+/*
+ * 连接：某车次（trip）从第 stop 站开到第 stop+1 站的一段。
+ * trip = 车次下标 * 2 + 日偏移（0 为查询当天，1 为次日），同一车次两天的班次互不相干。
+ */
+typedef struct {
+	int dep;
+	int arr;
+	int trip;
+	int from;
+	int to;
+	int stop;
+} Connection;
+
+struct Router {
+	HashTable *station_ht;
+	char (*stations)[STATION_LEN];
+	int nstations;
+	int station_cap;
+	char (*train_ids)[ID_LEN];
+	int ntrains;
+	Connection *conns;
+	int nconns;
+	int conn_cap;
+};
+
+static void *xrealloc(void *p, size_t n)
+{
+	p = realloc(p, n);
+	if (!p) {
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+int route_parse_time(const char *hhmm)
+{
+	int h, m;
+	char tail;
+
+	if (!hhmm || sscanf(hhmm, "%d:%d%c", &h, &m, &tail) != 2)
+		return -1;
+	if (h < 0 || h > 23 || m < 0 || m > 59)
+		return -1;
+
+	return h * 60 + m;
+}
+
+static int station_id(Router *r, const char *name)
+{
+	int id = ht_find(r->station_ht, name);
+	if (id != -1)
+		return id;
+
+	if (r->nstations >= r->station_cap) {
+		r->station_cap = r->station_cap ? r->station_cap * 2 : 64;
+		r->stations = xrealloc(r->stations, sizeof(*r->stations) * r->station_cap);
+	}
+	id = r->nstations++;
+	snprintf(r->stations[id], STATION_LEN, "%s", name);
+	ht_insert(r->station_ht, name, id);
+	return id;
+}
+
+static void add_connection(Router *r, const Connection *c)
+{
+	if (r->nconns >= r->conn_cap) {
+		r->conn_cap = r->conn_cap ? r->conn_cap * 2 : 1024;
+		r->conns = xrealloc(r->conns, sizeof(Connection) * r->conn_cap);
+	}
+	r->conns[r->nconns++] = *c;
+}
+
+static int conn_cmp(const void *a, const void *b)
+{
+	const Connection *x = a, *y = b;
+
+	if (x->dep != y->dep)
+		return x->dep < y->dep ? -1 : 1;
+	if (x->arr != y->arr)
+		return x->arr < y->arr ? -1 : 1;
+	if (x->trip != y->trip)
+		return x->trip < y->trip ? -1 : 1;
+	return x->stop - y->stop;
+}
+
+/*
+ * 求各站的绝对到/发分钟数（跨午夜时累加一天），缺失的到达/发车时间用另一项补齐；
+ * 首站发车时间缺失时用车次的 depart_time。有站时间无效返回 -1。
+ */
+static int stop_minutes(const Train *t, int *arr, int *dep)
+{
+	int prev = 0, off = 0;
+
+	for (int i = 0; i < t->stop_count; ++i) {
+		int a = route_parse_time(t->stops[i].arrive);
+		int d = route_parse_time(t->stops[i].depart);
+
+		if (i == 0 && d < 0)
+			d = route_parse_time(t->depart_time);
+		if (a < 0)
+			a = d;
+		if (d < 0)
+			d = a;
+		if (a < 0)
+			return -1;
+
+		if (a + off < prev)
+			off += DAY_MINUTES;
+		arr[i] = a + off;
+		if (d + off < arr[i])
+			off += DAY_MINUTES;
+		dep[i] = d + off;
+		prev = dep[i];
+	}
+
+	return 0;
+}
+
+Router *route_build(TrainList *TL)
+{
+	Router *r = calloc(1, sizeof(Router));
+	if (!r) {
+		perror("calloc");
+		return NULL;
+	}
+	r->station_ht = ht_create(HASH_BUCKETS);
+	r->train_ids = xrealloc(NULL, sizeof(*r->train_ids) * (TL->size ? TL->size : 1));
+
+	int arr[MAX_STOPS], dep[MAX_STOPS];
+	for (int i = 0; i < TL->size; ++i) {
+		const Train *t = &TL->data[i];
+		if (!t->running || t->stop_count < 2 || t->stop_count > MAX_STOPS)
+			continue;
+		if (stop_minutes(t, arr, dep) != 0)
+			continue;
+
+		int ti = r->ntrains++;
+		memcpy(r->train_ids[ti], t->train_id, ID_LEN);
+
+		int sid[MAX_STOPS];
+		for (int k = 0; k < t->stop_count; ++k)
+			sid[k] = station_id(r, t->stops[k].name);
+
+		for (int day = 0; day < 2; ++day)
+			for (int k = 0; k + 1 < t->stop_count; ++k) {
+				Connection c;
+				c.dep = dep[k] + day * DAY_MINUTES;
+				c.arr = arr[k + 1] + day * DAY_MINUTES;
+				c.trip = ti * 2 + day;
+				c.from = sid[k];
+				c.to = sid[k + 1];
+				c.stop = k;
+				add_connection(r, &c);
+			}
+	}
+
+	qsort(r->conns, r->nconns, sizeof(Connection), conn_cmp);
+	return r;
+}
+
+void route_free(Router *r)
+{
+	if (!r)
+		return;
+
+	ht_free(r->station_ht);
+	free(r->stations);
+	free(r->train_ids);
+	free(r->conns);
+	free(r);
+}
+
+int route_station_count(Router *r)
+{
+	return r ? r->nstations : 0;
+}
+
+int route_connection_count(Router *r)
+{
+	return r ? r->nconns : 0;
+}
+
+/* 第一个 dep >= t 的连接下标 */
+static int first_conn(const Router *r, int t)
+{
+	int lo = 0, hi = r->nconns;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (r->conns[mid].dep < t)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ * 按轮次做连接扫描：第 k 轮表示恰好乘坐 k+1 个车次。
+ *   arrive[k][s]  第 k 轮到达站 s 的最早时间
+ *   board[k][t]   第 k 轮在 trip t 上的上车连接，-1 表示本轮还没上这班车
+ *   enter/leave   到达 arrive[k][s] 时所乘车次的上车连接与下车连接，用于还原行程
+ * 连接按发车时间递增扫描，第 k 轮的上车条件是已在该车上，或第 k-1 轮到达本站后留够换乘时间；
+ * 扫描到发车时间晚于当前最优到达时即可停止。
+ */
+int route_earliest(Router *r, const char *from, const char *to, const char *depart_after,
+		   int min_transfer, int max_transfers, RoutePlan *out)
+{
+	if (!r || !from || !to || !out || max_transfers < 0 || max_transfers >= ROUTE_MAX_LEGS || min_transfer < 0)
+		return -2;
+
+	int start = depart_after && *depart_after ? route_parse_time(depart_after) : 0;
+	if (start < 0)
+		return -2;
+
+	int src = ht_find(r->station_ht, from);
+	int dst = ht_find(r->station_ht, to);
+	if (src == -1 || dst == -1 || src == dst)
+		return -1;
+
+	int K = max_transfers + 1;
+	int ns = r->nstations, nt = r->ntrains * 2;
+	int *mem = malloc(sizeof(int) * ((size_t)K * ns * 3 + (size_t)K * nt));
+	if (!mem)
+		return -2;
+	int *arrive = mem;
+	int *enter = arrive + (size_t)K * ns;
+	int *leave = enter + (size_t)K * ns;
+	int *board = leave + (size_t)K * ns;
+	for (size_t i = 0; i < (size_t)K * ns; ++i)
+		arrive[i] = INF;
+	memset(board, 0xff, sizeof(int) * (size_t)K * nt);
+
+	int best = INF;
+	for (int ci = first_conn(r, start); ci < r->nconns; ++ci) {
+		const Connection *c = &r->conns[ci];
+		if (c->dep > best)
+			break;
+
+		for (int k = 0; k < K; ++k) {
+			int *b = &board[(size_t)k * nt + c->trip];
+			if (*b < 0) {
+				if (k == 0) {
+					if (c->from != src)
+						continue;
+				} else {
+					int a = arrive[(size_t)(k - 1) * ns + c->from];
+					if (a == INF || a + min_transfer > c->dep)
+						continue;
+				}
+				*b = ci;
+			}
+
+			size_t at = (size_t)k * ns + c->to;
+			if (c->arr < arrive[at]) {
+				arrive[at] = c->arr;
+				enter[at] = *b;
+				leave[at] = ci;
+				if (c->to == dst && c->arr < best)
+					best = c->arr;
+			}
+		}
+	}
+
+	int kbest = -1;
+	for (int k = 0; k < K; ++k)
+		if (arrive[(size_t)k * ns + dst] != INF &&
+		    (kbest == -1 || arrive[(size_t)k * ns + dst] < arrive[(size_t)kbest * ns + dst]))
+			kbest = k;
+
+	if (kbest == -1) {
+		free(mem);
+		return -1;
+	}
+
+	memset(out, 0, sizeof(*out));
+	out->legs = kbest + 1;
+	out->arrive_min = arrive[(size_t)kbest * ns + dst];
+
+	int v = dst;
+	for (int k = kbest; k >= 0; --k) {
+		size_t at = (size_t)k * ns + v;
+		const Connection *b = &r->conns[enter[at]];
+		const Connection *e = &r->conns[leave[at]];
+		RouteLeg *leg = &out->leg[k];
+
+		memcpy(leg->train_id, r->train_ids[e->trip / 2], ID_LEN);
+		memcpy(leg->from, r->stations[b->from], STATION_LEN);
+		memcpy(leg->to, r->stations[v], STATION_LEN);
+		leg->from_idx = b->stop;
+		leg->to_idx = e->stop + 1;
+		leg->depart_min = b->dep;
+		leg->arrive_min = e->arr;
+		v = b->from;
+	}
+
+	free(mem);
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "scan.h"
+
+/* 快速路径可精确表示的 10 的幂：尾数不超过 2^53 时一次除法即得正确舍入的结果 */
+static const double pow10_tab[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define SCAN_NUM_MAX 64
+
+void scan_init(Scanner *s, const char *buf, size_t len, long first_line)
+{
+	memset(s, 0, sizeof(*s));
+	s->cur = buf;
+	s->end = buf + len;
+	s->line = s->eol = buf;
+	s->lineno = first_line - 1;
+}
+
+int scan_fail(Scanner *s, const char *at, const char *msg)
+{
+	if (s->err)
+		return -1;
+	s->err = msg;
+	s->err_line = s->lineno;
+	s->err_col = at && at >= s->line && at <= s->eol ? (int)(at - s->line) + 1 : 1;
+	s->err_field = s->field;
+	return -1;
+}
+
+int scan_line(Scanner *s)
+{
+	if (s->err)
+		return 0;
+	if (s->cur >= s->end) {
+		s->lineno++;
+		s->line = s->eol = s->end;
+		s->fp = NULL;
+		s->field = 0;
+		scan_fail(s, NULL, "文件提前结束");
+		return 0;
+	}
+
+	const char *nl = memchr(s->cur, '\n', (size_t)(s->end - s->cur));
+	const char *eol = nl ? nl : s->end;
+
+	s->line = s->cur;
+	s->cur = nl ? nl + 1 : s->end;
+	if (eol > s->line && eol[-1] == '\r')
+		eol--;
+	s->eol = eol;
+	s->fp = s->line;
+	s->field = 0;
+	s->lineno++;
+	return 1;
+}
+
+int scan_field(Scanner *s, ScanField *f)
+{
+	if (s->err)
+		return -1;
+	s->field++;
+	if (!s->fp)
+		return scan_fail(s, s->eol, "字段不足");
+
+	const char *bar = memchr(s->fp, '|', (size_t)(s->eol - s->fp));
+	f->p = s->fp;
+	f->len = (size_t)((bar ? bar : s->eol) - s->fp);
+	s->fp = bar ? bar + 1 : NULL;
+	return 0;
+}
+
+int scan_str(Scanner *s, char *dst, size_t cap)
+{
+	ScanField f;
+
+	if (scan_field(s, &f) != 0)
+		return -1;
+	size_t n = f.len < cap - 1 ? f.len : cap - 1;
+	memcpy(dst, f.p, n);
+	dst[n] = '\0';
+	return 0;
+}
+
+int scan_int(Scanner *s, int *out)
+{
+	ScanField f;
+
+	if (scan_field(s, &f) != 0)
+		return -1;
+
+	const char *p = f.p, *e = f.p + f.len;
+	int neg = 0;
+	if (p < e && (*p == '-' || *p == '+'))
+		neg = *p++ == '-';
+	if (p == e)
+		return scan_fail(s, p, "应为整数");
+
+	long long v = 0;
+	for (; p < e; ++p) {
+		unsigned d = (unsigned)(unsigned char)*p - '0';
+		if (d > 9)
+			return scan_fail(s, p, "应为整数");
+		v = v * 10 + d;
+		if (v > (long long)INT_MAX + neg)
+			return scan_fail(s, f.p, "整数超出范围");
+	}
+	*out = (int)(neg ? -v : v);
+	return 0;
+}
+
+/* 快速路径不适用（指数、过多有效数字等）时复制到栈上交给 strtod，要求整个字段都被读完 */
+static int scan_double_slow(Scanner *s, const ScanField *f, double *out)
+{
+	char buf[SCAN_NUM_MAX];
+	char *end;
+
+	if (f->len >= sizeof(buf))
+		return scan_fail(s, f->p, "数字过长");
+	memcpy(buf, f->p, f->len);
+	buf[f->len] = '\0';
+	double v = strtod(buf, &end);
+	if (end == buf || *end)
+		return scan_fail(s, f->p + (end - buf), "应为数字");
+	*out = v;
+	return 0;
+}
+
+int scan_double(Scanner *s, double *out)
+{
+	ScanField f;
+
+	if (scan_field(s, &f) != 0)
+		return -1;
+
+	const char *p = f.p, *e = f.p + f.len;
+	int neg = 0, digits = 0, frac = -1;
+	uint64_t m = 0;
+	if (p < e && (*p == '-' || *p == '+'))
+		neg = *p++ == '-';
+	for (; p < e; ++p) {
+		unsigned d = (unsigned)(unsigned char)*p - '0';
+		if (d <= 9) {
+			if (++digits > 19)
+				return scan_double_slow(s, &f, out);
+			m = m * 10 + d;
+			if (frac >= 0)
+				frac++;
+		} else if (*p == '.' && frac < 0) {
+			frac = 0;
+		} else {
+			return scan_double_slow(s, &f, out);
+		}
+	}
+	if (!digits)
+		return scan_fail(s, f.p, "应为数字");
+	if (m > (1ull << 53) || frac > 22)
+		return scan_double_slow(s, &f, out);
+
+	double v = (double)m;
+	if (frac > 0)
+		v /= pow10_tab[frac];
+	*out = neg ? -v : v;
+	return 0;
+}
+
+void scan_report(const Scanner *s, const char *name)
+{
+	if (!s->err)
+		return;
+	if (s->err_field)
+		fprintf(stderr, "%s:%ld:%d: 字段 %d: %s\n", name, s->err_line, s->err_col, s->err_field, s->err);
+	else
+		fprintf(stderr, "%s:%ld:%d: %s\n", name, s->err_line, s->err_col, s->err);
+}
+
+int scan_field_ok(const char *s)
+{
+	return strpbrk(s, "|\r\n") == NULL;
+}
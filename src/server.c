@@ -14,9 +14,13 @@ typedef SOCKET socket_t;
 #include "train.h"
 #include "passenger.h"
 #include "booking.h"
+#include "wal.h"
+#include "snapshot.h"
 
 #define PORT "8080"
 #define BUFSIZE 8192
+#define WAL_FILE "bookings.wal"
+#define SNAPSHOT_FILE "data.snap"
 
 static TrainList g_trains;
 static PassengerList g_passengers;
@@ -121,6 +125,59 @@ static int get_json_string(const char *body, const char *key, char *out, size_t
 	}
 }
 
+static const char *skip_json_space(const char *p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+		p++;
+	return p;
+}
+
+/*
+ * 取 "key": ["a", "b", ...] 形式的字符串数组，第 i 个元素写入 out + i * cap（最多 max 个）。
+ * 返回元素个数，多于 max 个时返回 max + 1；字段缺失、不是数组、元素不是字符串、
+ * 元素为空或超过 cap - 1 字节、数组未闭合时返回 -1。元素内不处理转义。
+ */
+static int get_json_string_array(const char *body, const char *key, char *out, size_t cap, int max)
+{
+	char pat[128];
+	snprintf(pat, sizeof(pat), "\"%s\"", key);
+	const char *p = strstr(body, pat);
+	if (!p)
+		return -1;
+	p = skip_json_space(p + strlen(pat));
+	if (*p != ':')
+		return -1;
+	p = skip_json_space(p + 1);
+	if (*p != '[')
+		return -1;
+	p = skip_json_space(p + 1);
+	if (*p == ']')
+		return 0;
+
+	int n = 0;
+	for (;;) {
+		if (*p != '"')
+			return -1;
+		const char *q = strchr(p + 1, '"');
+		if (!q)
+			return -1;
+		size_t len = (size_t)(q - p - 1);
+		if (len == 0 || len >= cap || memchr(p + 1, '\\', len))
+			return -1;
+		if (n < max) {
+			memcpy(out + (size_t)n * cap, p + 1, len);
+			out[(size_t)n * cap + len] = 0;
+		}
+		n++;
+		p = skip_json_space(q + 1);
+		if (*p == ']')
+			return n > max ? max + 1 : n;
+		if (*p != ',')
+			return -1;
+		p = skip_json_space(p + 1);
+	}
+}
+
 static char *api_get_trains_json(void)
 {
 	size_t cap = 8192;
@@ -177,27 +234,179 @@ static char *api_get_passengers_json(void)
 	return out;
 }
 
-static char *api_get_bookings_json(void)
+/* 取 URL 查询参数 key 的值（做 %XX 与 '+' 解码），不存在返回 0 */
+static int get_query_param(const char *path, const char *key, char *out, size_t outlen)
+{
+	const char *q = strchr(path, '?');
+	size_t klen = strlen(key);
+
+	while (q) {
+		q++;
+		if (strncmp(q, key, klen) == 0 && q[klen] == '=') {
+			const char *v = q + klen + 1;
+			size_t n = 0;
+			while (*v && *v != '&' && n + 1 < outlen) {
+				unsigned int ch;
+				if (*v == '%' && v[1] && v[2] && sscanf(v + 1, "%2x", &ch) == 1) {
+					out[n++] = (char)ch;
+					v += 3;
+				} else {
+					out[n++] = (*v == '+') ? ' ' : *v;
+					v++;
+				}
+			}
+			out[n] = 0;
+			return 1;
+		}
+		q = strchr(q, '&');
+	}
+
+	return 0;
+}
+
+static char *append_booking_json(char *out, size_t *cap, const Booking *b, int last)
+{
+	char item[1024];
+	snprintf(item, sizeof(item),
+	         "{\"order_id\":\"%s\",\"passenger_id\":\"%s\",\"passenger_name\":\"%s\",\"date\":\"%s\",\"train_id\":\"%s\",\"from\":\"%s\",\"to\":\"%s\",\"depart_time\":\"%s\",\"price\":%.2f,\"seat_no\":\"%s\",\"seat_class\":%d,\"seat_index\":%d,\"from_idx\":%d,\"to_idx\":%d,\"canceled\":%d}%s",
+	         b->order_id, b->passenger_id, b->passenger_name, b->date, b->train_id, b->from, b->to, b->depart_time, b->price, b->seat_no, b->seat_class, b->seat_index, b->from_stop_idx, b->to_stop_idx, b->canceled, last?"":",");
+	if (strlen(out) + strlen(item) + 10 > *cap) { *cap *= 2; out = realloc(out, *cap); }
+	strcat(out, item);
+	return out;
+}
+
+static char *bookings_to_json(const Booking *list, int n)
+{
+	size_t cap = 8192;
+	char *out = malloc(cap);
+	out[0]=0;
+	strcat(out,"[");
+
+	for (int i = 0; i < n; ++i)
+		out = append_booking_json(out, &cap, &list[i], i+1==n);
+
+	strcat(out, "]");
+	return out;
+}
+
+/* 全部订单：逐条经 booking_get 展开 */
+static char *all_bookings_json(void)
 {
 	size_t cap = 8192;
 	char *out = malloc(cap);
 	out[0]=0;
 	strcat(out,"[");
 
-	for (int i = 0; i < g_bookings.size; ++i) {
-		Booking *b = &g_bookings.data[i];
-		char item[1024];
-		snprintf(item, sizeof(item),
-		         "{\"order_id\":\"%s\",\"passenger_id\":\"%s\",\"passenger_name\":\"%s\",\"date\":\"%s\",\"train_id\":\"%s\",\"from\":\"%s\",\"to\":\"%s\",\"depart_time\":\"%s\",\"price\":%.2f,\"seat_no\":\"%s\",\"seat_class\":%d,\"seat_index\":%d,\"from_idx\":%d,\"to_idx\":%d,\"canceled\":%d}%s",
-		         b->order_id, b->passenger_id, b->passenger_name, b->date, b->train_id, b->from, b->to, b->depart_time, b->price, b->seat_no, b->seat_class, b->seat_index, b->from_stop_idx, b->to_stop_idx, b->canceled, (i+1==g_bookings.size)?"":",");
-		if (strlen(out) + strlen(item) + 10 > cap) { cap *= 2; out = realloc(out, cap); }
-		strcat(out, item);
+	int n = g_bookings.size;
+	for (int i = 0; i < n; ++i) {
+		Booking b;
+		if (booking_get(&g_bookings, i, &b) == 0)
+			out = append_booking_json(out, &cap, &b, i+1==n);
 	}
 
 	strcat(out, "]");
 	return out;
 }
 
+/* GET /api/trains/search?from=A&to=B[&date=YYYY-MM-DD]：经站点倒排索引查先经 A 后经 B 的车次 */
+static char *api_search_trains_json(const char *path)
+{
+	char from[128], to[128], date[64];
+	if (!get_query_param(path, "from", from, sizeof(from)) || !get_query_param(path, "to", to, sizeof(to)))
+		return NULL;
+	int has_date = get_query_param(path, "date", date, sizeof(date)) && date[0];
+
+	int n = train_find_between(&g_trains, from, to, has_date ? date : NULL, NULL, 0);
+	if (n < 0)
+		return NULL;
+	TrainMatch *hits = malloc(sizeof(TrainMatch) * (n ? n : 1));
+	int m = train_find_between(&g_trains, from, to, has_date ? date : NULL, hits, n);
+	if (m < n)
+		n = m;
+
+	size_t cap = 1024 + (size_t)n * 256;
+	char *out = malloc(cap);
+	size_t len = 0;
+	out[len++] = '[';
+	for (int i = 0; i < n; ++i) {
+		TrainMatch *t = &hits[i];
+		len += snprintf(out + len, cap - len,
+		                "{\"train_id\":\"%s\",\"from_idx\":%d,\"to_idx\":%d,\"depart\":\"%s\",\"arrive\":\"%s\",\"running\":%d,"
+		                "\"remaining\":[%d,%d,%d,%d]}%s",
+		                t->train_id, t->from_idx, t->to_idx, t->depart, t->arrive, t->running,
+		                t->remaining[0], t->remaining[1], t->remaining[2], t->remaining[3], (i+1==n)?"":",");
+	}
+	snprintf(out + len, cap - len, "]");
+	free(hits);
+	return out;
+}
+
+/* GET /api/bookings[?passenger=证件号或姓名 | ?train=车次&date=日期]：带参数时走二级索引 */
+static char *api_get_bookings_json(const char *path)
+{
+	char passenger[128], train_id[64], date[64];
+	int by_passenger = get_query_param(path, "passenger", passenger, sizeof(passenger));
+	int by_train = get_query_param(path, "train", train_id, sizeof(train_id)) &&
+	               get_query_param(path, "date", date, sizeof(date));
+
+	if (!by_passenger && !by_train)
+		return all_bookings_json();
+
+	int n = by_passenger ? booking_find_by_passenger(&g_bookings, passenger, NULL, 0)
+	                     : booking_find_by_train_date(&g_bookings, train_id, date, NULL, 0);
+	Booking *hits = malloc(sizeof(Booking) * (n ? n : 1));
+	int m = by_passenger ? booking_find_by_passenger(&g_bookings, passenger, hits, n)
+	                     : booking_find_by_train_date(&g_bookings, train_id, date, hits, n);
+	if (m < n)
+		n = m;
+	char *json = bookings_to_json(hits, n);
+	free(hits);
+	return json;
+}
+
+/* GET /api/bookings/stats[?by=train,date,class][&status=active|canceled]：列式统计，by 省略时只给合计 */
+static char *api_booking_stats_json(const char *path)
+{
+	char by[64] = "", status[16] = "";
+	int group_by = 0, filter = BOOKING_AGG_ALL;
+
+	if (get_query_param(path, "by", by, sizeof(by))) {
+		for (char *tok = strtok(by, ","); tok; tok = strtok(NULL, ",")) {
+			if (strcmp(tok, "train") == 0) group_by |= BOOKING_BY_TRAIN;
+			else if (strcmp(tok, "date") == 0) group_by |= BOOKING_BY_DATE;
+			else if (strcmp(tok, "class") == 0) group_by |= BOOKING_BY_CLASS;
+			else return NULL;
+		}
+	}
+	if (get_query_param(path, "status", status, sizeof(status))) {
+		if (strcmp(status, "active") == 0) filter = BOOKING_AGG_ACTIVE;
+		else if (strcmp(status, "canceled") == 0) filter = BOOKING_AGG_CANCELED;
+		else if (strcmp(status, "all") != 0) return NULL;
+	}
+
+	int n = booking_aggregate(&g_bookings, group_by, filter, NULL, 0);
+	if (n < 0)
+		return NULL;
+	BookingAggRow *rows = malloc(sizeof(BookingAggRow) * (n ? n : 1));
+	int m = booking_aggregate(&g_bookings, group_by, filter, rows, n);
+	if (m < n)
+		n = m;
+
+	size_t cap = 64 + (size_t)n * 192;
+	char *out = malloc(cap);
+	size_t len = 0;
+	out[len++] = '[';
+	for (int i = 0; i < n; ++i) {
+		BookingAggRow *r = &rows[i];
+		len += snprintf(out + len, cap - len,
+		                "{\"train_id\":\"%s\",\"date\":\"%s\",\"seat_class\":%d,\"count\":%lld,\"revenue\":%.2f,\"segments\":%lld}%s",
+		                r->train_id, r->date, r->seat_class, r->count, r->revenue_cents / 100.0, r->segments, (i+1==n)?"":",");
+	}
+	snprintf(out + len, cap - len, "]");
+	free(rows);
+	return out;
+}
+
 static void handle_post_passenger(socket_t client, const char *body)
 {
 	Passenger p;
@@ -211,6 +420,10 @@ static void handle_post_passenger(socket_t client, const char *body)
 	int res = passenger_add(&g_passengers, &p);
 	if (res == 0)
 		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":true}");
+	else if (res == ERR_BAD_FIELD)
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_field\"}");
+	else if (res == ERR_NOT_DURABLE)
+		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"not_durable\"}");
 	else
 		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
 }
@@ -233,6 +446,13 @@ static void handle_post_booking(socket_t client, const char *body)
 		char resp[256];
 		snprintf(resp, sizeof(resp), "{\"success\":true,\"order_id\":\"%s\"}", orderid);
 		send_response(client, "200 OK", "application/json; charset=utf-8", resp);
+	} else if (rc == ERR_NOT_DURABLE) {
+		/* 订单已生效但未写入日志：告知订单号，由调用方决定是否退票或等待保存 */
+		char resp[256];
+		snprintf(resp, sizeof(resp), "{\"success\":false,\"error\":\"not_durable\",\"order_id\":\"%s\"}", orderid);
+		send_response(client, "500 Internal", "application/json; charset=utf-8", resp);
+	} else if (rc == ERR_BAD_FIELD) {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_field\"}");
 	} else if (rc == -1) {
 		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"passenger_not_found\"}");
 	} else if (rc == -2) {
@@ -242,6 +462,52 @@ static void handle_post_booking(socket_t client, const char *body)
 	}
 }
 
+static void handle_post_group_booking(socket_t client, const char *body)
+{
+	char date[64], train_id[64], from[128], to[128], clsbuf[16], idsbuf[GROUP_MAX_SIZE][ID_LEN];
+	date[0]=train_id[0]=from[0]=to[0]=clsbuf[0]=0;
+	get_json_string(body, "date", date, sizeof(date));
+	get_json_string(body, "train_id", train_id, sizeof(train_id));
+	get_json_string(body, "from", from, sizeof(from));
+	get_json_string(body, "to", to, sizeof(to));
+	get_json_string(body, "seat_class", clsbuf, sizeof(clsbuf));
+	int cls = atoi(clsbuf);
+
+	/* passenger_ids 为证件号的 JSON 数组，如 ["P1","P2","P3"]；缺失、格式错误或证件号超长时不去查乘客 */
+	int n = get_json_string_array(body, "passenger_ids", idsbuf[0], ID_LEN, GROUP_MAX_SIZE);
+	if (n < 0) {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_passenger_ids\"}");
+		return;
+	}
+	if (n == 0 || n > GROUP_MAX_SIZE) {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_group_size\"}");
+		return;
+	}
+	const char *ids[GROUP_MAX_SIZE];
+	for (int i = 0; i < n; ++i)
+		ids[i] = idsbuf[i];
+
+	char orderids[GROUP_MAX_SIZE][ORDER_ID_LEN];
+	int rc = booking_create_group(&g_bookings, &g_trains, &g_passengers, date, train_id, from, to, ids, n, cls, orderids);
+	if (rc == 0 || rc == ERR_NOT_DURABLE) {
+		char resp[GROUP_MAX_SIZE * (ORDER_ID_LEN + 4) + 96];
+		int len = snprintf(resp, sizeof(resp), rc == 0 ? "{\"success\":true,\"order_ids\":[" :
+				   "{\"success\":false,\"error\":\"not_durable\",\"order_ids\":[");
+		for (int i = 0; i < n; ++i)
+			len += snprintf(resp + len, sizeof(resp) - len, "\"%s\"%s", orderids[i], (i+1==n)?"":",");
+		snprintf(resp + len, sizeof(resp) - len, "]}");
+		send_response(client, rc == 0 ? "200 OK" : "500 Internal", "application/json; charset=utf-8", resp);
+	} else if (rc == ERR_BAD_FIELD) {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_field\"}");
+	} else if (rc == -1) {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"passenger_not_found\"}");
+	} else if (rc == -2) {
+		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"no_seat\"}");
+	} else {
+		send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"bad_group_size\"}");
+	}
+}
+
 static void handle_post_cancel(socket_t client, const char *body)
 {
 	char oid[ORDER_ID_LEN];
@@ -254,11 +520,48 @@ static void handle_post_cancel(socket_t client, const char *body)
 		send_response(client, "404 Not Found", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"not_found\"}");
 	else if (rc == -2)
 		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"already_canceled\"}");
+	else if (rc == ERR_NOT_DURABLE)
+		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"not_durable\"}");
 	else
 		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
 }
 
+/*
+ * POST /api/save：mode 为 log（改动已在日志中，只落盘日志）或 background（已生成映像，
+ * 快照由后台线程写出，进度见 /api/save/status）；上一次后台保存未结束时返回 409
+ */
 static void handle_post_save(socket_t client)
+{
+	int res = save_snapshot_background(SNAPSHOT_FILE, &g_trains, &g_passengers, &g_bookings);
+	if (res == SNAPSHOT_LOGGED)
+		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":true,\"mode\":\"log\"}");
+	else if (res == SNAPSHOT_STARTED)
+		send_response(client, "202 Accepted", "application/json; charset=utf-8", "{\"success\":true,\"mode\":\"background\"}");
+	else if (res == SNAPSHOT_WRITTEN)
+		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":true,\"mode\":\"snapshot\"}");
+	else if (res == SNAPSHOT_BUSY)
+		send_response(client, "409 Conflict", "application/json; charset=utf-8", "{\"success\":false,\"error\":\"busy\"}");
+	else
+		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
+}
+
+/* GET /api/save/status：最近一次后台保存的状态与进度（字节） */
+static void handle_get_save_status(socket_t client)
+{
+	static const char *states[] = { "idle", "running", "done", "failed" };
+	SnapshotStatus st;
+	char json[256];
+
+	snapshot_status(&st);
+	snprintf(json, sizeof(json),
+		"{\"state\":\"%s\",\"written\":%lld,\"total\":%lld,\"progress\":%.3f,\"capture_ms\":%.1f,\"write_ms\":%.1f}",
+		states[st.state], st.written, st.total, st.total ? (double)st.written / st.total : 0.0,
+		st.capture_ms, st.write_ms);
+	send_response(client, "200 OK", "application/json; charset=utf-8", json);
+}
+
+/* POST /api/export：写出三个文本文件 */
+static void handle_post_export(socket_t client)
 {
 	int a = save_trains("trains.txt", &g_trains);
 	int b = save_passengers("passengers.txt", &g_passengers);
@@ -269,7 +572,7 @@ static void handle_post_save(socket_t client)
 		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
 }
 
-static void handle_post_load(socket_t client)
+static void reset_all(void)
 {
 	trainlist_free(&g_trains);
 	passengerlist_free(&g_passengers);
@@ -278,11 +581,45 @@ static void handle_post_load(socket_t client)
 	trainlist_init(&g_trains);
 	passengerlist_init(&g_passengers);
 	bookinglist_init(&g_bookings);
+}
 
+static int import_text(void)
+{
 	int a = load_trains("trains.txt", &g_trains);
 	int b = load_passengers("passengers.txt", &g_passengers);
-	int c = load_bookings("bookings.txt", &g_bookings, &g_trains);
-	if (a && b && c)
+	int c = load_bookings_parallel("bookings.txt", &g_bookings, &g_trains, 0);
+	return a && b && c;
+}
+
+/* 优先载入快照，没有或无效时从文本导入，随后重放日志并归档今天以前的座位图 */
+static int load_all(void)
+{
+	reset_all();
+	int ok = load_snapshot(SNAPSHOT_FILE, &g_trains, &g_passengers, &g_bookings) || import_text();
+	int replayed = wal_replay(WAL_FILE, &g_trains, &g_passengers, &g_bookings);
+	if (replayed > 0)
+		printf("replayed %d operations from %s\n", replayed, WAL_FILE);
+	train_evict_past(&g_trains);
+	return ok;
+}
+
+static void handle_post_load(socket_t client)
+{
+	snapshot_wait();
+	if (load_all())
+		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":true}");
+	else
+		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
+}
+
+/* POST /api/import：以三个文本文件替换当前数据，之后 /api/save 才写入快照 */
+static void handle_post_import(socket_t client)
+{
+	snapshot_wait();
+	reset_all();
+	int ok = import_text();
+	train_evict_past(&g_trains);
+	if (ok)
 		send_response(client, "200 OK", "application/json; charset=utf-8", "{\"success\":true}");
 	else
 		send_response(client, "500 Internal", "application/json; charset=utf-8", "{\"success\":false}");
@@ -313,7 +650,17 @@ static void handle_client(socket_t client)
 	}
 
 	if (strcmp(method, "GET") == 0) {
-		if (strncmp(path, "/api/trains", 11) == 0) {
+		if (strcmp(path, "/api/save/status") == 0) {
+			handle_get_save_status(client);
+		} else if (strncmp(path, "/api/trains/search", 18) == 0) {
+			char *json = api_search_trains_json(path);
+			if (json) {
+				send_response(client, "200 OK", "application/json; charset=utf-8", json);
+				free(json);
+			} else {
+				send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"error\":\"bad_query\"}");
+			}
+		} else if (strncmp(path, "/api/trains", 11) == 0) {
 			char *json = api_get_trains_json();
 			send_response(client, "200 OK", "application/json; charset=utf-8", json);
 			free(json);
@@ -321,8 +668,16 @@ static void handle_client(socket_t client)
 			char *json = api_get_passengers_json();
 			send_response(client, "200 OK", "application/json; charset=utf-8", json);
 			free(json);
+		} else if (strncmp(path, "/api/bookings/stats", 19) == 0) {
+			char *json = api_booking_stats_json(path);
+			if (json) {
+				send_response(client, "200 OK", "application/json; charset=utf-8", json);
+				free(json);
+			} else {
+				send_response(client, "400 Bad Request", "application/json; charset=utf-8", "{\"error\":\"bad_query\"}");
+			}
 		} else if (strncmp(path, "/api/bookings", 13) == 0) {
-			char *json = api_get_bookings_json();
+			char *json = api_get_bookings_json(path);
 			send_response(client, "200 OK", "application/json; charset=utf-8", json);
 			free(json);
 		} else {
@@ -335,12 +690,18 @@ static void handle_client(socket_t client)
 			handle_post_passenger(client, body);
 		} else if (strcmp(path, "/api/bookings") == 0) {
 			handle_post_booking(client, body);
+		} else if (strcmp(path, "/api/bookings/group") == 0) {
+			handle_post_group_booking(client, body);
 		} else if (strcmp(path, "/api/bookings/cancel") == 0) {
 			handle_post_cancel(client, body);
 		} else if (strcmp(path, "/api/save") == 0) {
 			handle_post_save(client);
 		} else if (strcmp(path, "/api/load") == 0) {
 			handle_post_load(client);
+		} else if (strcmp(path, "/api/export") == 0) {
+			handle_post_export(client);
+		} else if (strcmp(path, "/api/import") == 0) {
+			handle_post_import(client);
 		} else {
 			send_response(client, "404 Not Found", "application/json; charset=utf-8", "{\"error\":\"not_found\"}");
 		}
@@ -356,9 +717,9 @@ int main(void)
 	trainlist_init(&g_trains);
 	passengerlist_init(&g_passengers);
 	bookinglist_init(&g_bookings);
-	load_trains("trains.txt", &g_trains);
-	load_passengers("passengers.txt", &g_passengers);
-	load_bookings("bookings.txt", &g_bookings, &g_trains);
+	load_all();
+	if (wal_open(WAL_FILE) != 0)
+		fprintf(stderr, "cannot open %s, changes are only persisted by /api/save\n", WAL_FILE);
 
 	WSADATA wsaData;
 	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
@@ -0,0 +1,210 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapio.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#define file_fsync(fd) _commit(fd)
+#define file_fileno(f) _fileno(f)
+#else
+#define file_fsync(fd) fsync(fd)
+#define file_fileno(f) fileno(f)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SNAP_ALIGN 8
+
+/* 写入内存缓冲：容量按倍数增长，扩容失败置 err */
+static void mem_write(SnapWriter *w, const void *p, size_t n, size_t pad)
+{
+	size_t need = (size_t)w->off + n + pad;
+
+	if (need < n || need > SIZE_MAX / 2) {
+		w->err = 1;
+		return;
+	}
+	if (need > w->cap) {
+		size_t cap = w->cap ? w->cap : 1 << 20;
+		while (cap < need)
+			cap *= 2;
+		unsigned char *nb = realloc(w->buf, cap);
+		if (!nb) {
+			w->err = 1;
+			return;
+		}
+		w->buf = nb;
+		w->cap = cap;
+	}
+	if (n)
+		memcpy(w->buf + w->off, p, n);
+	if (pad)
+		memset(w->buf + w->off + n, 0, pad);
+	w->off = need;
+}
+
+void snap_write(SnapWriter *w, const void *p, size_t n)
+{
+	static const char zeros[SNAP_ALIGN];
+	size_t pad = (SNAP_ALIGN - n % SNAP_ALIGN) % SNAP_ALIGN;
+
+	if (w->err)
+		return;
+	if (!w->f) {
+		mem_write(w, p, n, pad);
+		return;
+	}
+	if ((n && fwrite(p, 1, n, w->f) != n) || (pad && fwrite(zeros, 1, pad, w->f) != pad)) {
+		w->err = 1;
+		return;
+	}
+	w->off += n + pad;
+}
+
+void snap_put_u64(SnapWriter *w, uint64_t v)
+{
+	snap_write(w, &v, sizeof(v));
+}
+
+const void *snap_read(SnapReader *r, size_t n)
+{
+	size_t padded = n + (SNAP_ALIGN - n % SNAP_ALIGN) % SNAP_ALIGN;
+
+	if (r->err || padded < n || padded > r->len - r->off) {
+		r->err = 1;
+		return NULL;
+	}
+
+	const void *p = r->p + r->off;
+	r->off += padded;
+	return p;
+}
+
+uint64_t snap_get_u64(SnapReader *r)
+{
+	const void *p = snap_read(r, sizeof(uint64_t));
+	uint64_t v = 0;
+
+	if (p)
+		memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+size_t snap_get_count(SnapReader *r, size_t max)
+{
+	uint64_t v = snap_get_u64(r);
+
+	if (v > max) {
+		r->err = 1;
+		return 0;
+	}
+	return (size_t)v;
+}
+
+int map_file(const char *filename, MappedFile *m)
+{
+	memset(m, 0, sizeof(*m));
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return -1;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (unsigned long long)size.QuadPart > SIZE_MAX) {
+		CloseHandle(file);
+		return -1;
+	}
+	HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	m->p = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!m->p) {
+		if (map)
+			CloseHandle(map);
+		CloseHandle(file);
+		return -1;
+	}
+	m->file = file;
+	m->map = map;
+	m->len = (size_t)size.QuadPart;
+#else
+	struct stat st;
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return -1;
+	}
+	void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return -1;
+	m->p = p;
+	m->len = (size_t)st.st_size;
+#endif
+	return 0;
+}
+
+void unmap_file(MappedFile *m)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(m->p);
+	CloseHandle(m->map);
+	CloseHandle(m->file);
+#else
+	munmap((void *)m->p, m->len);
+#endif
+}
+
+FILE *file_replace_begin(const char *path, char *tmp, size_t tmplen)
+{
+	if ((size_t)snprintf(tmp, tmplen, "%s.tmp", path) >= tmplen)
+		return NULL;
+	return fopen(tmp, "wb");
+}
+
+/* 改名本身要等所在目录落盘才算持久 */
+static void sync_parent_dir(const char *path)
+{
+#ifndef _WIN32
+	char dir[FILENAME_MAX];
+	const char *slash = strrchr(path, '/');
+
+	if (!slash)
+		snprintf(dir, sizeof(dir), ".");
+	else
+		snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path) + (slash == path), path);
+	int fd = open(dir, O_RDONLY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+#else
+	(void)path;
+#endif
+}
+
+int file_replace_commit(FILE *f, const char *tmp, const char *path, int ok)
+{
+	ok = ok && fflush(f) == 0 && file_fsync(file_fileno(f)) == 0;
+	ok = fclose(f) == 0 && ok;
+	if (!ok) {
+		remove(tmp);
+		return 0;
+	}
+
+#ifdef _WIN32
+	remove(path);
+#endif
+	if (rename(tmp, path) != 0) {
+		remove(tmp);
+		return 0;
+	}
+	sync_parent_dir(path);
+	return 1;
+}
@@ -0,0 +1,311 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "snapshot.h"
+#include "wal.h"
+#include "sync.h"
+
+#define SNAPSHOT_MAGIC "HSRSNAP"
+#define SNAPSHOT_ENDIAN 0x01020304u
+#define SNAPSHOT_PATH_LEN 512
+#define SNAPSHOT_CHUNK (4 << 20)
+
+/* 各段开头的标记字 */
+#define TAG_TRAINS     0x534e494152540001ull
+#define TAG_PASSENGERS 0x5353415000000002ull
+#define TAG_BOOKINGS   0x4b4f4f4200000003ull
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t endian;
+	uint32_t sizes[6];	/* Train, Stop, Passenger, BookingRec, size_t, 指针 */
+	uint64_t file_len;
+} SnapshotHeader;
+
+/*
+ * 最近一次成功保存或载入的快照（增量保存的基准）：文件名、长度与当时三张表的修改计数。
+ * 计数未变说明此后的修改都在日志里，快照加日志即是当前状态。
+ */
+static struct {
+	int valid;
+	char file[SNAPSHOT_PATH_LEN];
+	long long len;
+	long long versions[3];
+} base;
+
+/*
+ * 后台保存：映像在调用线程里生成，后台线程只负责写出、fsync、改名与结束检查点。
+ * 除 state、written 外的字段只由调用线程读写（thread 运行期间 buf 由后台线程只读）。
+ */
+static struct {
+	SyncThread *thread;
+	volatile int state;
+	volatile int64_t written;
+	unsigned char *buf;
+	size_t len;
+	char file[SNAPSHOT_PATH_LEN];
+	long long versions[3];
+	double started, captured, finished;
+	int ok;
+} job;
+
+static void current_versions(long long v[3])
+{
+	v[0] = train_version();
+	v[1] = passenger_version();
+	v[2] = booking_version();
+}
+
+static void base_record(const char *filename, long long len)
+{
+	base.valid = strlen(filename) < sizeof(base.file);
+	snprintf(base.file, sizeof(base.file), "%s", filename);
+	base.len = len;
+	current_versions(base.versions);
+}
+
+static long long file_length(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long long n = -1;
+
+	if (f) {
+		if (fseek(f, 0, SEEK_END) == 0)
+			n = ftell(f);
+		fclose(f);
+	}
+	return n;
+}
+
+static void header_fill(SnapshotHeader *h, uint64_t file_len)
+{
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	h->version = SNAPSHOT_VERSION;
+	h->endian = SNAPSHOT_ENDIAN;
+	h->sizes[0] = sizeof(Train);
+	h->sizes[1] = sizeof(Stop);
+	h->sizes[2] = sizeof(Passenger);
+	h->sizes[3] = sizeof(BookingRec);
+	h->sizes[4] = sizeof(size_t);
+	h->sizes[5] = sizeof(void *);
+	h->file_len = file_len;
+}
+
+/* 先写全零的文件头占位，内容写完后回填；中途失败的文件没有魔数 */
+static void write_sections(SnapWriter *w, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	SnapshotHeader h;
+
+	memset(&h, 0, sizeof(h));
+	snap_write(w, &h, sizeof(h));
+	snap_put_u64(w, TAG_TRAINS);
+	train_snapshot_save(TL, w);
+	snap_put_u64(w, TAG_PASSENGERS);
+	passenger_snapshot_save(PL, w);
+	snap_put_u64(w, TAG_BOOKINGS);
+	booking_snapshot_save(BL, w);
+}
+
+int save_snapshot(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	char tmp[SNAPSHOT_PATH_LEN + 8];
+	SnapshotHeader h;
+
+	/* 不与后台保存同时写同一个临时文件 */
+	snapshot_wait();
+	FILE *f = file_replace_begin(filename, tmp, sizeof(tmp));
+	if (!f)
+		return 0;
+
+	SnapWriter w = { f, 0, 0, NULL, 0 };
+	write_sections(&w, TL, PL, BL);
+	header_fill(&h, w.off);
+	int ok = !w.err && fflush(f) == 0 && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+	ok = file_replace_commit(f, tmp, filename, ok);
+	if (ok)
+		base_record(filename, (long long)w.off);
+	return ok;
+}
+
+/* 上次快照以来的修改都在日志里且日志不长，只需落盘日志 */
+static int log_covers(const char *filename)
+{
+	long long v[3];
+	WalStats st;
+
+	current_versions(v);
+	wal_stats(&st);
+	return wal_is_open() && !wal_incomplete() && base.valid && strcmp(base.file, filename) == 0 &&
+	       memcmp(v, base.versions, sizeof(v)) == 0 && file_length(filename) == base.len &&
+	       (st.log_bytes <= SNAPSHOT_LOG_MIN || st.log_bytes <= base.len / SNAPSHOT_LOG_RATIO);
+}
+
+int save_snapshot_incremental(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	snapshot_wait();
+	if (log_covers(filename))
+		return wal_sync() == 0 ? SNAPSHOT_LOGGED : 0;
+
+	/* 压缩：重写快照，写完之前日志保留在 .old，写失败也不丢操作 */
+	wal_checkpoint_begin();
+	int ok = save_snapshot(filename, TL, PL, BL);
+	wal_checkpoint_end(ok);
+	return ok ? SNAPSHOT_WRITTEN : 0;
+}
+
+static void *job_run(void *arg)
+{
+	char tmp[SNAPSHOT_PATH_LEN + 8];
+	FILE *f = file_replace_begin(job.file, tmp, sizeof(tmp));
+	int ok = f != NULL;
+
+	(void)arg;
+	for (size_t off = 0; ok && off < job.len; ) {
+		size_t n = job.len - off < SNAPSHOT_CHUNK ? job.len - off : SNAPSHOT_CHUNK;
+		ok = fwrite(job.buf + off, 1, n, f) == n;
+		off += n;
+		sync_fetch_add64(&job.written, (int64_t)n);
+	}
+	if (f)
+		ok = file_replace_commit(f, tmp, job.file, ok);
+	wal_checkpoint_end(ok);
+	job.ok = ok;
+	job.finished = sync_now();
+	sync_store(&job.state, ok ? SNAPSHOT_DONE : SNAPSHOT_FAILED);
+	return NULL;
+}
+
+/* 回收已结束的后台线程；成功时以生成映像那一刻的修改计数作为增量保存的基准 */
+static void job_finish(void)
+{
+	free(job.buf);
+	job.buf = NULL;
+	if (job.ok) {
+		base.valid = 1;
+		memcpy(base.file, job.file, sizeof(base.file));
+		base.len = (long long)job.len;
+		memcpy(base.versions, job.versions, sizeof(base.versions));
+	}
+}
+
+static void job_reap(void)
+{
+	if (job.thread && sync_load(&job.state) != SNAPSHOT_RUNNING) {
+		sync_thread_join(job.thread);
+		job.thread = NULL;
+		job_finish();
+	}
+}
+
+int save_snapshot_background(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	SnapshotHeader h;
+
+	job_reap();
+	if (job.thread)
+		return SNAPSHOT_BUSY;
+	if (log_covers(filename))
+		return wal_sync() == 0 ? SNAPSHOT_LOGGED : 0;
+	if (strlen(filename) >= sizeof(job.file))
+		return 0;
+
+	/* 映像生成期间调用方不处理其它请求，之后的修改进入检查点新开的日志 */
+	double t0 = sync_now();
+	wal_checkpoint_begin();
+	SnapWriter w = { NULL, 0, 0, NULL, 0 };
+	/* 按上次快照的大小预留，免去逐次倍增的拷贝 */
+	if (base.valid && base.len > 0 && (w.buf = malloc((size_t)base.len + base.len / 8)) != NULL)
+		w.cap = (size_t)base.len + base.len / 8;
+	write_sections(&w, TL, PL, BL);
+	if (w.err) {
+		free(w.buf);
+		wal_checkpoint_end(0);
+		return 0;
+	}
+	header_fill(&h, w.off);
+	memcpy(w.buf, &h, sizeof(h));
+
+	snprintf(job.file, sizeof(job.file), "%s", filename);
+	current_versions(job.versions);
+	job.buf = w.buf;
+	job.len = (size_t)w.off;
+	job.written = 0;
+	job.ok = 0;
+	job.started = t0;
+	job.captured = job.finished = sync_now();
+	sync_store(&job.state, SNAPSHOT_RUNNING);
+	job.thread = sync_thread_start(job_run, NULL);
+	if (!job.thread) {
+		/* 开不了线程就在调用线程里写完 */
+		job_run(NULL);
+		job_finish();
+		return job.ok ? SNAPSHOT_WRITTEN : 0;
+	}
+	return SNAPSHOT_STARTED;
+}
+
+void snapshot_status(SnapshotStatus *out)
+{
+	job_reap();
+	memset(out, 0, sizeof(*out));
+	out->state = sync_load(&job.state);
+	if (out->state == SNAPSHOT_IDLE)
+		return;
+	out->written = sync_fetch_add64(&job.written, 0);
+	out->total = (long long)job.len;
+	out->capture_ms = (job.captured - job.started) * 1e3;
+	out->write_ms = ((out->state == SNAPSHOT_RUNNING ? sync_now() : job.finished) - job.captured) * 1e3;
+}
+
+int snapshot_wait(void)
+{
+	if (job.thread) {
+		sync_thread_join(job.thread);
+		job.thread = NULL;
+		job_finish();
+	}
+	return sync_load(&job.state) != SNAPSHOT_FAILED;
+}
+
+static int expect_tag(SnapReader *r, uint64_t tag)
+{
+	return snap_get_u64(r) == tag && !r->err;
+}
+
+int load_snapshot(const char *filename, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	MappedFile m;
+	SnapshotHeader want;
+
+	if (map_file(filename, &m) != 0)
+		return 0;
+
+	SnapReader r = { (const unsigned char *)m.p, m.len, 0, 0 };
+	const SnapshotHeader *h = snap_read(&r, sizeof(SnapshotHeader));
+	header_fill(&want, m.len);
+
+	int ok = h && memcmp(h, &want, sizeof(want)) == 0 &&
+		 expect_tag(&r, TAG_TRAINS) && train_snapshot_load(TL, &r) == 0 &&
+		 expect_tag(&r, TAG_PASSENGERS) && passenger_snapshot_load(PL, &r) == 0 &&
+		 expect_tag(&r, TAG_BOOKINGS) && booking_snapshot_load(BL, &r) == 0 &&
+		 r.off == r.len;
+	unmap_file(&m);
+
+	if (ok) {
+		base_record(filename, (long long)r.len);
+	} else {
+		trainlist_free(TL);
+		passengerlist_free(PL);
+		bookinglist_free(BL);
+		trainlist_init(TL);
+		passengerlist_init(PL);
+		bookinglist_init(BL);
+	}
+	return ok;
+}
@@ -0,0 +1,259 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "sync.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+
+struct SyncRWLock { SRWLOCK l; };
+struct SyncMutex { CRITICAL_SECTION m; };
+struct SyncCond { CONDITION_VARIABLE c; };
+struct SyncThread {
+	HANDLE h;
+	void *(*fn)(void *);
+	void *arg;
+	void *ret;
+};
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+struct SyncRWLock { pthread_rwlock_t l; };
+struct SyncMutex { pthread_mutex_t m; };
+struct SyncCond { pthread_cond_t c; };
+struct SyncThread { pthread_t t; };
+#endif
+
+static void *xmalloc(size_t n)
+{
+	void *p = malloc(n);
+	if (!p) {
+		perror("malloc");
+		exit(1);
+	}
+	return p;
+}
+
+SyncRWLock *sync_rwlock_create(void)
+{
+	SyncRWLock *l = xmalloc(sizeof(SyncRWLock));
+#ifdef _WIN32
+	InitializeSRWLock(&l->l);
+#else
+	pthread_rwlock_init(&l->l, NULL);
+#endif
+	return l;
+}
+
+void sync_rwlock_free(SyncRWLock *l)
+{
+	if (!l)
+		return;
+#ifndef _WIN32
+	pthread_rwlock_destroy(&l->l);
+#endif
+	free(l);
+}
+
+void sync_rwlock_rdlock(SyncRWLock *l)
+{
+#ifdef _WIN32
+	AcquireSRWLockShared(&l->l);
+#else
+	pthread_rwlock_rdlock(&l->l);
+#endif
+}
+
+void sync_rwlock_rdunlock(SyncRWLock *l)
+{
+#ifdef _WIN32
+	ReleaseSRWLockShared(&l->l);
+#else
+	pthread_rwlock_unlock(&l->l);
+#endif
+}
+
+void sync_rwlock_wrlock(SyncRWLock *l)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&l->l);
+#else
+	pthread_rwlock_wrlock(&l->l);
+#endif
+}
+
+void sync_rwlock_wrunlock(SyncRWLock *l)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&l->l);
+#else
+	pthread_rwlock_unlock(&l->l);
+#endif
+}
+
+SyncMutex *sync_mutex_create(void)
+{
+	SyncMutex *m = xmalloc(sizeof(SyncMutex));
+#ifdef _WIN32
+	InitializeCriticalSection(&m->m);
+#else
+	pthread_mutex_init(&m->m, NULL);
+#endif
+	return m;
+}
+
+void sync_mutex_free(SyncMutex *m)
+{
+	if (!m)
+		return;
+#ifdef _WIN32
+	DeleteCriticalSection(&m->m);
+#else
+	pthread_mutex_destroy(&m->m);
+#endif
+	free(m);
+}
+
+void sync_mutex_lock(SyncMutex *m)
+{
+#ifdef _WIN32
+	EnterCriticalSection(&m->m);
+#else
+	pthread_mutex_lock(&m->m);
+#endif
+}
+
+void sync_mutex_unlock(SyncMutex *m)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&m->m);
+#else
+	pthread_mutex_unlock(&m->m);
+#endif
+}
+
+SyncCond *sync_cond_create(void)
+{
+	SyncCond *c = xmalloc(sizeof(SyncCond));
+#ifdef _WIN32
+	InitializeConditionVariable(&c->c);
+#else
+	pthread_cond_init(&c->c, NULL);
+#endif
+	return c;
+}
+
+void sync_cond_free(SyncCond *c)
+{
+	if (!c)
+		return;
+#ifndef _WIN32
+	pthread_cond_destroy(&c->c);
+#endif
+	free(c);
+}
+
+void sync_cond_wait(SyncCond *c, SyncMutex *m)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS(&c->c, &m->m, INFINITE);
+#else
+	pthread_cond_wait(&c->c, &m->m);
+#endif
+}
+
+void sync_cond_broadcast(SyncCond *c)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(&c->c);
+#else
+	pthread_cond_broadcast(&c->c);
+#endif
+}
+
+#ifdef _WIN32
+static unsigned __stdcall thread_trampoline(void *p)
+{
+	SyncThread *t = p;
+	t->ret = t->fn(t->arg);
+	return 0;
+}
+#endif
+
+SyncThread *sync_thread_start(void *(*fn)(void *), void *arg)
+{
+	SyncThread *t = xmalloc(sizeof(SyncThread));
+#ifdef _WIN32
+	t->fn = fn;
+	t->arg = arg;
+	t->ret = NULL;
+	t->h = (HANDLE)_beginthreadex(NULL, 0, thread_trampoline, t, 0, NULL);
+	if (!t->h) {
+		free(t);
+		return NULL;
+	}
+#else
+	if (pthread_create(&t->t, NULL, fn, arg) != 0) {
+		free(t);
+		return NULL;
+	}
+#endif
+	return t;
+}
+
+void *sync_thread_join(SyncThread *t)
+{
+	void *ret = NULL;
+	if (!t)
+		return NULL;
+#ifdef _WIN32
+	WaitForSingleObject(t->h, INFINITE);
+	CloseHandle(t->h);
+	ret = t->ret;
+#else
+	pthread_join(t->t, &ret);
+#endif
+	free(t);
+	return ret;
+}
+
+int sync_cpu_count(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (int)si.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+void sync_yield(void)
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+double sync_now(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER f, c;
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return (double)c.QuadPart / (double)f.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
@@ -1,44 +1,204 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
 #include "train.h"
 #include "hash.h"
+#include "scan.h"
+#include "sync.h"
+#include "arena.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * 每个等级一个 SeatClassMap，两种布局并存：
+ *   rows    每座位一个 64 位字，第 k 位为 1 表示第 k 段已占用（按座位查/改）
+ *   seg_occ 每段一张座位位图，seg_occ[seg * stride + w] 的第 b 位对应座位 w*64+b（按区间找空座）
+ * stride 向上取整到 4 个字，超出 seat_count 的填充位恒为 1（视为占用）
+ *
+ * 懒分配：日期登记时不分配任何座位存储，cls[c] 为 NULL 表示该等级还没有售出，
+ * 所有这样的日期/等级共用“全空”这一表示，余票直接等于座位数；第一次售出时才分配该等级的
+ * seg_occ 与余票摘要，rows 再按 SEATMAP_CHUNK_SEATS 座一块（约一节车厢）在块内首次售出时分配，
+ * 未分配的块视为全空。seatmap_mem 统计这些存储的实际字节数。
+ *
+ * 余票摘要：每个座位的空闲段可拆成若干极大空闲区间 [a,b)，
+ * run_cnt[a*(S+1)+b] 记录该类座位中空闲区间恰为 [a,b) 的个数。
+ * 座位在 [i,j) 全程空闲当且仅当它有一个 a<=i、b>=j 的空闲区间，
+ * 故余票数是二维前缀和，用二维树状数组 run_bit 维护，查询与更新均为 O(log^2 S)。
+ * od_cache 缓存整张 OD 余票矩阵，座位有任何变动即失效。
+ * run_seats 为最佳适配策略的索引：每个 [a,b) 一张座位位图（stride 个字），
+ * 标出空闲区间恰为 [a,b) 的座位；首次按最佳适配分配时才建立。
+ *
+ * 并发：train_lock 保护车次表本身（增删改为写锁，其余为读锁）；
+ * 每个日历槽有自己的自旋锁 lock，同一车次同一日期的座位操作串行，不同车次/日期互不阻塞。
+ * 座位占用字 rows 是唯一的权威状态，所有修改都以 CAS 完成（占用时要求区间全程空闲），
+ * 其余结构随之以原子操作增量维护：seg_occ 只作为找座提示（可能短暂显示“空闲”，但不会误显示“占用”），
+ * 余票摘要的增量可交换，最终与占用字一致。ALLOC_LOCK_FREE 策略下分配/释放/查询不取槽位锁，
+ * 只把槽位的 active 计数加一以防止该日期被淘汰；最佳适配索引与 OD 缓存此时改为失效后重建。
+ * cls[c] 与 rows 的块指针都以 CAS 发布，两个线程同时首次售出时只有一个分配生效。
+ */
+typedef struct {
+    int segment_count;
+    int seat_count;
+    int stride;
+    int nchunks;
+    uint64_t *seg_occ;
+    int *run_cnt;
+    int *run_bit;
+    int *od_cache;
+    int od_version;           /* OD 缓存对应的 version，-1 表示无缓存 */
+    int version;              /* 每次座位变动加一 */
+    uint64_t *run_seats;
+    int run_stale;            /* 无锁模式下有座位变动，最佳适配索引需重建 */
+    uint64_t *rows[];         /* nchunks 个块，NULL 表示该块内没有售出 */
+} SeatClassMap;
 
 typedef struct {
-    char date[DATE_LEN];
+    SyncSpin lock;
+    int active;               /* 无锁模式下正在使用该槽位的线程数，淘汰前需等其归零 */
+    int day;                  /* train_date_to_day 得到的日序号，-1 表示空槽 */
     int segment_count;
-    unsigned char **class_seat_seg; 
+    SeatClassMap *cls[4];
 } TrainDateSeatMap;
 
 #define INITIAL_CAPACITY 8
 #define HASH_BUCKETS 1031
 
 static HashTable *train_ht = NULL;
+static SyncRWLock *train_lock = NULL;
+static int alloc_policy = ALLOC_FIRST_FIT;
+static struct { int64_t bytes; int dates, classes, chunks; } seatmap_mem;
 static void *xmalloc(size_t n) { void *p = malloc(n); if (!p) { perror("malloc"); exit(1);} return p; }
 
+/*
+ * 内存池：train_arena 存放各车次的 stops 与站点倒排列表（只在车次写锁下改动）；
+ * seat_arena 存放日历环与全部 seatmap 存储，订票时在读锁 + 槽位锁下并发分配，另以自旋锁保护。
+ * trainlist_free 整池归还，不再逐个车次、逐个日期释放。
+ */
+static Arena *train_arena = NULL;
+static Arena *seat_arena = NULL;
+static SyncSpin seat_arena_lock = 0;
+
+static void *seat_alloc(size_t n) {
+    sync_spin_lock(&seat_arena_lock);
+    void *p = arena_alloc(seat_arena, n);
+    sync_spin_unlock(&seat_arena_lock);
+    memset(p, 0, n);
+    return p;
+}
+
+static void seat_release(void *p, size_t n) {
+    sync_spin_lock(&seat_arena_lock);
+    arena_release(seat_arena, p, n);
+    sync_spin_unlock(&seat_arena_lock);
+}
+
+/* 把 stops 复制进 train_arena；stop_count 为 0 时为 NULL */
+static Stop *stops_copy_internal(const Stop *stops, int n) {
+    if (n <= 0 || !stops) return NULL;
+    Stop *s = arena_alloc(train_arena, sizeof(Stop) * n);
+    memcpy(s, stops, sizeof(Stop) * n);
+    return s;
+}
+
+static void stops_release_internal(Train *t) {
+    if (t->stops) arena_release(train_arena, t->stops, sizeof(Stop) * t->stop_count);
+    t->stops = NULL;
+}
+
+/*
+ * 站点倒排索引：站名 -> 经停该站的 (车次下标, 站序) 列表，列表按 (车次下标, 站序) 递增，
+ * 查询“A 到 B”时两张列表归并即可，耗时与经停这两站的车次数成正比。随车次增删改在写锁下维护。
+ */
+typedef struct { int train; int stop; } StationStop;
+typedef struct { StationStop *items; int size; int capacity; } StationStops;
+
+static HashTable *station_ht = NULL;
+static StationStops *station_lists = NULL;
+static int station_count = 0, station_capacity = 0;
+
+static void station_index_clear_internal(void) {
+    for (int i = 0; i < station_count; ++i)
+        arena_release(train_arena, station_lists[i].items, sizeof(StationStop) * station_lists[i].capacity);
+    station_count = 0;
+    if (station_ht) ht_clear(station_ht);
+}
+
+/* 车次表的修改计数（增量保存据此判断快照是否过期） */
+static volatile int64_t train_version_seq = 0;
+
+long long train_version(void) { return sync_fetch_add64(&train_version_seq, 0); }
+
+/* train_evict_before 的截止日序号：更早的日期已淘汰，不再售票，余票查询按无效参数返回 -1 */
+static volatile int evict_floor = -1;
+
 void trainlist_init(TrainList *L) {
+    sync_fetch_add64(&train_version_seq, 1);
+    sync_store(&evict_floor, -1);
     L->data = xmalloc(sizeof(Train) * INITIAL_CAPACITY);
     L->size = 0; L->capacity = INITIAL_CAPACITY;
+    if (!train_arena) train_arena = arena_create(0);
+    if (!seat_arena) seat_arena = arena_create(0);
     if (!train_ht) train_ht = ht_create(HASH_BUCKETS);
+    else ht_clear(train_ht);
+    station_index_clear_internal();
+    if (!train_lock) train_lock = sync_rwlock_create();
+}
+
+static void seat_class_free_internal(SeatClassMap *cm);
+
+/* 先把槽位标为空，再等待无锁模式下仍在使用它的线程退出，然后才释放内存 */
+static void seatmap_free_internal(TrainDateSeatMap *sm) {
+    sync_store(&sm->day, -1);
+    sync_fence();
+    while (sync_load(&sm->active)) sync_yield();
+    for (int c = 0; c < 4; ++c) {
+        seat_class_free_internal(sm->cls[c]);
+        sm->cls[c] = NULL;
+    }
+    sm->segment_count = 0;
+}
+
+static void train_free_seatmaps_internal(Train *t) {
+    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps;
+    if (!sm) return;
+    for (int j = 0; j < SEATMAP_WINDOW_DAYS; ++j)
+        if (sm[j].day != -1) { seatmap_free_internal(&sm[j]); sync_fetch_add(&seatmap_mem.dates, -1); }
+    seat_release(sm, sizeof(TrainDateSeatMap) * SEATMAP_WINDOW_DAYS);
+    sync_fetch_add64(&seatmap_mem.bytes, -(int64_t)(sizeof(TrainDateSeatMap) * SEATMAP_WINDOW_DAYS));
+    t->seatmaps = NULL;
+    t->seatmap_count = t->seatmap_capacity = 0;
 }
 
+/* stops、站点列表与 seatmap 都在内存池中，随池整体归还 */
 void trainlist_free(TrainList *L) {
     if (!L) return;
-    for (int i = 0; i < L->size; ++i) {
-        free(L->data[i].stops);
-        TrainDateSeatMap *sm = (TrainDateSeatMap*)L->data[i].seatmaps;
-        if (sm) {
-            for (int j = 0; j < L->data[i].seatmap_count; ++j) {
-                for (int c = 0; c < 4; ++c) if (sm[j].class_seat_seg[c]) free(sm[j].class_seat_seg[c]);
-                free(sm[j].class_seat_seg);
-            }
-            free(sm);
-        }
-    }
+    sync_fetch_add64(&train_version_seq, 1);
     free(L->data);
     L->data = NULL;
     L->size = L->capacity = 0;
     if (train_ht) { ht_free(train_ht); train_ht = NULL; }
+    station_count = 0;
+    if (station_ht) { ht_free(station_ht); station_ht = NULL; }
+    free(station_lists);
+    station_lists = NULL;
+    station_capacity = 0;
+    arena_destroy(train_arena);
+    arena_destroy(seat_arena);
+    train_arena = seat_arena = NULL;
+    memset(&seatmap_mem, 0, sizeof(seatmap_mem));
+    if (train_lock) { sync_rwlock_free(train_lock); train_lock = NULL; }
 }
 
 static void trainlist_expand(TrainList *L) {
@@ -47,140 +207,646 @@ static void trainlist_expand(TrainList *L) {
     if (!L->data) { perror("realloc"); exit(1); }
 }
 
-static void rebuild_index(TrainList *L) {
-    if (!train_ht) train_ht = ht_create(HASH_BUCKETS);
-    else ht_clear(train_ht);
-    for (int i = 0; i < L->size; ++i) ht_insert(train_ht, L->data[i].train_id, i);
+/*
+ * 索引随增删改增量维护，不再整表重建。车次号重复时索引指向下标最大的那一个；
+ * 被删除/改名的车次若正是索引指向的那个，就从剩下的车次里找同名者补上。
+ */
+static void index_drop_internal(TrainList *L, const char *train_id, int idx) {
+    if (ht_find(train_ht, train_id) != idx) return;
+    ht_remove(train_ht, train_id);
+    for (int i = L->size - 1; i >= 0; --i)
+        if (i != idx && strcmp(L->data[i].train_id, train_id) == 0) { ht_insert(train_ht, train_id, i); break; }
 }
 
-static int train_find_seatmap_idx_internal(Train *t, const char *date) {
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps;
-    for (int i = 0; i < t->seatmap_count; ++i) if (strcmp(sm[i].date, date) == 0) return i;
-    return -1;
+/* data[idx] 已被删除、其后元素前移一位之后调用；train_id 为被删车次号的副本 */
+static void index_erase_shift_internal(TrainList *L, const char *train_id, int idx) {
+    index_drop_internal(L, train_id, idx);
+    for (int i = idx; i < L->size; ++i)
+        if (ht_find(train_ht, L->data[i].train_id) == i + 1) ht_update(train_ht, L->data[i].train_id, i);
+}
+
+static void station_index_add_internal(TrainList *L, int idx) {
+    Train *t = &L->data[idx];
+    if (!station_ht) station_ht = ht_create(HASH_BUCKETS);
+    for (int k = 0; k < t->stop_count; ++k) {
+        int li = ht_find(station_ht, t->stops[k].name);
+        if (li == -1) {
+            if (station_count >= station_capacity) {
+                station_capacity = station_capacity ? station_capacity * 2 : INITIAL_CAPACITY;
+                station_lists = realloc(station_lists, sizeof(StationStops) * station_capacity);
+                if (!station_lists) { perror("realloc"); exit(1); }
+            }
+            li = station_count++;
+            memset(&station_lists[li], 0, sizeof(StationStops));
+            ht_insert(station_ht, t->stops[k].name, li);
+        }
+        StationStops *l = &station_lists[li];
+        if (l->size >= l->capacity) {
+            int old = l->capacity;
+            l->capacity = l->capacity ? l->capacity * 2 : 4;
+            l->items = arena_realloc(train_arena, l->items, sizeof(StationStop) * old, sizeof(StationStop) * l->capacity);
+        }
+        /* 新增车次总在末尾，通常直接追加；修改车次时插回原下标的位置 */
+        int pos = l->size;
+        while (pos > 0 && (l->items[pos-1].train > idx || (l->items[pos-1].train == idx && l->items[pos-1].stop > k))) pos--;
+        memmove(&l->items[pos + 1], &l->items[pos], sizeof(StationStop) * (l->size - pos));
+        l->items[pos].train = idx;
+        l->items[pos].stop = k;
+        l->size++;
+    }
+}
+
+/*
+ * 去掉车次下标 idx 的所有站点项；shift 为 1 时其后车次的下标减一。
+ * 扫描全部列表而不按 stops 查找：调用方可能已就地改了站名（train_get 副本共用 stops）。
+ */
+static void station_index_remove_internal(int idx, int shift) {
+    for (int li = 0; li < station_count; ++li) {
+        StationStops *l = &station_lists[li];
+        int w = 0;
+        for (int r = 0; r < l->size; ++r) {
+            if (l->items[r].train == idx) continue;
+            l->items[w] = l->items[r];
+            if (shift && l->items[w].train > idx) l->items[w].train--;
+            w++;
+        }
+        l->size = w;
+    }
+}
+
+static int days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+int train_date_to_day(const char *date) {
+    static const int mdays[12] = {31,29,31,30,31,30,31,31,30,31,30,31};
+    if (!date) return -1;
+    for (int i = 0; i < 10; ++i) {
+        if (i == 4 || i == 7) { if (date[i] != '-') return -1; }
+        else if (date[i] < '0' || date[i] > '9') return -1;
+    }
+    if (date[10] != 0) return -1;
+    int y = (date[0]-'0')*1000 + (date[1]-'0')*100 + (date[2]-'0')*10 + (date[3]-'0');
+    int m = (date[5]-'0')*10 + (date[6]-'0');
+    int d = (date[8]-'0')*10 + (date[9]-'0');
+    if (m < 1 || m > 12 || d < 1 || d > mdays[m-1]) return -1;
+    if (m == 2 && d == 29 && !((y % 4 == 0 && y % 100 != 0) || y % 400 == 0)) return -1;
+    int day = days_from_civil(y, m, d);
+    return day < 0 ? -1 : day;
+}
+
+int train_today(void) {
+    time_t now = time(NULL);
+    struct tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &now);
+#else
+    localtime_r(&now, &tm);
+#endif
+    return days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+void train_day_to_date(int day, char *out, size_t outlen) {
+    int z = day + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    int y = yoe + era * 400;
+    int doy = doe - (365*yoe + yoe/4 - yoe/100);
+    int mp = (5*doy + 2) / 153;
+    int d = doy - (153*mp + 2)/5 + 1;
+    int m = mp + (mp < 10 ? 3 : -9);
+    snprintf(out, outlen, "%04d-%02d-%02d", y + (m <= 2), m, d);
+}
+
+/* 日历环：槽位 day % SEATMAP_WINDOW_DAYS，O(1) 定位；环首次使用时分配，以 CAS 发布 */
+static TrainDateSeatMap *train_slot_internal(Train *t, int day, int create) {
+    if (day < 0) return NULL;
+    TrainDateSeatMap *ring = sync_load_ptr(&t->seatmaps);
+    if (!ring) {
+        if (!create) return NULL;
+        ring = seat_alloc(sizeof(TrainDateSeatMap) * SEATMAP_WINDOW_DAYS);
+        for (int i = 0; i < SEATMAP_WINDOW_DAYS; ++i) ring[i].day = -1;
+        if (sync_cas_ptr(&t->seatmaps, NULL, ring)) {
+            sync_fetch_add64(&seatmap_mem.bytes, (int64_t)(sizeof(TrainDateSeatMap) * SEATMAP_WINDOW_DAYS));
+        } else {
+            seat_release(ring, sizeof(TrainDateSeatMap) * SEATMAP_WINDOW_DAYS);
+            ring = sync_load_ptr(&t->seatmaps);
+        }
+    }
+    return ring + day % SEATMAP_WINDOW_DAYS;
+}
+
+/* 以下 seatmap 查找/创建函数均要求已持有槽位锁 */
+static TrainDateSeatMap *train_find_seatmap_internal(TrainDateSeatMap *slot, int day) {
+    return (slot && slot->day == day) ? slot : NULL;
+}
+
+static uint64_t seg_mask(int from_idx, int to_idx) {
+    int n = to_idx - from_idx;
+    uint64_t m = (n >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1);
+    return m << from_idx;
+}
+
+static int ctz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i; _BitScanForward64(&i, x); return (int)i;
+#else
+    int n = 0; while (!(x & 1)) { x >>= 1; ++n; } return n;
+#endif
+}
+
+/* 空闲区间 [a,b) 的计数加 delta，同时更新树状数组（a 正序、S-b 正序）；原子加，可与其它线程的增量交换顺序 */
+static void seatmap_run_add_internal(SeatClassMap *cm, int a, int b, int delta) {
+    int S = cm->segment_count, n = S + 1;
+    sync_fetch_add(&cm->run_cnt[a * n + b], delta);
+    for (int x = a + 1; x <= n; x += x & -x)
+        for (int y = S - b + 1; y <= n; y += y & -y)
+            sync_fetch_add(&cm->run_bit[x * (n + 1) + y], delta);
+}
+
+/* a <= i 且 b >= j 的空闲区间总数，即 [i,j) 全程空闲的座位数 */
+static int seatmap_run_query_internal(SeatClassMap *cm, int i, int j) {
+    int S = cm->segment_count, n = S + 1, sum = 0;
+    for (int x = i + 1; x > 0; x -= x & -x)
+        for (int y = S - j + 1; y > 0; y -= y & -y)
+            sum += sync_load(&cm->run_bit[x * (n + 1) + y]);
+    return sum;
+}
+
+/* 整个等级的存储：头部、块指针表、seg_occ、run_cnt、run_bit 一次分配 */
+static size_t seat_class_bytes_internal(int segs, int seats) {
+    int stride = ((seats + 63) / 64 + 3) & ~3, nchunks = (seats + SEATMAP_CHUNK_SEATS - 1) / SEATMAP_CHUNK_SEATS;
+    return sizeof(SeatClassMap) + sizeof(uint64_t*) * nchunks + sizeof(uint64_t) * (size_t)stride * segs
+           + sizeof(int) * ((size_t)(segs + 1) * (segs + 1) + (size_t)(segs + 2) * (segs + 2));
+}
+
+static SeatClassMap *seat_class_create_internal(int segs, int seats) {
+    size_t bytes = seat_class_bytes_internal(segs, seats);
+    SeatClassMap *cm = seat_alloc(bytes);
+    cm->segment_count = segs;
+    cm->seat_count = seats;
+    cm->stride = ((seats + 63) / 64 + 3) & ~3;
+    cm->nchunks = (seats + SEATMAP_CHUNK_SEATS - 1) / SEATMAP_CHUNK_SEATS;
+    cm->seg_occ = (uint64_t*)(cm->rows + cm->nchunks);
+    cm->run_cnt = (int*)(cm->seg_occ + (size_t)cm->stride * segs);
+    cm->run_bit = cm->run_cnt + (size_t)(segs + 1) * (segs + 1);
+    cm->od_version = -1;
+    for (int seg = 0; seg < segs; ++seg) {
+        uint64_t *occ = cm->seg_occ + (size_t)seg * cm->stride;
+        if (seats % 64) occ[seats / 64] = ~(uint64_t)0 << (seats % 64);
+        for (int w = (seats + 63) / 64; w < cm->stride; ++w) occ[w] = ~(uint64_t)0;
+    }
+    seatmap_run_add_internal(cm, 0, segs, seats);
+    sync_fetch_add64(&seatmap_mem.bytes, (int64_t)bytes);
+    sync_fetch_add(&seatmap_mem.classes, 1);
+    return cm;
+}
+
+static void seat_class_free_internal(SeatClassMap *cm) {
+    if (!cm) return;
+    int n = cm->segment_count + 1;
+    int64_t bytes = (int64_t)seat_class_bytes_internal(cm->segment_count, cm->seat_count);
+    int chunks = 0;
+    for (int k = 0; k < cm->nchunks; ++k)
+        if (cm->rows[k]) { seat_release(cm->rows[k], SEATMAP_CHUNK_SEATS * sizeof(uint64_t)); ++chunks; }
+    bytes += (int64_t)chunks * SEATMAP_CHUNK_SEATS * sizeof(uint64_t);
+    if (cm->od_cache) { seat_release(cm->od_cache, sizeof(int) * n * n); bytes += (int64_t)sizeof(int) * n * n; }
+    if (cm->run_seats) {
+        seat_release(cm->run_seats, sizeof(uint64_t) * n * n * cm->stride);
+        bytes += (int64_t)sizeof(uint64_t) * n * n * cm->stride;
+    }
+    sync_fetch_add64(&seatmap_mem.bytes, -bytes);
+    sync_fetch_add(&seatmap_mem.classes, -1);
+    sync_fetch_add(&seatmap_mem.chunks, -chunks);
+    seat_release(cm, seat_class_bytes_internal(cm->segment_count, cm->seat_count));
+}
+
+/* 取等级 c 的存储；尚未分配且 create 为 1 时分配并以 CAS 发布 */
+static SeatClassMap *seatmap_class_internal(TrainDateSeatMap *sm, Train *t, int seat_class, int create) {
+    if (seat_class < 0 || seat_class >= 4) return NULL;
+    SeatClassMap *cm = sync_load_ptr((void**)&sm->cls[seat_class]);
+    if (cm || !create || t->seat_count[seat_class] <= 0 || sm->segment_count <= 0) return cm;
+    cm = seat_class_create_internal(sm->segment_count, t->seat_count[seat_class]);
+    if (!sync_cas_ptr((void**)&sm->cls[seat_class], NULL, cm)) {
+        seat_class_free_internal(cm);
+        cm = sync_load_ptr((void**)&sm->cls[seat_class]);
+    }
+    return cm;
+}
+
+static uint64_t seat_row_get_internal(SeatClassMap *cm, int seat) {
+    uint64_t *chunk = sync_load_ptr((void**)&cm->rows[seat / SEATMAP_CHUNK_SEATS]);
+    return chunk ? sync_load_u64(&chunk[seat % SEATMAP_CHUNK_SEATS]) : 0;
+}
+
+/* 座位所在块的占用字地址，块尚未分配时分配并以 CAS 发布 */
+static uint64_t *seat_row_ptr_internal(SeatClassMap *cm, int seat) {
+    int k = seat / SEATMAP_CHUNK_SEATS;
+    uint64_t *chunk = sync_load_ptr((void**)&cm->rows[k]);
+    if (!chunk) {
+        chunk = seat_alloc(SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+        if (sync_cas_ptr((void**)&cm->rows[k], NULL, chunk)) {
+            sync_fetch_add64(&seatmap_mem.bytes, SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+            sync_fetch_add(&seatmap_mem.chunks, 1);
+        } else {
+            seat_release(chunk, SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+            chunk = sync_load_ptr((void**)&cm->rows[k]);
+        }
+    }
+    return &chunk[seat % SEATMAP_CHUNK_SEATS];
+}
+
+/* 拆出一行占用字中的极大空闲区间，返回区间个数 */
+static int row_free_runs(uint64_t row, int segs, int *ra, int *rb) {
+    uint64_t f = ~row & seg_mask(0, segs);
+    int k = 0;
+    while (f) {
+        int a = ctz64(f);
+        uint64_t x = ~(f >> a);
+        int b = x ? a + ctz64(x) : 64;
+        ra[k] = a; rb[k] = b; ++k;
+        f &= ~seg_mask(a, b);
+    }
+    return k;
+}
+
+/* 座位占用字由 old_row 变为 new_row 时，只对发生变化的空闲区间增量更新摘要 */
+static void seatmap_run_seat_internal(SeatClassMap *cm, int seat_index, int a, int b, int on) {
+    uint64_t *runs = cm->run_seats;
+    if (!runs || alloc_policy == ALLOC_LOCK_FREE) return;
+    size_t off = (size_t)(a * (cm->segment_count + 1) + b) * cm->stride + seat_index / 64;
+    uint64_t bit = (uint64_t)1 << (seat_index % 64);
+    if (on) runs[off] |= bit; else runs[off] &= ~bit;
 }
 
-static int train_create_seatmap_if_missing_internal(Train *t, const char *date) {
-    int idx = train_find_seatmap_idx_internal(t, date);
-    if (idx != -1) return idx;
-    if (t->seatmap_capacity == 0) {
-        t->seatmap_capacity = 4;
-        t->seatmaps = xmalloc(sizeof(TrainDateSeatMap) * t->seatmap_capacity);
-    } else if (t->seatmap_count >= t->seatmap_capacity) {
-        t->seatmap_capacity *= 2;
-        t->seatmaps = realloc(t->seatmaps, sizeof(TrainDateSeatMap) * t->seatmap_capacity);
-        if (!t->seatmaps) { perror("realloc"); exit(1); }
+static void seatmap_row_changed_internal(SeatClassMap *cm, int seat_index, uint64_t old_row, uint64_t new_row) {
+    if (alloc_policy == ALLOC_LOCK_FREE && cm->run_seats) sync_store(&cm->run_stale, 1);
+    int oa[33], ob[33], na[33], nb[33];
+    int S = cm->segment_count;
+    int on = row_free_runs(old_row, S, oa, ob);
+    int nn = row_free_runs(new_row, S, na, nb);
+    int i = 0, j = 0;
+    while (i < on || j < nn) {
+        if (i < on && j < nn && oa[i] == na[j] && ob[i] == nb[j]) { ++i; ++j; }
+        else if (j >= nn || (i < on && oa[i] <= na[j])) {
+            seatmap_run_add_internal(cm, oa[i], ob[i], -1);
+            seatmap_run_seat_internal(cm, seat_index, oa[i], ob[i], 0);
+            ++i;
+        } else {
+            seatmap_run_add_internal(cm, na[j], nb[j], 1);
+            seatmap_run_seat_internal(cm, seat_index, na[j], nb[j], 1);
+            ++j;
+        }
+    }
+}
+
+/* 槽位上的日期已过（早于今天）且早于 day：该日期已无人再买，槽位可让给 day */
+static int seatmap_slot_stale_internal(int slot_day, int day) {
+    return slot_day != -1 && slot_day < day && slot_day < train_today();
+}
+
+/*
+ * 槽位空闲时登记 day（不分配座位存储）；槽位上是已过期的更早日期时先淘汰它再登记。
+ * 槽位被另一个未过期的日期占用时返回 NULL，即两个未来日期争用同一槽位，day 不在售票窗口内
+ */
+static TrainDateSeatMap *train_create_seatmap_if_missing_internal(Train *t, TrainDateSeatMap *sm, int day) {
+    if (!sm) return NULL;
+    if (sm->day == day) return sm;
+    if (seatmap_slot_stale_internal(sm->day, day)) {
+        seatmap_free_internal(sm);
+        sync_fetch_add(&t->seatmap_count, -1);
+        sync_fetch_add(&seatmap_mem.dates, -1);
     }
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps + t->seatmap_count;
-    strncpy(sm->date, date, DATE_LEN-1); sm->date[DATE_LEN-1] = 0;
+    if (sm->day != -1) return NULL;
     sm->segment_count = (t->stop_count >= 1) ? (t->stop_count - 1) : 0;
-    sm->class_seat_seg = xmalloc(sizeof(unsigned char*) * 4);
-    for (int c = 0; c < 4; ++c) {
-        int sc = t->seat_count[c];
-        if (sc > 0 && sm->segment_count > 0) {
-            sm->class_seat_seg[c] = calloc(sc * sm->segment_count, 1);
-            if (!sm->class_seat_seg[c]) { perror("calloc"); exit(1); }
-        } else sm->class_seat_seg[c] = NULL;
-    }
-    t->seatmap_count++;
-    return t->seatmap_count - 1;
-}
-
-static int seatmap_allocate_internal(TrainDateSeatMap *sm, Train *t, int seat_class, int from_idx, int to_idx) {
-    if (!sm) return -1;
-    int segs = sm->segment_count;
-    if (from_idx < 0 || to_idx <= from_idx || to_idx > segs) return -1;
-    int sc = t->seat_count[seat_class];
-    unsigned char *arr = sm->class_seat_seg[seat_class];
-    if (!arr) return -1;
-    for (int s = 0; s < sc; ++s) {
-        int base = s * segs;
-        int ok = 1;
-        for (int seg = from_idx; seg < to_idx; ++seg) if (arr[base + seg]) { ok = 0; break; }
-        if (ok) {
-            for (int seg = from_idx; seg < to_idx; ++seg) arr[base + seg] = 1;
-            return s;
+    for (int c = 0; c < 4; ++c) sm->cls[c] = NULL;
+    sync_fetch_add(&t->seatmap_count, 1);
+    sync_fetch_add(&seatmap_mem.dates, 1);
+    sync_store(&sm->day, day);  /* 最后发布日期，无锁读者看到 day 时其余字段已就绪 */
+    return sm;
+}
+
+/*
+ * 以 CAS 修改座位占用字：on 为 1 时要求 [from,to) 全程空闲，否则不做修改返回 -1；on 为 0 释放。
+ * 占用字成功变化后再同步段位图与余票摘要。
+ */
+static int seatmap_set_internal(SeatClassMap *cm, int seat_index, int from_idx, int to_idx, int on) {
+    uint64_t mask = seg_mask(from_idx, to_idx);
+    int stride = cm->stride;
+    uint64_t *occ = cm->seg_occ + seat_index / 64;
+    uint64_t bit = (uint64_t)1 << (seat_index % 64);
+    uint64_t old_row, new_row;
+    if (on) {
+        uint64_t *row = seat_row_ptr_internal(cm, seat_index);
+        old_row = sync_load_u64(row);
+        do {
+            if (old_row & mask) return -1;
+            new_row = old_row | mask;
+        } while (!sync_cas_u64(row, &old_row, new_row));
+        for (int seg = from_idx; seg < to_idx; ++seg) sync_or_u64(&occ[(size_t)seg * stride], bit);
+    } else {
+        uint64_t *chunk = sync_load_ptr((void**)&cm->rows[seat_index / SEATMAP_CHUNK_SEATS]);
+        if (!chunk) return 0;
+        old_row = sync_and_u64(&chunk[seat_index % SEATMAP_CHUNK_SEATS], ~mask);
+        new_row = old_row & ~mask;
+        for (int seg = from_idx; seg < to_idx; ++seg) sync_and_u64(&occ[(size_t)seg * stride], ~bit);
+    }
+    seatmap_row_changed_internal(cm, seat_index, old_row, new_row);
+    sync_fetch_add(&cm->version, 1);
+    return 0;
+}
+
+/* 无锁模式下的找座：逐字原子读取段位图，从 start 号座位起返回第一个看似全程空闲的座位 */
+static int seatmap_find_free_shared_internal(SeatClassMap *cm, int from_idx, int to_idx, int start) {
+    int stride = cm->stride;
+    uint64_t *occ = cm->seg_occ;
+    for (int w = start / 64; w < stride; ++w) {
+        uint64_t acc = (w == start / 64) ? ((uint64_t)1 << (start % 64)) - 1 : 0;
+        for (int seg = from_idx; seg < to_idx && ~acc; ++seg) acc |= sync_load_u64(&occ[(size_t)seg * stride + w]);
+        if (~acc) return w * 64 + ctz64(~acc);
+    }
+    return -1;
+}
+
+/*
+ * 区间 [from,to) 上各段占用位图按字取或，返回 start 号座位起第一个全程空闲的座位；
+ * 代价与段数 × 座位数/64 成正比，与满座程度无关
+ */
+static int seatmap_find_free_internal(SeatClassMap *cm, int from_idx, int to_idx, int start) {
+    if (alloc_policy == ALLOC_LOCK_FREE) return seatmap_find_free_shared_internal(cm, from_idx, to_idx, start);
+    int stride = cm->stride;
+    const uint64_t *occ = cm->seg_occ;
+    for (int w = (start / 64) & ~3; w < stride; w += 4) {
+        const uint64_t *p = occ + (size_t)from_idx * stride + w;
+#if defined(__AVX2__)
+        __m256i acc = _mm256_loadu_si256((const __m256i*)p);
+        for (int seg = from_idx + 1; seg < to_idx; ++seg) {
+            p += stride;
+            acc = _mm256_or_si256(acc, _mm256_loadu_si256((const __m256i*)p));
+        }
+        if (_mm256_testc_si256(acc, _mm256_set1_epi32(-1))) continue;
+        uint64_t word[4];
+        _mm256_storeu_si256((__m256i*)word, acc);
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128i lo = _mm_loadu_si128((const __m128i*)p);
+        __m128i hi = _mm_loadu_si128((const __m128i*)(p + 2));
+        for (int seg = from_idx + 1; seg < to_idx; ++seg) {
+            p += stride;
+            lo = _mm_or_si128(lo, _mm_loadu_si128((const __m128i*)p));
+            hi = _mm_or_si128(hi, _mm_loadu_si128((const __m128i*)(p + 2)));
+        }
+        __m128i ones = _mm_set1_epi32(-1);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), ones)) == 0xFFFF) continue;
+        uint64_t word[4];
+        _mm_storeu_si128((__m128i*)word, lo);
+        _mm_storeu_si128((__m128i*)(word + 2), hi);
+#else
+        uint64_t word[4] = { p[0], p[1], p[2], p[3] };
+        for (int seg = from_idx + 1; seg < to_idx; ++seg) {
+            p += stride;
+            word[0] |= p[0]; word[1] |= p[1]; word[2] |= p[2]; word[3] |= p[3];
+        }
+#endif
+        for (int k = 0; k < 4; ++k) {
+            if (w + k < start / 64) continue;
+            if (w + k == start / 64) word[k] |= ((uint64_t)1 << (start % 64)) - 1;
+            if (~word[k]) return (w + k) * 64 + ctz64(~word[k]);
         }
     }
     return -1;
 }
 
-static void seatmap_release_internal(TrainDateSeatMap *sm, Train *t, int seat_class, int seat_index, int from_idx, int to_idx) {
-    if (!sm) return;
-    int segs = sm->segment_count;
-    unsigned char *arr = sm->class_seat_seg[seat_class];
-    if (!arr) return;
-    int base = seat_index * segs;
-    for (int seg = from_idx; seg < to_idx; ++seg) arr[base + seg] = 0;
-}
-
-static int seatmap_mark_index_internal(TrainDateSeatMap *sm, Train *t, int seat_class, int seat_index, int from_idx, int to_idx) {
-    if (!sm) return -1;
-    int segs = sm->segment_count;
-    if (!sm->class_seat_seg[seat_class]) return -1;
-    if (seat_index < 0 || seat_index >= t->seat_count[seat_class]) return -1;
-    if (from_idx < 0 || to_idx <= from_idx || to_idx > segs) return -1;
-    unsigned char *arr = sm->class_seat_seg[seat_class];
-    int base = seat_index * segs;
-    for (int seg = from_idx; seg < to_idx; ++seg) arr[base + seg] = 1;
+/* 先清失效标记再读占用字：重建期间有无锁修改时标记会被重新置上，下次再重建 */
+static void seatmap_build_run_seats_internal(SeatClassMap *cm) {
+    int n = cm->segment_count + 1, stride = cm->stride;
+    size_t bytes = sizeof(uint64_t) * (size_t)n * n * stride;
+    sync_store(&cm->run_stale, 0);
+    if (cm->run_seats) memset(cm->run_seats, 0, bytes);
+    else {
+        cm->run_seats = seat_alloc(bytes);
+        sync_fetch_add64(&seatmap_mem.bytes, (int64_t)bytes);
+    }
+    int ra[33], rb[33];
+    for (int s = 0; s < cm->seat_count; ++s) {
+        int k = row_free_runs(seat_row_get_internal(cm, s), cm->segment_count, ra, rb);
+        for (int i = 0; i < k; ++i) seatmap_run_seat_internal(cm, s, ra[i], rb[i], 1);
+    }
+}
+
+/* 最佳适配：按多余段数 (from-a)+(b-to) 从小到大找第一个非空的空闲区间桶，桶内取第一个座位 */
+static int seatmap_find_best_fit_internal(SeatClassMap *cm, int from_idx, int to_idx) {
+    if (!cm->run_seats || sync_load(&cm->run_stale)) seatmap_build_run_seats_internal(cm);
+    int S = cm->segment_count, n = S + 1, stride = cm->stride;
+    const int *cnt = cm->run_cnt;
+    for (int waste = 0; waste <= from_idx + S - to_idx; ++waste) {
+        for (int da = 0; da <= waste && da <= from_idx; ++da) {
+            int a = from_idx - da, b = to_idx + waste - da;
+            if (b > S || !cnt[a * n + b]) continue;
+            const uint64_t *bucket = cm->run_seats + (size_t)(a * n + b) * stride;
+            for (int w = 0; w < stride; ++w)
+                if (bucket[w]) return w * 64 + ctz64(bucket[w]);
+        }
+    }
+    return -1;
+}
+
+static int seatmap_allocate_internal(SeatClassMap *cm, int from_idx, int to_idx) {
+    if (!cm) return -1;
+    if (from_idx < 0 || to_idx <= from_idx || to_idx > cm->segment_count) return -1;
+    int s = (alloc_policy == ALLOC_BEST_FIT)
+            ? seatmap_find_best_fit_internal(cm, from_idx, to_idx)
+            : seatmap_find_free_internal(cm, from_idx, to_idx, 0);
+    /* 提示位图可能滞后于占用字（其它线程刚抢到该座），CAS 失败时跳过该座继续往后找 */
+    while (s >= 0 && s < cm->seat_count) {
+        if (seatmap_set_internal(cm, s, from_idx, to_idx, 1) == 0) return s;
+        s = seatmap_find_free_internal(cm, from_idx, to_idx, s + 1);
+    }
+    return -1;
+}
+
+/*
+ * 一次扫描为 n 人找座：逐字求出区间内全程空闲的座位位图，按位跟踪跨字的连续空座；
+ * 找到 n 个连号空座即返回，否则退而取最先出现的 n 个空座；座位不足返回 -1。
+ */
+static int seatmap_pick_group_internal(SeatClassMap *cm, int from_idx, int to_idx, int n, int *out) {
+    int stride = cm->stride;
+    uint64_t *occ = cm->seg_occ;
+    int nfree = 0, run_start = 0, run_len = 0, found = -1;
+    for (int w = 0; w < stride && found == -1; ++w) {
+        uint64_t acc = sync_load_u64(&occ[(size_t)from_idx * stride + w]);
+        for (int seg = from_idx + 1; seg < to_idx; ++seg) acc |= sync_load_u64(&occ[(size_t)seg * stride + w]);
+        uint64_t x = ~acc;
+        int b = 0;
+        while (b < 64) {
+            uint64_t rest = x >> b;
+            if (!rest) { run_len = 0; break; }
+            int z = ctz64(rest);
+            if (z) { run_len = 0; b += z; continue; }
+            uint64_t inv = ~rest;
+            int ones = inv ? ctz64(inv) : 64 - b;
+            if (!run_len) run_start = w * 64 + b;
+            run_len += ones;
+            for (int k = 0; k < ones && nfree < n; ++k) out[nfree++] = w * 64 + b + k;
+            if (run_len >= n) { found = run_start; break; }
+            b += ones;
+        }
+    }
+    if (found != -1)
+        for (int k = 0; k < n; ++k) out[k] = found + k;
+    else if (nfree < n)
+        return -1;
     return 0;
 }
 
+/* 选出的座位逐个 CAS 占用；若有座位已被无锁分配抢走，退回已占的座位重新挑选，最多重试几次 */
+static int seatmap_allocate_group_internal(SeatClassMap *cm, int from_idx, int to_idx, int n, int *out) {
+    if (!cm || n <= 0 || n > cm->seat_count) return -1;
+    if (from_idx < 0 || to_idx <= from_idx || to_idx > cm->segment_count) return -1;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        if (seatmap_pick_group_internal(cm, from_idx, to_idx, n, out) != 0) return -1;
+        int k = 0;
+        while (k < n && seatmap_set_internal(cm, out[k], from_idx, to_idx, 1) == 0) ++k;
+        if (k == n) return 0;
+        while (k-- > 0) seatmap_set_internal(cm, out[k], from_idx, to_idx, 0);
+    }
+    return -1;
+}
+
+static void seatmap_release_internal(SeatClassMap *cm, int seat_index, int from_idx, int to_idx) {
+    if (!cm) return;
+    if (seat_index < 0 || seat_index >= cm->seat_count) return;
+    if (from_idx < 0 || to_idx <= from_idx || to_idx > cm->segment_count) return;
+    seatmap_set_internal(cm, seat_index, from_idx, to_idx, 0);
+}
 
-int train_add(TrainList *L, Train *t) {
+static int seatmap_mark_index_internal(SeatClassMap *cm, int seat_index, int from_idx, int to_idx) {
+    if (!cm) return -1;
+    if (seat_index < 0 || seat_index >= cm->seat_count) return -1;
+    if (from_idx < 0 || to_idx <= from_idx || to_idx > cm->segment_count) return -1;
+    return seatmap_set_internal(cm, seat_index, from_idx, to_idx, 1);
+}
+
+
+void train_set_alloc_policy(int policy) {
+    alloc_policy = (policy == ALLOC_BEST_FIT || policy == ALLOC_LOCK_FREE) ? policy : ALLOC_FIRST_FIT;
+}
+
+int train_get_alloc_policy(void) {
+    return alloc_policy;
+}
+
+
+static int train_find_index_internal(TrainList *L, const char *train_id) {
+    if (train_ht) return ht_find(train_ht, train_id);
+    for (int i = 0; i < L->size; ++i) if (strcmp(L->data[i].train_id, train_id) == 0) return i;
+    return -1;
+}
+
+/* 读锁下按车次号取车次；找不到时释放读锁并返回 NULL */
+static Train *train_rdlock_find_internal(TrainList *L, const char *train_id) {
+    sync_rwlock_rdlock(train_lock);
+    int idx = train_find_index_internal(L, train_id);
+    if (idx == -1) { sync_rwlock_rdunlock(train_lock); return NULL; }
+    return &L->data[idx];
+}
+
+/* stops 复制进内存池；owned 为 1 时调用方的 stops 由 malloc 分配、成功后由这里释放 */
+static int train_add_internal(TrainList *L, Train *t, int owned) {
+    if (t->stop_count > MAX_STOPS) return -1;
+    sync_rwlock_wrlock(train_lock);
     if (L->size >= L->capacity) trainlist_expand(L);
+    Stop *caller_stops = t->stops;
+    t->stops = stops_copy_internal(caller_stops, t->stop_count);
+    if (owned) free(caller_stops);
     t->seatmaps = NULL;
     t->seatmap_count = 0;
-    t->seatmap_capacity = 0;
-    L->data[L->size++] = *t;
-    rebuild_index(L);
+    t->seatmap_capacity = SEATMAP_WINDOW_DAYS;
+    L->data[L->size] = *t;
+    ht_insert(train_ht, t->train_id, L->size);
+    station_index_add_internal(L, L->size);
+    L->size++;
+    sync_fetch_add64(&train_version_seq, 1);
+    sync_rwlock_wrunlock(train_lock);
     return 0;
 }
 
+int train_add(TrainList *L, Train *t) {
+    return train_add_internal(L, t, 1);
+}
+
 int train_delete(TrainList *L, const char *train_id) {
-    int idx = train_find_index(L, train_id);
-    if (idx == -1) return -1;
-    free(L->data[idx].stops);
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)L->data[idx].seatmaps;
-    if (sm) {
-        for (int i = 0; i < L->data[idx].seatmap_count; ++i) {
-            for (int c = 0; c < 4; ++c) if (sm[i].class_seat_seg[c]) free(sm[i].class_seat_seg[c]);
-            free(sm[i].class_seat_seg);
-        }
-        free(sm);
-    }
-    for (int i = idx; i < L->size - 1; ++i) L->data[i] = L->data[i+1];
+    sync_rwlock_wrlock(train_lock);
+    int idx = train_find_index_internal(L, train_id);
+    if (idx == -1) { sync_rwlock_wrunlock(train_lock); return -1; }
+    char id[ID_LEN];
+    memcpy(id, L->data[idx].train_id, ID_LEN);
+    station_index_remove_internal(idx, 1);
+    stops_release_internal(&L->data[idx]);
+    train_free_seatmaps_internal(&L->data[idx]);
+    memmove(&L->data[idx], &L->data[idx + 1], sizeof(Train) * (L->size - idx - 1));
     L->size--;
-    rebuild_index(L);
+    index_erase_shift_internal(L, id, idx);
+    sync_fetch_add64(&train_version_seq, 1);
+    sync_rwlock_wrunlock(train_lock);
     return 0;
 }
 
 int train_update(TrainList *L, const char *train_id, Train *newt) {
-    int idx = train_find_index(L, train_id);
-    if (idx == -1) return -1;
-    free(L->data[idx].stops);
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)L->data[idx].seatmaps;
-    if (sm) {
-        for (int i = 0; i < L->data[idx].seatmap_count; ++i) {
-            for (int c = 0; c < 4; ++c) if (sm[i].class_seat_seg[c]) free(sm[i].class_seat_seg[c]);
-            free(sm[i].class_seat_seg);
-        }
-        free(sm);
+    if (newt->stop_count > MAX_STOPS) return -1;
+    sync_rwlock_wrlock(train_lock);
+    int idx = train_find_index_internal(L, train_id);
+    if (idx == -1) { sync_rwlock_wrunlock(train_lock); return -1; }
+    station_index_remove_internal(idx, 0);
+    /* 调用方常以 train_get 得到的副本修改，stops 可能就是原数组 */
+    if (L->data[idx].stops != newt->stops) {
+        Stop *caller_stops = newt->stops;
+        stops_release_internal(&L->data[idx]);
+        newt->stops = stops_copy_internal(caller_stops, newt->stop_count);
+        free(caller_stops);
     }
+    train_free_seatmaps_internal(&L->data[idx]);
     newt->seatmaps = NULL;
     newt->seatmap_count = 0;
-    newt->seatmap_capacity = 0;
-    L->data[idx] = *newt;
-    rebuild_index(L);
+    newt->seatmap_capacity = SEATMAP_WINDOW_DAYS;
+    if (strcmp(L->data[idx].train_id, newt->train_id) != 0) {
+        char id[ID_LEN];
+        memcpy(id, L->data[idx].train_id, ID_LEN);
+        L->data[idx] = *newt;
+        index_drop_internal(L, id, idx);
+        ht_insert(train_ht, newt->train_id, idx);
+    } else {
+        L->data[idx] = *newt;
+    }
+    station_index_add_internal(L, idx);
+    sync_fetch_add64(&train_version_seq, 1);
+    sync_rwlock_wrunlock(train_lock);
     return 0;
 }
 
 int train_find_index(TrainList *L, const char *train_id) {
-    if (train_ht) {
-        int idx = ht_find(train_ht, train_id);
-        if (idx != -1) return idx;
-    }
-    for (int i = 0; i < L->size; ++i) if (strcmp(L->data[i].train_id, train_id) == 0) return i;
-    return -1;
+    sync_rwlock_rdlock(train_lock);
+    int idx = train_find_index_internal(L, train_id);
+    sync_rwlock_rdunlock(train_lock);
+    return idx;
+}
+
+int train_fare_info(TrainList *L, const char *train_id, int seat_class,
+                    char *depart_time, size_t depart_len, double *price) {
+    if (seat_class < 0 || seat_class >= 4) return -1;
+    Train *t = train_rdlock_find_internal(L, train_id);
+    if (!t) return -1;
+    if (depart_time && depart_len) snprintf(depart_time, depart_len, "%s", t->depart_time);
+    if (price) *price = t->base_price * t->seat_price_coef[seat_class];
+    sync_rwlock_rdunlock(train_lock);
+    return 0;
 }
 
 Train *train_get(TrainList *L, int idx) {
@@ -190,6 +856,7 @@ Train *train_get(TrainList *L, int idx) {
 
 void train_list_all(TrainList *L) {
     if (!L || L->size == 0) { printf("无车次信息\n"); return; }
+    sync_rwlock_rdlock(train_lock);
     for (int i = 0; i < L->size; ++i) {
         Train *t = &L->data[i];
         printf("---- [%d] ----\n", i+1);
@@ -198,6 +865,7 @@ void train_list_all(TrainList *L) {
         printf(" 停靠站(%d)  座位(B/1/2/S): %d/%d/%d/%d\n", t->stop_count, t->seat_count[0], t->seat_count[1], t->seat_count[2], t->seat_count[3]);
         printf(" 已注册日期 seatmaps: %d\n", t->seatmap_count);
     }
+    sync_rwlock_rdunlock(train_lock);
 }
 
 int train_find_stop_idx(Train *t, const char *station) {
@@ -205,52 +873,331 @@ int train_find_stop_idx(Train *t, const char *station) {
     return -1;
 }
 
+/*
+ * 座位操作的公共前置：读锁下定位车次与区间，再锁住该日期所在的日历槽，op->sm 为该日期的 seatmap
+ * （create 为 0 且尚未建立时为 NULL）。lockfree 为 1 且策略为 ALLOC_LOCK_FREE 时不取槽位锁，
+ * 只增加槽位的 active 计数；seatmap 尚未建立时临时加锁建立。成功返回 0，由 seat_op_end 释放。
+ */
+typedef struct {
+    Train *t;
+    TrainDateSeatMap *slot, *sm;
+    int day, fidx, tidx;
+    int locked, pinned;
+} SeatOp;
+
+static int seat_op_attach_internal(SeatOp *op, int create, int lockfree);
+
+static int seat_op_begin(SeatOp *op, TrainList *TL, const char *train_id, const char *date,
+                         const char *from, const char *to, int create, int lockfree) {
+    op->day = train_date_to_day(date);
+    if (op->day < 0 || op->day < sync_load(&evict_floor)) return -1;
+    op->t = train_rdlock_find_internal(TL, train_id);
+    if (!op->t) return -1;
+    op->fidx = op->tidx = -1;
+    if (from && to) {
+        op->fidx = train_find_stop_idx(op->t, from);
+        op->tidx = train_find_stop_idx(op->t, to);
+        if (op->fidx == -1 || op->tidx == -1 || !(op->fidx < op->tidx)) {
+            sync_rwlock_rdunlock(train_lock);
+            return -1;
+        }
+    }
+    return seat_op_attach_internal(op, create, lockfree);
+}
+
+/* 已持有车次表读锁、op->t 与 op->day 已定时，取得该日期的槽位（加锁或计数） */
+static int seat_op_attach_internal(SeatOp *op, int create, int lockfree) {
+    op->slot = train_slot_internal(op->t, op->day, create);
+    op->sm = NULL;
+    op->locked = op->pinned = 0;
+    if (!op->slot) return 0;
+    if (lockfree && alloc_policy == ALLOC_LOCK_FREE) {
+        for (;;) {
+            sync_fetch_add(&op->slot->active, 1);
+            sync_fence();
+            if (sync_load(&op->slot->day) == op->day) { op->sm = op->slot; op->pinned = 1; return 0; }
+            sync_fetch_add(&op->slot->active, -1);
+            if (!create) return 0;
+            sync_spin_lock(&op->slot->lock);
+            TrainDateSeatMap *sm = train_create_seatmap_if_missing_internal(op->t, op->slot, op->day);
+            sync_spin_unlock(&op->slot->lock);
+            if (!sm) return 0;
+        }
+    }
+    sync_spin_lock(&op->slot->lock);
+    op->locked = 1;
+    op->sm = create ? train_create_seatmap_if_missing_internal(op->t, op->slot, op->day)
+                    : train_find_seatmap_internal(op->slot, op->day);
+    return 0;
+}
+
+/* 未取得 seatmap 时：槽位空闲或只留着已过期的更早日期，说明该日尚未售票；槽位属于另一个未过期日期说明该日不在窗口内 */
+static int seat_op_unsold_internal(const SeatOp *op) {
+    if (!op->slot) return 1;
+    int slot_day = sync_load(&op->slot->day);
+    return slot_day == -1 || seatmap_slot_stale_internal(slot_day, op->day);
+}
+
+static void seat_op_detach_internal(SeatOp *op) {
+    if (op->pinned) sync_fetch_add(&op->slot->active, -1);
+    if (op->locked) sync_spin_unlock(&op->slot->lock);
+}
+
+static void seat_op_end(SeatOp *op) {
+    seat_op_detach_internal(op);
+    sync_rwlock_rdunlock(train_lock);
+}
+
 int train_allocate_seat(TrainList *TL, const char *train_id, const char *date,
                         const char *from, const char *to, int seat_class,
                         int *out_seat_index, int *out_from_idx, int *out_to_idx) {
-    int tidx = train_find_index(TL, train_id);
-    if (tidx == -1) return -1;
-    Train *t = &TL->data[tidx];
-    int fidx = train_find_stop_idx(t, from);
-    int tidx_stop = train_find_stop_idx(t, to);
-    if (fidx == -1 || tidx_stop == -1) return -1;
-    if (!(fidx < tidx_stop)) return -1;
-    int sm_idx = train_create_seatmap_if_missing_internal(t, date);
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps + sm_idx;
-    int seat_idx = seatmap_allocate_internal(sm, t, seat_class, fidx, tidx_stop);
+    SeatOp op;
+    if (seat_op_begin(&op, TL, train_id, date, from, to, 1, 1) != 0) return -1;
+    TrainDateSeatMap *sm = op.sm;
+    int seat_idx = sm ? seatmap_allocate_internal(seatmap_class_internal(sm, op.t, seat_class, 1), op.fidx, op.tidx) : -1;
+    seat_op_end(&op);
     if (seat_idx == -1) return -1;
     if (out_seat_index) *out_seat_index = seat_idx;
-    if (out_from_idx) *out_from_idx = fidx;
-    if (out_to_idx) *out_to_idx = tidx_stop;
+    if (out_from_idx) *out_from_idx = op.fidx;
+    if (out_to_idx) *out_to_idx = op.tidx;
+    return 0;
+}
+
+int train_allocate_seats(TrainList *TL, const char *train_id, const char *date,
+                         const char *from, const char *to, int seat_class, int n,
+                         int *out_seat_indexes, int *out_from_idx, int *out_to_idx) {
+    if (!out_seat_indexes) return -1;
+    SeatOp op;
+    if (seat_op_begin(&op, TL, train_id, date, from, to, 1, 0) != 0) return -1;
+    TrainDateSeatMap *sm = op.sm;
+    int r = sm ? seatmap_allocate_group_internal(seatmap_class_internal(sm, op.t, seat_class, 1),
+                                                 op.fidx, op.tidx, n, out_seat_indexes) : -1;
+    seat_op_end(&op);
+    if (r != 0) return -1;
+    if (out_from_idx) *out_from_idx = op.fidx;
+    if (out_to_idx) *out_to_idx = op.tidx;
     return 0;
 }
 
 int train_release_seat(TrainList *TL, const char *train_id, const char *date,
                        int seat_class, int seat_index, int from_idx, int to_idx) {
-    int tidx = train_find_index(TL, train_id);
-    if (tidx == -1) return -1;
-    Train *t = &TL->data[tidx];
-    int sm_idx = train_find_seatmap_idx_internal(t, date);
-    if (sm_idx == -1) return -1;
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps + sm_idx;
-    seatmap_release_internal(sm, t, seat_class, seat_index, from_idx, to_idx);
-    return 0;
+    SeatOp op;
+    if (seat_op_begin(&op, TL, train_id, date, NULL, NULL, 0, 1) != 0) return -1;
+    TrainDateSeatMap *sm = op.sm;
+    if (sm) seatmap_release_internal(seatmap_class_internal(sm, op.t, seat_class, 0), seat_index, from_idx, to_idx);
+    seat_op_end(&op);
+    return sm ? 0 : -1;
 }
 
 int train_mark_seat(TrainList *TL, const char *train_id, const char *date,
                     int seat_class, int seat_index, int from_idx, int to_idx) {
-    int tidx = train_find_index(TL, train_id);
-    if (tidx == -1) return -1;
-    Train *t = &TL->data[tidx];
-    int sm_idx = train_create_seatmap_if_missing_internal(t, date);
-    TrainDateSeatMap *sm = (TrainDateSeatMap*)t->seatmaps + sm_idx;
-    return seatmap_mark_index_internal(sm, t, seat_class, seat_index, from_idx, to_idx);
+    SeatOp op;
+    int day = train_date_to_day(date);
+    if (day >= 0 && day < sync_load(&evict_floor)) return -2;
+    if (seat_op_begin(&op, TL, train_id, date, NULL, NULL, 1, 1) != 0) return -1;
+    TrainDateSeatMap *sm = op.sm;
+    /* 取不到 seatmap 而日期已过：槽位已让给之后的日期，该日已归档 */
+    int r = sm ? seatmap_mark_index_internal(seatmap_class_internal(sm, op.t, seat_class, 1), seat_index, from_idx, to_idx)
+               : op.day < train_today() ? -2 : -1;
+    seat_op_end(&op);
+    return r;
+}
+
+
+int train_remaining_seats(TrainList *TL, const char *train_id, const char *date,
+                          const char *from, const char *to, int seat_class) {
+    if (seat_class < 0 || seat_class >= 4) return -1;
+    SeatOp op;
+    if (seat_op_begin(&op, TL, train_id, date, from, to, 0, 1) != 0) return -1;
+    SeatClassMap *cm = op.sm ? seatmap_class_internal(op.sm, op.t, seat_class, 0) : NULL;
+    int r = cm ? seatmap_run_query_internal(cm, op.fidx, op.tidx)
+               : (op.sm || seat_op_unsold_internal(&op)) ? op.t->seat_count[seat_class] : -1;
+    seat_op_end(&op);
+    return r;
+}
+
+int train_find_between(TrainList *TL, const char *from, const char *to, const char *date,
+                       TrainMatch *out, int max) {
+    int day = -1;
+    if (date && (day = train_date_to_day(date)) < 0) return -1;
+    sync_rwlock_rdlock(train_lock);
+    int la = station_ht ? ht_find(station_ht, from) : -1;
+    int lb = station_ht ? ht_find(station_ht, to) : -1;
+    if (la == -1 || lb == -1) { sync_rwlock_rdunlock(train_lock); return 0; }
+    StationStops *a = &station_lists[la], *b = &station_lists[lb];
+    int i = 0, j = 0, n = 0;
+    while (i < a->size && j < b->size) {
+        int ta = a->items[i].train, tb = b->items[j].train;
+        if (ta < tb) { i++; continue; }
+        if (tb < ta) { j++; continue; }
+        /* 同一车次可能多次经停同一站：取最早的上车站，再取其后的第一个下车站 */
+        int f = a->items[i].stop, e = -1;
+        while (i < a->size && a->items[i].train == ta) i++;
+        for (; j < b->size && b->items[j].train == ta; ++j) if (e == -1 && b->items[j].stop > f) e = b->items[j].stop;
+        if (e == -1) continue;
+        if (n < max) {
+            Train *t = &TL->data[ta];
+            TrainMatch *m = &out[n];
+            memcpy(m->train_id, t->train_id, ID_LEN);
+            m->from_idx = f;
+            m->to_idx = e;
+            memcpy(m->depart, t->stops[f].depart, TIME_LEN);
+            memcpy(m->arrive, t->stops[e].arrive, TIME_LEN);
+            m->running = t->running;
+            for (int c = 0; c < 4; ++c) m->remaining[c] = -1;
+            if (date && day >= sync_load(&evict_floor)) {
+                SeatOp op;
+                op.t = t;
+                op.day = day;
+                op.fidx = f;
+                op.tidx = e;
+                seat_op_attach_internal(&op, 0, 1);
+                int unsold = !op.sm && seat_op_unsold_internal(&op);
+                for (int c = 0; c < 4 && (op.sm || unsold); ++c) {
+                    SeatClassMap *cm = op.sm ? seatmap_class_internal(op.sm, t, c, 0) : NULL;
+                    m->remaining[c] = cm ? seatmap_run_query_internal(cm, f, e) : t->seat_count[c];
+                }
+                seat_op_detach_internal(&op);
+            }
+        }
+        n++;
+    }
+    sync_rwlock_rdunlock(train_lock);
+    return n;
+}
+
+/* 由空闲区间计数一次扫描得出整张矩阵：out[i][j] = sum(cnt[a][b], a<=i, b>=j) */
+static void seatmap_od_matrix_internal(SeatClassMap *cm, int *out) {
+    int n = cm->segment_count + 1;
+    int *cnt = cm->run_cnt;
+    for (int i = 0; i < n; ++i)
+        for (int j = n - 1; j >= 0; --j) {
+            int v = sync_load(&cnt[i * n + j]);
+            if (i > 0) v += out[(i - 1) * n + j];
+            if (j < n - 1) v += out[i * n + j + 1];
+            if (i > 0 && j < n - 1) v -= out[(i - 1) * n + j + 1];
+            out[i * n + j] = v;
+        }
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j <= i; ++j) out[i * n + j] = 0;
+}
+
+static int train_availability_matrix_internal(TrainList *TL, const char *train_id, const char *date,
+                                              int seat_class, int *out, int use_cache) {
+    if (!out || seat_class < 0 || seat_class >= 4) return -1;
+    SeatOp op;
+    if (seat_op_begin(&op, TL, train_id, date, NULL, NULL, 0, 0) != 0) return -1;
+    Train *t = op.t;
+    int n = t->stop_count;
+    SeatClassMap *cm = op.sm ? seatmap_class_internal(op.sm, t, seat_class, 0) : NULL;
+    if (!op.sm && !seat_op_unsold_internal(&op)) {
+        seat_op_end(&op);
+        return -1;
+    }
+    if (!cm) {
+        int v = t->seat_count[seat_class];
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j) out[i * n + j] = (i < j) ? v : 0;
+    } else if (!use_cache) {
+        seatmap_od_matrix_internal(cm, out);
+    } else {
+        if (!cm->od_cache) {
+            cm->od_cache = seat_alloc(sizeof(int) * n * n);
+            sync_fetch_add64(&seatmap_mem.bytes, (int64_t)(sizeof(int) * n * n));
+        }
+        /* 计算前先记下版本号；计算期间若有无锁修改，版本号已前进，下次查询会重算 */
+        int ver = sync_load(&cm->version);
+        if (cm->od_version != ver) {
+            seatmap_od_matrix_internal(cm, cm->od_cache);
+            cm->od_version = ver;
+        }
+        memcpy(out, cm->od_cache, sizeof(int) * n * n);
+    }
+    seat_op_end(&op);
+    return 0;
+}
+
+int train_availability_matrix(TrainList *TL, const char *train_id, const char *date,
+                              int seat_class, int *out) {
+    return train_availability_matrix_internal(TL, train_id, date, seat_class, out, 0);
+}
+
+int train_availability_matrix_cached(TrainList *TL, const char *train_id, const char *date,
+                                     int seat_class, int *out) {
+    return train_availability_matrix_internal(TL, train_id, date, seat_class, out, 1);
+}
+
+static int train_evict_before_day_internal(TrainList *TL, int day) {
+    int evicted = 0;
+    sync_rwlock_rdlock(train_lock);
+    if (day > sync_load(&evict_floor)) sync_store(&evict_floor, day);
+    for (int i = 0; i < TL->size; ++i) {
+        Train *t = &TL->data[i];
+        TrainDateSeatMap *sm = sync_load_ptr(&t->seatmaps);
+        if (!sm) continue;
+        for (int j = 0; j < SEATMAP_WINDOW_DAYS; ++j) {
+            sync_spin_lock(&sm[j].lock);
+            if (sm[j].day != -1 && sm[j].day < day) {
+                seatmap_free_internal(&sm[j]);
+                sync_fetch_add(&t->seatmap_count, -1);
+                sync_fetch_add(&seatmap_mem.dates, -1);
+                evicted++;
+            }
+            sync_spin_unlock(&sm[j].lock);
+        }
+    }
+    sync_rwlock_rdunlock(train_lock);
+    return evicted;
+}
+
+int train_evict_before(TrainList *TL, const char *date) {
+    int day = train_date_to_day(date);
+    if (day < 0) return -1;
+    return train_evict_before_day_internal(TL, day);
+}
+
+int train_evict_past(TrainList *TL) {
+    return train_evict_before_day_internal(TL, train_today());
+}
+
+
+void train_seatmap_mem_stats(SeatmapMemStats *out) {
+    if (!out) return;
+    out->bytes = (long long)sync_fetch_add64(&seatmap_mem.bytes, 0);
+    out->dates = sync_load(&seatmap_mem.dates);
+    out->classes = sync_load(&seatmap_mem.classes);
+    out->chunks = sync_load(&seatmap_mem.chunks);
+}
+
+static void arena_stats_add(ArenaStats *out, const ArenaStats *st) {
+    out->allocs += st->allocs;
+    out->frees += st->frees;
+    out->sys_allocs += st->sys_allocs;
+    out->chunks += st->chunks;
+    out->reserved += st->reserved;
+    out->live += st->live;
+}
+
+void train_alloc_stats(ArenaStats *out) {
+    ArenaStats st;
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    sync_rwlock_rdlock(train_lock);
+    arena_stats(train_arena, &st);
+    arena_stats_add(out, &st);
+    sync_spin_lock(&seat_arena_lock);
+    arena_stats(seat_arena, &st);
+    sync_spin_unlock(&seat_arena_lock);
+    arena_stats_add(out, &st);
+    sync_rwlock_rdunlock(train_lock);
 }
 
 
 int save_trains(const char *filename, TrainList *L) {
-    FILE *f = fopen(filename, "w");
+    char tmp[FILENAME_MAX + 8];
+    FILE *f = file_replace_begin(filename, tmp, sizeof(tmp));
     if (!f) return 0;
+    sync_rwlock_rdlock(train_lock);
     fprintf(f, "%d\n", L->size);
     for (int i = 0; i < L->size; ++i) {
         Train *t = &L->data[i];
@@ -264,58 +1211,170 @@ int save_trains(const char *filename, TrainList *L) {
             fprintf(f, "%s|%s|%s|%d\n", s->name, s->arrive, s->depart, s->distance);
         }
     }
-    fclose(f);
-    return 1;
+    sync_rwlock_rdunlock(train_lock);
+    return file_replace_commit(f, tmp, filename, !ferror(f));
 }
 
+/* 逐行扫描映射的文件；格式错误或停靠站超过 MAX_STOPS 时在 stderr 打印行列并返回 0，已读入的车次保留 */
 int load_trains(const char *filename, TrainList *L) {
-    FILE *f = fopen(filename, "r");
-    if (!f) return 0;
-    int count = 0;
-    if (fscanf(f, "%d\n", &count) != 1) { fclose(f); return 0; }
-    char line[1024];
+    MappedFile m;
+    if (map_file(filename, &m) != 0) return 0;
+    Scanner sc;
+    scan_init(&sc, m.p, m.len, 1);
+    int count = 0, ok = 0;
+    if (!scan_line(&sc) || scan_int(&sc, &count) != 0 || count < 0) { scan_fail(&sc, sc.line, "记录数无效"); goto out; }
+    Stop stops[MAX_STOPS];
     for (int i = 0; i < count; ++i) {
-        if (!fgets(line, sizeof(line), f)) { fclose(f); return 0; }
-        size_t ln = strlen(line); if (ln && line[ln-1]=='\n') line[ln-1]=0;
-        char *parts[20]; int p = 0;
-        char *tok = strtok(line, "|");
-        while (tok && p < 20) { parts[p++] = tok; tok = strtok(NULL, "|"); }
-        if (p < 16) { fclose(f); return 0; }
         Train t;
         memset(&t, 0, sizeof(t));
-        strncpy(t.train_id, parts[0], ID_LEN-1);
-        strncpy(t.from, parts[1], STATION_LEN-1);
-        strncpy(t.to, parts[2], STATION_LEN-1);
-        strncpy(t.depart_time, parts[3], TIME_LEN-1);
-        t.base_price = atof(parts[4]);
-        t.running = atoi(parts[5]);
-        t.duration_minutes = atoi(parts[6]);
-        t.stop_count = atoi(parts[7]);
-        t.seat_count[0] = atoi(parts[8]); t.seat_count[1] = atoi(parts[9]);
-        t.seat_count[2] = atoi(parts[10]); t.seat_count[3] = atoi(parts[11]);
-        t.seat_price_coef[0] = atof(parts[12]); t.seat_price_coef[1] = atof(parts[13]);
-        t.seat_price_coef[2] = atof(parts[14]); t.seat_price_coef[3] = atof(parts[15]);
-        if (t.stop_count > 0) {
-            t.stops = xmalloc(sizeof(Stop) * t.stop_count);
-            for (int j = 0; j < t.stop_count; ++j) {
-                if (!fgets(line, sizeof(line), f)) { fclose(f); return 0; }
-                size_t ln2 = strlen(line); if (ln2 && line[ln2-1]=='\n') line[ln2-1]=0;
-                char *sp[4]; int q = 0;
-                char *tok2 = strtok(line, "|");
-                while (tok2 && q < 4) { sp[q++] = tok2; tok2 = strtok(NULL, "|"); }
-                if (q < 4) { fclose(f); return 0; }
-                strncpy(t.stops[j].name, sp[0], STATION_LEN-1);
-                strncpy(t.stops[j].arrive, sp[1], TIME_LEN-1);
-                strncpy(t.stops[j].depart, sp[2], TIME_LEN-1);
-                t.stops[j].distance = atoi(sp[3]);
-            }
-        } else {
-            t.stops = NULL;
+        if (!scan_line(&sc)) goto out;
+        scan_str(&sc, t.train_id, ID_LEN);
+        scan_str(&sc, t.from, STATION_LEN);
+        scan_str(&sc, t.to, STATION_LEN);
+        scan_str(&sc, t.depart_time, TIME_LEN);
+        scan_double(&sc, &t.base_price);
+        scan_int(&sc, &t.running);
+        scan_int(&sc, &t.duration_minutes);
+        const char *at = sc.fp;
+        if (scan_int(&sc, &t.stop_count) == 0 && t.stop_count > MAX_STOPS) {
+            fprintf(stderr, "%s: 车次 %s 有 %d 个停靠站，超过上限 %d\n", filename, t.train_id, t.stop_count, MAX_STOPS);
+            scan_fail(&sc, at, "停靠站数超过上限");
+            goto out;
+        }
+        for (int c = 0; c < 4; ++c) scan_int(&sc, &t.seat_count[c]);
+        for (int c = 0; c < 4; ++c) scan_double(&sc, &t.seat_price_coef[c]);
+        if (sc.err) goto out;
+        /* 站点先读进栈上数组，train_add_internal 再一次复制进内存池 */
+        t.stops = t.stop_count > 0 ? stops : NULL;
+        for (int j = 0; j < t.stop_count; ++j) {
+            Stop *st = &stops[j];
+            memset(st, 0, sizeof(*st));
+            if (!scan_line(&sc)) goto out;
+            scan_str(&sc, st->name, STATION_LEN);
+            scan_str(&sc, st->arrive, TIME_LEN);
+            scan_str(&sc, st->depart, TIME_LEN);
+            scan_int(&sc, &st->distance);
+            if (sc.err) goto out;
         }
         /* seatmaps 初始化留空（通过 bookings 恢复） */
         t.seatmaps = NULL; t.seatmap_capacity = 0; t.seatmap_count = 0;
-        train_add(L, &t);
+        train_add_internal(L, &t, 0);
+    }
+    ok = 1;
+out:
+    if (!ok) scan_report(&sc, filename);
+    unmap_file(&m);
+    return ok;
+}
+/*
+ * 快照：每趟车写出 Train 本身（指针字段载入时重设）与 stops，随后是日历环的各个槽位：
+ * 日序号（空槽为 -1）、已分配存储的等级位图，每个等级写出 seg_occ + run_cnt + run_bit 这一整段、
+ * 各座位块是否已分配（每 64 块一个位图字），以及已分配块的占用字。最佳适配索引与 OD 缓存不写出，载入后按需重建。
+ */
+static size_t seat_class_body_bytes_internal(const SeatClassMap *cm) {
+    return seat_class_bytes_internal(cm->segment_count, cm->seat_count) - sizeof(SeatClassMap) - sizeof(uint64_t*) * cm->nchunks;
+}
+
+static void train_seatmaps_save_internal(Train *t, SnapWriter *w) {
+    TrainDateSeatMap *ring = sync_load_ptr(&t->seatmaps);
+    snap_put_u64(w, ring ? SEATMAP_WINDOW_DAYS : 0);
+    for (int j = 0; ring && j < SEATMAP_WINDOW_DAYS; ++j) {
+        TrainDateSeatMap *sm = &ring[j];
+        sync_spin_lock(&sm->lock);
+        snap_put_u64(w, (uint64_t)(int64_t)sm->day);
+        if (sm->day != -1) {
+            uint64_t mask = 0;
+            for (int c = 0; c < 4; ++c) if (sm->cls[c]) mask |= (uint64_t)1 << c;
+            snap_put_u64(w, mask);
+            for (int c = 0; c < 4; ++c) {
+                SeatClassMap *cm = sm->cls[c];
+                if (!cm) continue;
+                snap_write(w, cm->seg_occ, seat_class_body_bytes_internal(cm));
+                for (int k0 = 0; k0 < cm->nchunks; k0 += 64) {
+                    uint64_t present = 0;
+                    for (int k = k0; k < cm->nchunks && k < k0 + 64; ++k) if (cm->rows[k]) present |= (uint64_t)1 << (k - k0);
+                    snap_put_u64(w, present);
+                }
+                for (int k = 0; k < cm->nchunks; ++k)
+                    if (cm->rows[k]) snap_write(w, cm->rows[k], SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+            }
+        }
+        sync_spin_unlock(&sm->lock);
     }
-    fclose(f);
-    return 1;
-}
\ No newline at end of file
+}
+
+void train_snapshot_save(TrainList *L, SnapWriter *w) {
+    sync_rwlock_rdlock(train_lock);
+    snap_put_u64(w, (uint64_t)(int64_t)sync_load(&evict_floor));
+    snap_put_u64(w, (uint64_t)L->size);
+    for (int i = 0; i < L->size; ++i) {
+        Train *t = &L->data[i];
+        snap_write(w, t, sizeof(Train));
+        snap_write(w, t->stops, sizeof(Stop) * t->stop_count);
+        train_seatmaps_save_internal(t, w);
+    }
+    sync_rwlock_rdunlock(train_lock);
+}
+
+/* 写锁下恢复一趟车的日历环；座位存储按原大小分配后整段复制，不逐座重放 */
+static int train_seatmaps_load_internal(Train *t, SnapReader *r) {
+    size_t slots = snap_get_count(r, SEATMAP_WINDOW_DAYS);
+    for (size_t j = 0; j < slots; ++j) {
+        int64_t day = (int64_t)snap_get_u64(r);
+        if (r->err || day < -1 || day > INT32_MAX) return -1;
+        if (day == -1) continue;
+        TrainDateSeatMap *sm = train_create_seatmap_if_missing_internal(t, train_slot_internal(t, (int)day, 1), (int)day);
+        uint64_t mask = snap_get_u64(r);
+        if (!sm || r->err || mask > 15) return -1;
+        for (int c = 0; c < 4; ++c) {
+            if (!(mask >> c & 1)) continue;
+            /* 先按车次参数核对剩余长度，损坏的座位数不会导致巨量分配 */
+            if (t->seat_count[c] <= 0 || sm->segment_count <= 0 ||
+                seat_class_bytes_internal(sm->segment_count, t->seat_count[c]) > r->len - r->off) return -1;
+            SeatClassMap *cm = seatmap_class_internal(sm, t, c, 1);
+            size_t body = seat_class_body_bytes_internal(cm);
+            const void *p = snap_read(r, body);
+            const uint64_t *present = snap_read(r, sizeof(uint64_t) * ((cm->nchunks + 63) / 64));
+            if (!p || !present) return -1;
+            memcpy(cm->seg_occ, p, body);
+            for (int k = 0; k < cm->nchunks; ++k) {
+                if (!(present[k / 64] >> (k % 64) & 1)) continue;
+                const void *rows = snap_read(r, SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+                if (!rows) return -1;
+                memcpy(seat_row_ptr_internal(cm, k * SEATMAP_CHUNK_SEATS), rows, SEATMAP_CHUNK_SEATS * sizeof(uint64_t));
+            }
+        }
+    }
+    return 0;
+}
+
+int train_snapshot_load(TrainList *L, SnapReader *r) {
+    int64_t floor = (int64_t)snap_get_u64(r);
+    if (r->err || floor < -1 || floor > INT32_MAX) return -1;
+    sync_store(&evict_floor, (int)floor);
+    size_t n = snap_get_count(r, INT32_MAX);
+    for (size_t i = 0; i < n; ++i) {
+        const Train *img = snap_read(r, sizeof(Train));
+        if (!img) return -1;
+        Train t;
+        memcpy(&t, img, sizeof(t));
+        if (t.stop_count < 0 || t.stop_count > MAX_STOPS) return -1;
+        for (int c = 0; c < 4; ++c) if (t.seat_count[c] < 0) return -1;
+        const Stop *stops = snap_read(r, sizeof(Stop) * t.stop_count);
+        if (r->err) return -1;
+        t.train_id[ID_LEN-1] = 0; t.from[STATION_LEN-1] = 0; t.to[STATION_LEN-1] = 0; t.depart_time[TIME_LEN-1] = 0;
+        t.stops = (Stop*)stops;
+        train_add_internal(L, &t, 0);
+        sync_rwlock_wrlock(train_lock);
+        Train *tt = &L->data[L->size - 1];
+        for (int k = 0; k < tt->stop_count; ++k) {
+            tt->stops[k].name[STATION_LEN-1] = 0;
+            tt->stops[k].arrive[TIME_LEN-1] = 0;
+            tt->stops[k].depart[TIME_LEN-1] = 0;
+        }
+        int res = train_seatmaps_load_internal(tt, r);
+        sync_rwlock_wrunlock(train_lock);
+        if (res != 0) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,481 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "wal.h"
+#include "sync.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define wal_fsync(fd) _commit(fd)
+#define wal_fileno(f) _fileno(f)
+#else
+#include <unistd.h>
+#define wal_fsync(fd) fsync(fd)
+#define wal_fileno(f) fileno(f)
+#endif
+
+#define WAL_LINE_MAX 2048
+#define WAL_PATH_LEN 512
+
+typedef struct {
+	char *p;
+	size_t len;
+	size_t cap;
+} WalBuf;
+
+/*
+ * mu 保护以下全部字段。buf 收集尚未写出的记录；写盘线程（flushing 为 1）把 buf 与 spare 对调后
+ * 释放 mu 去写文件，其间新记录继续追加到新的 buf。durable_lsn 之前的记录已经处理完毕。
+ *
+ * 写盘失败后文件尾可能留下半行，之后追加的记录重放时会被它挡住，所以一旦失败即置 broken：
+ * broken_lsn 之后的记录不再写出、提交都返回 -1，直到一次在失败之后开始的检查点成功（坏日志随 .old 删除）。
+ * 该检查点开始（ckpt_lsn）之后被丢弃的记录既不在快照里也不在日志里，记为 (lost_from, lost_to]，
+ * 并保持 incomplete，下次保存必须重写快照。
+ */
+static struct {
+	FILE *f;
+	char path[WAL_PATH_LEN];
+	SyncMutex *mu;
+	SyncCond *cv;
+	WalBuf buf;
+	WalBuf spare;
+	long long next_lsn;
+	long long durable_lsn;
+	int broken;
+	long long broken_lsn;
+	long long ckpt_lsn;
+	long long lost_from;
+	long long lost_to;
+	int incomplete;
+	int flushing;
+	long long file_bytes;	/* 当前日志文件的长度 */
+	long long old_bytes;	/* <path>.old 的长度 */
+	WalStats st;
+} wal;
+
+/* CRC-32（IEEE，反射多项式 0xEDB88320），每次查 4 位 */
+static uint32_t crc32_str(const char *s, size_t n)
+{
+	static const uint32_t t[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+	uint32_t c = 0xFFFFFFFFu;
+
+	for (size_t i = 0; i < n; ++i) {
+		c ^= (unsigned char)s[i];
+		c = (c >> 4) ^ t[c & 15];
+		c = (c >> 4) ^ t[c & 15];
+	}
+	return ~c;
+}
+
+static void buf_reserve(WalBuf *b, size_t extra)
+{
+	if (b->len + extra <= b->cap)
+		return;
+
+	size_t cap = b->cap ? b->cap : 4096;
+	while (cap < b->len + extra)
+		cap *= 2;
+	b->p = realloc(b->p, cap);
+	if (!b->p) {
+		perror("realloc");
+		exit(1);
+	}
+	b->cap = cap;
+}
+
+/* 持有 mu 且没有其它写盘线程时调用：写出当前 buf 并 fsync，返回时仍持有 mu */
+static int flush_locked(void)
+{
+	WalBuf out = wal.buf;
+	long long upto = wal.next_lsn;
+	int ok = 0;
+
+	wal.buf = wal.spare;
+	wal.buf.len = 0;
+	if (!wal.broken) {
+		wal.flushing = 1;
+		sync_mutex_unlock(wal.mu);
+		ok = fwrite(out.p, 1, out.len, wal.f) == out.len && fflush(wal.f) == 0 &&
+		     wal_fsync(wal_fileno(wal.f)) == 0;
+		sync_mutex_lock(wal.mu);
+		wal.flushing = 0;
+	}
+	wal.spare = out;
+	if (ok) {
+		wal.st.syncs++;
+		wal.st.bytes += (long long)out.len;
+		wal.file_bytes += (long long)out.len;
+	} else if (!wal.broken) {
+		perror("wal write");
+		fprintf(stderr, "wal: %s 写盘失败，停止追加日志，下次保存将重写快照\n", wal.path);
+		wal.broken = 1;
+		wal.broken_lsn = wal.durable_lsn;
+		wal.incomplete = 1;
+	}
+	wal.durable_lsn = upto;
+	sync_cond_broadcast(wal.cv);
+	return ok ? 0 : -1;
+}
+
+/* 持有 mu：等其它写盘线程结束并写出全部缓冲 */
+static void drain_locked(void)
+{
+	for (;;) {
+		if (wal.flushing)
+			sync_cond_wait(wal.cv, wal.mu);
+		else if (wal.buf.len)
+			flush_locked();
+		else
+			break;
+	}
+}
+
+static long long file_length(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long long n = 0;
+
+	if (f) {
+		if (fseek(f, 0, SEEK_END) == 0)
+			n = ftell(f);
+		fclose(f);
+	}
+	return n > 0 ? n : 0;
+}
+
+int wal_open(const char *path)
+{
+	char old[WAL_PATH_LEN + 8];
+
+	if (!wal.mu) {
+		wal.mu = sync_mutex_create();
+		wal.cv = sync_cond_create();
+	}
+	wal_close();
+
+	FILE *f = fopen(path, "ab");
+	if (!f)
+		return -1;
+
+	snprintf(old, sizeof(old), "%s.old", path);
+	sync_mutex_lock(wal.mu);
+	wal.f = f;
+	wal.broken = 0;
+	snprintf(wal.path, sizeof(wal.path), "%s", path);
+	wal.file_bytes = file_length(path);
+	wal.old_bytes = file_length(old);
+	sync_mutex_unlock(wal.mu);
+	return 0;
+}
+
+void wal_close(void)
+{
+	if (!wal.mu)
+		return;
+
+	sync_mutex_lock(wal.mu);
+	if (wal.f) {
+		drain_locked();
+		fclose(wal.f);
+		wal.f = NULL;
+	}
+	sync_mutex_unlock(wal.mu);
+}
+
+int wal_is_open(void)
+{
+	if (!wal.mu)
+		return 0;
+
+	sync_mutex_lock(wal.mu);
+	int open = wal.f != NULL;
+	sync_mutex_unlock(wal.mu);
+	return open;
+}
+
+long long wal_append(const char *rec)
+{
+	long long lsn = 0;
+	size_t n = strlen(rec);
+
+	if (!wal.mu)
+		return 0;
+
+	sync_mutex_lock(wal.mu);
+	if (wal.f && !wal.broken) {
+		buf_reserve(&wal.buf, n + 11);
+		wal.buf.len += (size_t)sprintf(wal.buf.p + wal.buf.len, "%08lx %s\n", (unsigned long)crc32_str(rec, n), rec);
+		lsn = ++wal.next_lsn;
+		wal.st.records++;
+	} else if (wal.f) {
+		/* 日志已损坏：不写出，序号照发，提交时报告失败 */
+		lsn = ++wal.next_lsn;
+	}
+	sync_mutex_unlock(wal.mu);
+	return lsn;
+}
+
+int wal_commit(long long lsn)
+{
+	int res = 0;
+
+	if (lsn <= 0 || !wal.mu)
+		return 0;
+
+	sync_mutex_lock(wal.mu);
+	while (wal.durable_lsn < lsn) {
+		if (wal.flushing)
+			sync_cond_wait(wal.cv, wal.mu);
+		else
+			flush_locked();
+	}
+	if ((wal.broken && lsn > wal.broken_lsn) || (lsn > wal.lost_from && lsn <= wal.lost_to))
+		res = -1;
+	sync_mutex_unlock(wal.mu);
+	return res;
+}
+
+int wal_incomplete(void)
+{
+	if (!wal.mu)
+		return 0;
+
+	sync_mutex_lock(wal.mu);
+	int r = wal.incomplete;
+	sync_mutex_unlock(wal.mu);
+	return r;
+}
+
+int wal_sync(void)
+{
+	long long lsn = 0;
+
+	if (!wal.mu)
+		return 0;
+	sync_mutex_lock(wal.mu);
+	if (wal.f)
+		lsn = wal.next_lsn;
+	sync_mutex_unlock(wal.mu);
+	return wal_commit(lsn);
+}
+
+/* 把 src 的内容接到 dst 末尾 */
+static int append_file(const char *src, const char *dst)
+{
+	FILE *in = fopen(src, "rb");
+	if (!in)
+		return 0;
+	FILE *out = fopen(dst, "ab");
+	if (!out) {
+		fclose(in);
+		return -1;
+	}
+
+	char chunk[8192];
+	size_t n;
+	int ok = 1;
+	while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+		if (fwrite(chunk, 1, n, out) != n)
+			ok = 0;
+	ok = ok && fflush(out) == 0 && wal_fsync(wal_fileno(out)) == 0;
+	fclose(in);
+	fclose(out);
+	return ok ? 0 : -1;
+}
+
+int wal_checkpoint_begin(void)
+{
+	char old[WAL_PATH_LEN + 8];
+	int res = 0;
+
+	if (!wal.mu)
+		return 0;
+
+	sync_mutex_lock(wal.mu);
+	if (!wal.f) {
+		sync_mutex_unlock(wal.mu);
+		return 0;
+	}
+	drain_locked();
+	fclose(wal.f);
+
+	/* 上一次保存失败时 .old 还在，把当前日志接在它后面 */
+	snprintf(old, sizeof(old), "%s.old", wal.path);
+	FILE *probe = fopen(old, "rb");
+	if (probe) {
+		fclose(probe);
+		if (append_file(wal.path, old) == 0)
+			remove(wal.path);
+		else
+			res = -1;
+	} else if (rename(wal.path, old) != 0) {
+		res = -1;
+	}
+	if (res == 0) {
+		wal.old_bytes += wal.file_bytes;
+		wal.file_bytes = 0;
+		wal.ckpt_lsn = wal.next_lsn;
+	}
+
+	wal.f = fopen(wal.path, "ab");
+	if (!wal.f) {
+		perror("wal reopen");
+		res = -1;
+	}
+	sync_mutex_unlock(wal.mu);
+	return res;
+}
+
+void wal_checkpoint_end(int snapshot_ok)
+{
+	char old[WAL_PATH_LEN + 8];
+
+	if (!wal.mu || !snapshot_ok)
+		return;
+
+	sync_mutex_lock(wal.mu);
+	snprintf(old, sizeof(old), "%s.old", wal.path);
+	wal.old_bytes = 0;
+	if (!wal.broken) {
+		wal.incomplete = 0;
+	} else if (wal.broken_lsn < wal.ckpt_lsn) {
+		/* 坏日志已轮换进 .old，随之删除；快照含检查点之前的全部操作 */
+		wal.broken = 0;
+		wal.lost_from = wal.ckpt_lsn;
+		wal.lost_to = wal.next_lsn;
+		wal.incomplete = wal.next_lsn > wal.ckpt_lsn;
+	}
+	sync_mutex_unlock(wal.mu);
+	remove(old);
+}
+
+static int truncate_file(const char *path, long long len)
+{
+#ifdef _WIN32
+	int fd = _open(path, _O_RDWR | _O_BINARY);
+	if (fd < 0)
+		return -1;
+	int r = _chsize_s(fd, len) == 0 ? 0 : -1;
+	_close(fd);
+	return r;
+#else
+	return truncate(path, (off_t)len);
+#endif
+}
+
+/*
+ * 校验失败的行之后还有内容时只跳过这一行（其后的记录照常重放）；只有位于文件末尾的残缺行或
+ * 校验失败的行才是写到一半的尾巴，把文件截到它之前，之后追加的记录不会被它挡住
+ */
+static int replay_file(const char *path, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return 0;
+
+	char line[WAL_LINE_MAX];
+	int applied = 0, unseated = 0;
+	long long lineno = 0, off = 0, bad_at = -1, bad_line = 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		size_t len = strlen(line);
+		long long start = off;
+		++lineno;
+		if (bad_at >= 0) {
+			fprintf(stderr, "wal: %s 第 %lld 行校验失败，已跳过\n", path, bad_line);
+			bad_at = -1;
+		}
+		if (!len || line[len - 1] != '\n') {
+			int c = 0;
+			while (!feof(f) && (c = fgetc(f)) != EOF && c != '\n')
+				len++;
+			if (c != '\n') {
+				bad_at = start;
+				bad_line = lineno;
+				break;
+			}
+			off += (long long)len + 1;
+			fprintf(stderr, "wal: %s 第 %lld 行超长，已跳过\n", path, lineno);
+			continue;
+		}
+		off += (long long)len;
+		line[--len] = '\0';
+
+		char *end;
+		unsigned long crc = strtoul(line, &end, 16);
+		if (end != line + 8 || *end != ' ' || crc32_str(end + 1, len - 9) != (uint32_t)crc) {
+			bad_at = start;
+			bad_line = lineno;
+			continue;
+		}
+
+		const char *rec = end + 1;
+		int r = (rec[0] == 'B' || rec[0] == 'C') ? booking_replay(BL, TL, rec) : passenger_replay(PL, rec);
+		if (r < 0)
+			fprintf(stderr, "wal: %s 第 %lld 行格式无效，已跳过\n", path, lineno);
+		else {
+			applied += r != 0;
+			unseated += r == 2;
+		}
+	}
+
+	fclose(f);
+	if (unseated)
+		fprintf(stderr, "wal: %s 中 %d 个订单的座位无法占用，已按未分配座位载入\n", path, unseated);
+	if (bad_at >= 0) {
+		fprintf(stderr, "wal: %s 第 %lld 行（末尾）不完整或校验失败，截掉\n", path, bad_line);
+		if (truncate_file(path, bad_at) != 0)
+			fprintf(stderr, "wal: 无法截断 %s\n", path);
+	}
+	return applied;
+}
+
+int wal_replay(const char *path, TrainList *TL, PassengerList *PL, BookingList *BL)
+{
+	char old[WAL_PATH_LEN + 8];
+
+	/* 日志处于打开状态时先把缓冲写出，重放的才是完整内容 */
+	if (wal.mu) {
+		sync_mutex_lock(wal.mu);
+		if (wal.f)
+			drain_locked();
+		sync_mutex_unlock(wal.mu);
+	}
+
+	snprintf(old, sizeof(old), "%s.old", path);
+	int applied = replay_file(old, TL, PL, BL) + replay_file(path, TL, PL, BL);
+
+	/* 尾部可能被截掉，重新取长度 */
+	if (wal.mu) {
+		sync_mutex_lock(wal.mu);
+		if (wal.f && strcmp(wal.path, path) == 0) {
+			wal.file_bytes = file_length(path);
+			wal.old_bytes = file_length(old);
+		}
+		sync_mutex_unlock(wal.mu);
+	}
+	return applied;
+}
+
+void wal_stats(WalStats *out)
+{
+	if (!out)
+		return;
+	if (!wal.mu) {
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+
+	sync_mutex_lock(wal.mu);
+	*out = wal.st;
+	out->log_bytes = wal.f ? wal.file_bytes + wal.old_bytes + (long long)wal.buf.len : 0;
+	sync_mutex_unlock(wal.mu);
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+#define N 5000
+
+int main(void) {
+    Arena *a = arena_create(0);
+    ASSERT(a != NULL, "arena_create returns pool");
+
+    /* 各种大小的对象互不重叠且 16 字节对齐 */
+    static char *objs[N];
+    static size_t sizes[N];
+    int ok = 1;
+    for (int i = 0; i < N; ++i) {
+        sizes[i] = (size_t)(i * 37 % 3000) + 1;
+        objs[i] = arena_alloc(a, sizes[i]);
+        if ((uintptr_t)objs[i] % 16) ok = 0;
+        memset(objs[i], i & 0xff, sizes[i]);
+    }
+    ASSERT(ok, "objects are 16-byte aligned");
+    for (int i = 0; i < N; ++i)
+        for (size_t k = 0; k < sizes[i]; ++k)
+            if ((unsigned char)objs[i][k] != (i & 0xff)) { ok = 0; break; }
+    ASSERT(ok, "objects do not overlap");
+
+    ArenaStats st;
+    arena_stats(a, &st);
+    ASSERT(st.allocs == N && st.sys_allocs < N / 50, "small objects carved from a few chunks");
+
+    /* 释放后同级分配复用同一块 */
+    char *p = arena_alloc(a, 100);
+    arena_release(a, p, 100);
+    ASSERT(arena_alloc(a, 112) == p, "released object reused by same size class");
+
+    /* realloc 保留内容；同级内不搬动 */
+    int *v = arena_alloc(a, sizeof(int) * 4);
+    for (int i = 0; i < 4; ++i) v[i] = i;
+    for (int cap = 4; cap < 4096; cap *= 2) {
+        v = arena_realloc(a, v, sizeof(int) * cap, sizeof(int) * cap * 2);
+        for (int i = cap; i < cap * 2; ++i) v[i] = i;
+    }
+    for (int i = 0; i < 4096; ++i) if (v[i] != i) ok = 0;
+    ASSERT(ok, "realloc keeps contents while growing");
+    char *q = arena_alloc(a, 20);
+    ASSERT(arena_realloc(a, q, 20, 30) == q, "realloc within size class stays in place");
+
+    /* 大对象单独申请，释放时立即归还系统 */
+    arena_stats(a, &st);
+    long long chunks = st.chunks;
+    char *big = arena_alloc(a, 1 << 20);
+    memset(big, 1, 1 << 20);
+    arena_stats(a, &st);
+    ASSERT(st.chunks == chunks + 1, "large object gets its own block");
+    arena_release(a, big, 1 << 20);
+    arena_stats(a, &st);
+    ASSERT(st.chunks == chunks, "large object returned on release");
+
+    arena_reset(a);
+    arena_stats(a, &st);
+    ASSERT(st.chunks == 0 && st.reserved == 0 && st.live == 0, "reset returns every block");
+    ASSERT(arena_alloc(a, 64) != NULL, "pool usable after reset");
+
+    arena_destroy(a);
+    printf("All arena tests passed\n");
+    return 0;
+}
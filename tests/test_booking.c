@@ -53,6 +53,209 @@ int main(void) {
     res = booking_create(&BL, &TL, &PL, "2026-01-11", "T100", "A", "B", "PX", 2, order3, sizeof(order3));
     ASSERT(res == 0, "booking after cancel succeeds");
 
+    Train g = t;
+    strncpy(g.train_id, "G300", ID_LEN-1);
+    g.stops = malloc(sizeof(Stop) * g.stop_count);
+    memcpy(g.stops, t.stops, sizeof(Stop) * g.stop_count);
+    g.seat_count[2] = 6;
+    ASSERT(train_add(&TL, &g) == 0, "group train added");
+    ASSERT(train_mark_seat(&TL, "G300", "2026-01-11", 2, 1, 0, 1) == 0, "seat 1 pre-sold");
+
+    const char *group[3] = { "PX", "PX", "PX" };
+    char gids[3][ORDER_ID_LEN];
+    int before = BL.size;
+    res = booking_create_group(&BL, &TL, &PL, "2026-01-11", "G300", "A", "B", group, 3, 2, gids);
+    ASSERT(res == 0 && BL.size == before + 3, "group of 3 booked");
+    Booking b0, b2;
+    ASSERT(booking_get(&BL, booking_find_index(&BL, gids[0]), &b0) == 0 &&
+           booking_get(&BL, booking_find_index(&BL, gids[2]), &b2) == 0, "group orders found");
+    ASSERT(b0.seat_index == 2 && b2.seat_index == 4, "group seats are consecutive 2..4");
+
+    res = booking_create_group(&BL, &TL, &PL, "2026-01-11", "G300", "A", "B", group, 3, 2, gids);
+    ASSERT(res == -2 && BL.size == before + 3, "group larger than remaining seats books nothing");
+    ASSERT(train_remaining_seats(&TL, "G300", "2026-01-11", "A", "B", 2) == 2, "failed group left seats untouched");
+
+    const char *bad[2] = { "PX", "NOPE" };
+    ASSERT(booking_create_group(&BL, &TL, &PL, "2026-01-11", "G300", "A", "B", bad, 2, 2, gids) == -1, "unknown passenger rejects group");
+
+    Booking hits[8];
+    int n = booking_find_by_passenger(&BL, "PX", hits, 8);
+    ASSERT(n == 5 && strcmp(hits[0].order_id, order_id) == 0 && hits[0].canceled, "by passenger id lists all orders in order");
+    ASSERT(booking_find_by_passenger(&BL, "Bob", NULL, 0) == 5, "by passenger name finds the same orders");
+    ASSERT(booking_find_by_passenger(&BL, "PX", hits, 2) == 5 && strcmp(hits[1].order_id, order3) == 0, "result truncated to max, total still returned");
+    ASSERT(booking_find_by_train_date(&BL, "T100", "2026-01-11", hits, 8) == 2, "by train+date T100");
+    n = booking_find_by_train_date(&BL, "G300", "2026-01-11", hits, 8);
+    ASSERT(n == 3 && strcmp(hits[2].order_id, gids[2]) == 0, "by train+date G300");
+    ASSERT(booking_find_by_train_date(&BL, "G300", "2026-01-12", hits, 8) == 0, "other date has no orders");
+
+    ASSERT(save_bookings("test_bookings_index.txt", &BL) == 1, "bookings saved");
+    /* 重新载入前先让出座位，如同从空的座位图启动 */
+    for (int i = 0; i < BL.size; ++i) {
+        Booking rb;
+        if (booking_get(&BL, i, &rb) == 0 && !rb.canceled)
+            train_release_seat(&TL, rb.train_id, rb.date, rb.seat_class, rb.seat_index, rb.from_stop_idx, rb.to_stop_idx);
+    }
+    bookinglist_free(&BL);
+    bookinglist_init(&BL);
+    ASSERT(booking_find_by_passenger(&BL, "PX", NULL, 0) == 0, "indexes empty after reinit");
+    ASSERT(load_bookings("test_bookings_index.txt", &BL, &TL) == 1, "bookings reloaded");
+    remove("test_bookings_index.txt");
+    ASSERT(booking_find_by_passenger(&BL, "Bob", NULL, 0) == 5 && booking_find_by_train_date(&BL, "G300", "2026-01-11", NULL, 0) == 3,
+           "secondary indexes rebuilt on load");
+
+    char dd[DATE_LEN], dt[ID_LEN];
+    int serial = 0;
+    ASSERT(booking_decode_order_id(gids[2], dd, sizeof(dd), dt, sizeof(dt), &serial) == 0 &&
+           strcmp(dd, "2026-01-11") == 0 && strcmp(dt, "G300") == 0 && serial == 3, "order id decodes to train/date/serial");
+    ASSERT(booking_decode_order_id("2026-01-11-D-12-0042", dd, sizeof(dd), dt, sizeof(dt), &serial) == 0 &&
+           strcmp(dt, "D-12") == 0 && serial == 42, "train id containing '-' decodes");
+    ASSERT(booking_decode_order_id("2026-13-11-G1-0001", NULL, 0, NULL, 0, NULL) == -1 &&
+           booking_decode_order_id("2026-01-11-G1-", NULL, 0, NULL, 0, NULL) == -1, "malformed order ids rejected");
+    char order4[ORDER_ID_LEN];
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-01-11", "G300", "A", "B", "PX", 2, order4, sizeof(order4)) == 0 &&
+           strcmp(order4, "2026-01-11-G300-0004") == 0, "sequence counter restored on load");
+
+    /* 紧凑记录：展开后字段与下单时一致；非标准订单号原样保留 */
+    ASSERT(sizeof(BookingRec) <= 48, "compact booking record is at most 48 bytes");
+    Booking bx;
+    ASSERT(booking_get(&BL, booking_find_index(&BL, order4), &bx) == 0, "booking_get by index");
+    ASSERT(strcmp(bx.order_id, order4) == 0 && strcmp(bx.passenger_id, "PX") == 0 && strcmp(bx.passenger_name, "Bob") == 0 &&
+           strcmp(bx.date, "2026-01-11") == 0 && strcmp(bx.train_id, "G300") == 0 && strcmp(bx.from, "A") == 0 &&
+           strcmp(bx.to, "B") == 0 && strcmp(bx.depart_time, "09:00") == 0 && bx.price == 50.0 &&
+           strcmp(bx.seat_no, "3-1") == 0 && bx.seat_index == 0 && !bx.canceled, "compact record expands to the original fields");
+    ASSERT(booking_get(&BL, BL.size, &bx) == -1, "booking_get rejects bad index");
+
+    FILE *f = fopen("test_bookings_legacy.txt", "w");
+    fprintf(f, "2\nLEGACY-7|PX|Bob|2026-01-12|T100|A|B|09:00|12.34|3-1|2|0|0|1|1\n"
+               "2026-01-12-T100-7|PX|Bob|2026-01-12|T100|A|B|09:00|12.34|3-1|2|0|0|1|1\n");
+    fclose(f);
+    ASSERT(load_bookings("test_bookings_legacy.txt", &BL, &TL) == 1, "legacy bookings loaded");
+    remove("test_bookings_legacy.txt");
+    ASSERT(booking_get(&BL, booking_find_index(&BL, "LEGACY-7"), &bx) == 0 && strcmp(bx.order_id, "LEGACY-7") == 0 &&
+           bx.price == 12.34 && bx.canceled, "non-standard order id kept verbatim");
+    ASSERT(booking_get(&BL, booking_find_index(&BL, "2026-01-12-T100-7"), &bx) == 0 && strcmp(bx.order_id, "2026-01-12-T100-7") == 0,
+           "unpadded serial kept verbatim");
+
+    /* 列式统计：与逐条展开的结果对照 */
+    BookingAggRow agg[32];
+    ASSERT(booking_aggregate(&BL, 0, BOOKING_AGG_ALL, agg, 1) == 1 && agg[0].count == BL.size, "total counts every booking");
+    int mismatch = 0;
+    for (int by = 0; by < 8; ++by)
+        for (int flt = BOOKING_AGG_ALL; flt <= BOOKING_AGG_CANCELED; ++flt) {
+            int ng = booking_aggregate(&BL, by, flt, agg, 32);
+            long long total = 0;
+            for (int g = 0; g < ng; ++g) {
+                long long cnt = 0, cents = 0, segs = 0;
+                for (int i = 0; i < BL.size; ++i) {
+                    booking_get(&BL, i, &bx);
+                    if ((flt == BOOKING_AGG_ACTIVE && bx.canceled) || (flt == BOOKING_AGG_CANCELED && !bx.canceled))
+                        continue;
+                    if ((by & BOOKING_BY_TRAIN) && strcmp(bx.train_id, agg[g].train_id) != 0) continue;
+                    if ((by & BOOKING_BY_DATE) && strcmp(bx.date, agg[g].date) != 0) continue;
+                    if ((by & BOOKING_BY_CLASS) && bx.seat_class != agg[g].seat_class) continue;
+                    cnt++;
+                    cents += (long long)(bx.price * 100 + 0.5);
+                    segs += bx.to_stop_idx - bx.from_stop_idx;
+                }
+                if (cnt != agg[g].count || cents != agg[g].revenue_cents || segs != agg[g].segments)
+                    mismatch++;
+                if (g > 0 && strcmp(agg[g - 1].train_id, agg[g].train_id) > 0)
+                    mismatch++;
+                total += agg[g].count;
+            }
+            int all = booking_aggregate(&BL, 0, flt, agg, 1);
+            if (all != 1 || agg[0].count != total)
+                mismatch++;
+        }
+    ASSERT(mismatch == 0, "grouped aggregates match a row-by-row scan");
+    int ng = booking_aggregate(&BL, BOOKING_BY_TRAIN | BOOKING_BY_DATE, BOOKING_AGG_CANCELED, agg, 32);
+    ASSERT(ng == 2 && strcmp(agg[0].train_id, "T100") == 0 && strcmp(agg[0].date, "2026-01-11") == 0 && agg[0].count == 1 &&
+           strcmp(agg[1].date, "2026-01-12") == 0 && agg[1].count == 2 && agg[1].revenue_cents == 2468,
+           "canceled per train+date");
+    ASSERT(booking_cancel(&BL, order4, &TL) == 0 &&
+           booking_aggregate(&BL, BOOKING_BY_TRAIN, BOOKING_AGG_CANCELED, agg, 32) == 2 && strcmp(agg[0].train_id, "G300") == 0 &&
+           agg[0].count == 1 && agg[0].seat_class == -1 && agg[0].date[0] == '\0', "cancel updates the canceled column");
+    ASSERT(booking_aggregate(&BL, 8, BOOKING_AGG_ALL, agg, 32) == -1 && booking_aggregate(&BL, 0, 3, agg, 32) == -1,
+           "invalid group/filter rejected");
+
+    /* 并行载入：4 线程，三个日期各 150 条（每 7 条一条已退票），CRLF 换行且末行无换行 */
+    Train pt = t;
+    strncpy(pt.train_id, "P500", ID_LEN-1);
+    pt.stops = malloc(sizeof(Stop) * pt.stop_count);
+    memcpy(pt.stops, t.stops, sizeof(Stop) * pt.stop_count);
+    pt.seat_count[2] = 200;
+    ASSERT(train_add(&TL, &pt) == 0, "parallel-load train added");
+    f = fopen("test_bookings_parallel.txt", "wb");
+    fprintf(f, "450\r\n");
+    for (int i = 0; i < 450; ++i)
+        fprintf(f, "2026-02-%02d-P500-%04d|PX|Bob|2026-02-%02d|P500|A|B|09:00|50.00|3-%d|2|%d|0|1|%d%s",
+                10 + i % 3, i / 3 + 1, 10 + i % 3, i / 3 + 1, i / 3, i % 7 == 0, i < 449 ? "\r\n" : "");
+    fclose(f);
+    int base = BL.size;
+    ASSERT(load_bookings_parallel("test_bookings_parallel.txt", &BL, &TL, 4) == 1 && BL.size == base + 450, "parallel load");
+    int in_order = 1;
+    for (int i = 0; i < 450; i += 37) {
+        char want[ORDER_ID_LEN];
+        snprintf(want, sizeof(want), "2026-02-%02d-P500-%04d", 10 + i % 3, i / 3 + 1);
+        if (booking_get(&BL, base + i, &bx) != 0 || strcmp(bx.order_id, want) != 0 || bx.canceled != (i % 7 == 0))
+            in_order = 0;
+    }
+    ASSERT(in_order, "records stored in file order");
+    int seats_ok = 1;
+    for (int d = 0; d < 3; ++d) {
+        char date[DATE_LEN];
+        int active = 0;
+        snprintf(date, sizeof(date), "2026-02-%02d", 10 + d);
+        for (int i = d; i < 450; i += 3)
+            active += i % 7 != 0;
+        if (train_remaining_seats(&TL, "P500", date, "A", "B", 2) != 200 - active)
+            seats_ok = 0;
+    }
+    ASSERT(seats_ok, "seat marks replayed per train/date");
+    ASSERT(booking_find_by_train_date(&BL, "P500", "2026-02-11", NULL, 0) == 150, "indexes built by parallel load");
+
+    f = fopen("test_bookings_parallel.txt", "wb");
+    fprintf(f, "3\n2026-03-01-P500-0001|PX|Bob|2026-03-01|P500|A|B|09:00|50.00|3-1|2|0|0|1|0\n"
+               "broken line\n2026-03-01-P500-0002|PX|Bob|2026-03-01|P500|A|B|09:00|50.00|3-2|2|1|0|1|0\n");
+    fclose(f);
+    base = BL.size;
+    ASSERT(load_bookings_parallel("test_bookings_parallel.txt", &BL, &TL, 2) == 0 && BL.size == base + 1 &&
+           train_remaining_seats(&TL, "P500", "2026-03-01", "A", "B", 2) == 199, "bad line stops the load after earlier lines");
+
+    /* 同一座位的两条订单、日历槽被另一个未来日期占着的订单：按未分配座位载入并报告失败，座位只占一次 */
+    char fd[DATE_LEN], fd32[DATE_LEN];
+    train_day_to_date(train_today() + 3, fd, sizeof(fd));
+    train_day_to_date(train_today() + 3 + SEATMAP_WINDOW_DAYS, fd32, sizeof(fd32));
+    for (int pass = 0; pass < 2; ++pass) {
+        const char *tid = pass ? "P502" : "P501";
+        Train ct = pt;
+        strncpy(ct.train_id, tid, ID_LEN-1);
+        ct.stops = malloc(sizeof(Stop) * ct.stop_count);
+        memcpy(ct.stops, t.stops, sizeof(Stop) * ct.stop_count);
+        ASSERT(train_add(&TL, &ct) == 0, "conflict-load train added");
+        f = fopen("test_bookings_parallel.txt", "wb");
+        fprintf(f, "3\n%s-%s-0001|PX|Bob|%s|%s|A|B|09:00|50.00|3-1|2|0|0|1|0\n", fd, tid, fd, tid);
+        fprintf(f, "%s-%s-0002|PX|Bob|%s|%s|A|B|09:00|50.00|3-1|2|0|0|1|0\n", fd, tid, fd, tid);
+        fprintf(f, "%s-%s-0001|PX|Bob|%s|%s|A|B|09:00|50.00|3-2|2|1|0|1|0\n", fd32, tid, fd32, tid);
+        fclose(f);
+        base = BL.size;
+        int res = pass ? load_bookings_parallel("test_bookings_parallel.txt", &BL, &TL, 2)
+                       : load_bookings("test_bookings_parallel.txt", &BL, &TL);
+        int unseated = 0;
+        for (int i = 0; i < 3; ++i)
+            unseated += booking_get(&BL, base + i, &bx) == 0 && bx.seat_index == -1;
+        ASSERT(res == 0 && BL.size == base + 3 && unseated == 2, pass ? "parallel load reports unseated bookings"
+                                                                       : "serial load reports unseated bookings");
+    }
+    booking_get(&BL, BL.size - 5, &bx);
+    ASSERT(bx.seat_index == -1 && strcmp(bx.seat_no, "-") == 0 &&
+           train_remaining_seats(&TL, "P501", fd, "A", "B", 2) == 199, "serial load keeps the first claim of a seat");
+    ASSERT(booking_cancel(&BL, bx.order_id, &TL) == 0 &&
+           train_remaining_seats(&TL, "P501", fd, "A", "B", 2) == 199, "canceling an unseated booking keeps the seat taken");
+
+    remove("test_bookings_parallel.txt");
+    ASSERT(load_bookings_parallel("test_bookings_parallel.txt", &BL, &TL, 2) == 0, "missing file reported");
+
     bookinglist_free(&BL);
     passengerlist_free(&PL);
     trainlist_free(&TL);
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+#define THREADS 8
+#define TRAINS 4
+#define SEATS 200
+#define SHARED_SEATS 100
+#define STOPS 4
+
+static TrainList TL;
+static PassengerList PL;
+static BookingList BL;
+
+typedef struct {
+    int id;
+    unsigned long long rng;
+    int shared_ok;
+} Worker;
+
+static unsigned rng(Worker *w) {
+    w->rng = w->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(w->rng >> 33);
+}
+
+static void add_train(const char *id, int seats) {
+    Train t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.train_id, id, ID_LEN-1);
+    strncpy(t.depart_time, "08:00", TIME_LEN-1);
+    t.base_price = 10.0;
+    t.running = 1;
+    t.stop_count = STOPS;
+    t.stops = calloc(STOPS, sizeof(Stop));
+    for (int i = 0; i < STOPS; ++i) snprintf(t.stops[i].name, STATION_LEN, "S%d", i);
+    snprintf(t.from, STATION_LEN, "S0");
+    snprintf(t.to, STATION_LEN, "S%d", STOPS-1);
+    t.seat_count[2] = seats;
+    for (int i = 0; i < 4; ++i) t.seat_price_coef[i] = 1.0;
+    train_add(&TL, &t);
+}
+
+static void *worker(void *arg) {
+    Worker *w = arg;
+    char tid[ID_LEN], pid[ID_LEN], from[8], to[8], order[ORDER_ID_LEN];
+    char mine[64][ORDER_ID_LEN];
+    int nmine = 0;
+    snprintf(tid, sizeof(tid), "C%d", w->id % TRAINS);
+    snprintf(pid, sizeof(pid), "P%d", w->id);
+
+    for (int i = 0; i < 400; ++i) {
+        if (i % 8 == 0 && booking_create(&BL, &TL, &PL, "2026-05-01", "CS", "S0", "S3", pid, 2, order, sizeof(order)) == 0)
+            w->shared_ok++;
+        int f = rng(w) % (STOPS - 1);
+        int t = f + 1 + rng(w) % (STOPS - 1 - f);
+        snprintf(from, sizeof(from), "S%d", f);
+        snprintf(to, sizeof(to), "S%d", t);
+        if (booking_create(&BL, &TL, &PL, "2026-05-01", tid, from, to, pid, 2, order, sizeof(order)) != 0) continue;
+        if (nmine < 64) strcpy(mine[nmine++], order);
+        if (nmine > 0 && rng(w) % 4 == 0) {
+            int k = rng(w) % nmine;
+            booking_cancel(&BL, mine[k], &TL);
+            if (k != --nmine) memcpy(mine[k], mine[nmine], ORDER_ID_LEN);
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+
+    for (int i = 0; i < TRAINS; ++i) {
+        char id[ID_LEN];
+        snprintf(id, sizeof(id), "C%d", i);
+        add_train(id, SEATS);
+    }
+    add_train("CS", SHARED_SEATS);
+    for (int i = 0; i < THREADS; ++i) {
+        Passenger p;
+        memset(&p, 0, sizeof(p));
+        snprintf(p.id_num, sizeof(p.id_num), "P%d", i);
+        snprintf(p.name, sizeof(p.name), "W%d", i);
+        passenger_add(&PL, &p);
+    }
+
+    Worker w[THREADS];
+    SyncThread *th[THREADS];
+    for (int i = 0; i < THREADS; ++i) {
+        w[i].id = i; w[i].rng = 1000 + i; w[i].shared_ok = 0;
+        th[i] = sync_thread_start(worker, &w[i]);
+    }
+    int started = 1;
+    for (int i = 0; i < THREADS; ++i) { if (!th[i]) started = 0; sync_thread_join(th[i]); }
+    ASSERT(started, "worker threads started");
+
+    int shared = 0;
+    for (int i = 0; i < THREADS; ++i) shared += w[i].shared_ok;
+    ASSERT(shared == SHARED_SEATS, "shared train sold exactly its capacity");
+    ASSERT(train_remaining_seats(&TL, "CS", "2026-05-01", "S0", "S3", 2) == 0, "shared train has no seats left");
+
+    /* 按座位 x 区段重放所有有效订单：不能有同一座位同一区段被卖两次 */
+    static unsigned char used[TRAINS + 1][SEATS][STOPS - 1];
+    memset(used, 0, sizeof(used));
+    int overlap = 0, ids_ok = 1;
+    for (int i = 0; i < BL.size; ++i) {
+        Booking bk, *b = &bk;
+        booking_get(&BL, i, b);
+        if (booking_find_index(&BL, b->order_id) != i) ids_ok = 0;
+        if (b->canceled) continue;
+        int tr = strcmp(b->train_id, "CS") == 0 ? TRAINS : b->train_id[1] - '0';
+        for (int s = b->from_stop_idx; s < b->to_stop_idx; ++s) {
+            if (used[tr][b->seat_index][s]) overlap++;
+            used[tr][b->seat_index][s] = 1;
+        }
+    }
+    ASSERT(overlap == 0, "no seat segment sold twice");
+    ASSERT(ids_ok, "order ids unique and indexed");
+
+    int remain_ok = 1;
+    for (int tr = 0; tr < TRAINS; ++tr) {
+        char id[ID_LEN];
+        snprintf(id, sizeof(id), "C%d", tr);
+        for (int f = 0; f < STOPS - 1; ++f)
+            for (int t = f + 1; t < STOPS; ++t) {
+                char from[8], to[8];
+                snprintf(from, sizeof(from), "S%d", f);
+                snprintf(to, sizeof(to), "S%d", t);
+                int expect = 0;
+                for (int s = 0; s < SEATS; ++s) {
+                    int free_run = 1;
+                    for (int k = f; k < t; ++k) if (used[tr][s][k]) free_run = 0;
+                    expect += free_run;
+                }
+                if (train_remaining_seats(&TL, id, "2026-05-01", from, to, 2) != expect) remain_ok = 0;
+            }
+    }
+    ASSERT(remain_ok, "remaining-seat summary matches bookings after concurrent churn");
+
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    printf("All concurrency tests passed\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+#define N 20000
+
+int main(void) {
+    HashTable *ht = ht_create(4);
+    ASSERT(ht != NULL, "ht_create returns table");
+    ASSERT(ht_find(ht, "missing") == -1, "find on empty table returns -1");
+
+    char key[32];
+    for (int i = 0; i < N; ++i) {
+        snprintf(key, sizeof(key), "K%d", i);
+        ht_insert(ht, key, i);
+    }
+    ASSERT(ht_count(ht) == N, "table grows to hold all keys");
+
+    int ok = 1;
+    for (int i = 0; i < N; ++i) {
+        snprintf(key, sizeof(key), "K%d", i);
+        if (ht_find(ht, key) != i) ok = 0;
+    }
+    ASSERT(ok, "every key found after growth");
+
+    ht_insert(ht, "K7", 70);
+    ASSERT(ht_find(ht, "K7") == 70 && ht_count(ht) == N, "insert of existing key overwrites");
+    ASSERT(ht_update(ht, "K7", 7) == 0 && ht_find(ht, "K7") == 7, "ht_update changes value");
+    ASSERT(ht_update(ht, "nope", 1) == -1, "ht_update on missing key returns -1");
+
+    /* 删除偶数键，奇数键必须仍能找到（后移删除不能打断探测链） */
+    for (int i = 0; i < N; i += 2) {
+        snprintf(key, sizeof(key), "K%d", i);
+        if (ht_remove(ht, key) != 0) ok = 0;
+    }
+    ASSERT(ok && ht_count(ht) == N / 2, "ht_remove deletes half the keys");
+    ASSERT(ht_remove(ht, "K0") == -1, "removing twice returns -1");
+    for (int i = 0; i < N; ++i) {
+        snprintf(key, sizeof(key), "K%d", i);
+        if (ht_find(ht, key) != ((i & 1) ? i : -1)) ok = 0;
+    }
+    ASSERT(ok, "remaining keys intact after removals");
+
+    for (int i = 0; i < N; i += 2) {
+        snprintf(key, sizeof(key), "K%d", i);
+        ht_insert(ht, key, -i - 1);
+    }
+    for (int i = 0; i < N; ++i) {
+        snprintf(key, sizeof(key), "K%d", i);
+        if (ht_find(ht, key) != ((i & 1) ? i : -i - 1)) ok = 0;
+    }
+    ASSERT(ok && ht_count(ht) == N, "re-inserted keys coexist with survivors");
+
+    ht_clear(ht);
+    ASSERT(ht_count(ht) == 0 && ht_find(ht, "K1") == -1, "ht_clear empties table");
+    ht_reserve(ht, 1000);
+    ht_insert(ht, "", 5);
+    ASSERT(ht_find(ht, "") == 5, "empty string is a valid key");
+
+    ht_free(ht);
+    printf("All hash tests passed\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "train.h"
+#include "sync.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+/*
+ * ALLOC_LOCK_FREE 压力测试：多个线程在同一车次同一日期上反复抢座/退座（座位很少，冲突频繁），
+ * 另有线程以团体订票（加锁路径）混入。每次抢到后在影子表上按 (座位, 段) 原子加一，
+ * 若加之前不为 0 说明同一座位同一段同时卖给了两个人。
+ */
+
+#define THREADS 8
+#define STOPS 9
+#define SEGS (STOPS - 1)
+#define SEATS 96
+#define OPS 20000
+#define HELD_MAX 512
+
+static TrainList TL;
+static int shadow[SEATS][SEGS];
+static int double_sold = 0;
+
+typedef struct { int seat, from, to; } Held;
+
+typedef struct {
+    int id;
+    unsigned long long rng;
+    Held held[HELD_MAX];
+    int nheld;
+    long claims;
+} Worker;
+
+static unsigned rng(Worker *w) {
+    w->rng = w->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(w->rng >> 33);
+}
+
+static void own(int seat, int from, int to, int delta) {
+    for (int s = from; s < to; ++s)
+        if (sync_fetch_add(&shadow[seat][s], delta) != 0 && delta > 0) sync_fetch_add(&double_sold, 1);
+}
+
+static void *worker(void *arg) {
+    Worker *w = arg;
+    char from[8], to[8];
+    for (int i = 0; i < OPS; ++i) {
+        unsigned r = rng(w);
+        if (w->nheld > 0 && (w->nheld >= HELD_MAX - 4 || r % 5 < 2)) {
+            int k = rng(w) % w->nheld;
+            Held h = w->held[k];
+            own(h.seat, h.from, h.to, -1);
+            train_release_seat(&TL, "LF1", "2026-07-01", 2, h.seat, h.from, h.to);
+            w->held[k] = w->held[--w->nheld];
+            continue;
+        }
+        int f = rng(w) % SEGS;
+        int t = f + 1 + rng(w) % (SEGS - f);
+        snprintf(from, sizeof(from), "S%d", f);
+        snprintf(to, sizeof(to), "S%d", t);
+        if (w->id == 0 && r % 7 == 0) {
+            int seats[3], fi, ti;
+            if (train_allocate_seats(&TL, "LF1", "2026-07-01", from, to, 2, 3, seats, &fi, &ti) != 0) continue;
+            for (int k = 0; k < 3; ++k) {
+                own(seats[k], fi, ti, 1);
+                w->held[w->nheld].seat = seats[k]; w->held[w->nheld].from = fi; w->held[w->nheld].to = ti;
+                w->nheld++;
+            }
+            w->claims += 3;
+            continue;
+        }
+        int seat, fi, ti;
+        if (train_allocate_seat(&TL, "LF1", "2026-07-01", from, to, 2, &seat, &fi, &ti) != 0) continue;
+        own(seat, fi, ti, 1);
+        w->held[w->nheld].seat = seat; w->held[w->nheld].from = fi; w->held[w->nheld].to = ti;
+        w->nheld++;
+        w->claims++;
+        if (r % 11 == 0) train_remaining_seats(&TL, "LF1", "2026-07-01", "S0", to, 2);
+    }
+    return NULL;
+}
+
+int main(void) {
+    trainlist_init(&TL);
+    train_set_alloc_policy(ALLOC_LOCK_FREE);
+    ASSERT(train_get_alloc_policy() == ALLOC_LOCK_FREE, "lock-free policy selected");
+
+    Train t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.train_id, "LF1", ID_LEN-1);
+    t.stop_count = STOPS;
+    t.stops = calloc(STOPS, sizeof(Stop));
+    for (int i = 0; i < STOPS; ++i) snprintf(t.stops[i].name, STATION_LEN, "S%d", i);
+    t.seat_count[2] = SEATS;
+    for (int i = 0; i < 4; ++i) t.seat_price_coef[i] = 1.0;
+    ASSERT(train_add(&TL, &t) == 0, "train added");
+
+    static Worker w[THREADS];
+    SyncThread *th[THREADS];
+    for (int i = 0; i < THREADS; ++i) {
+        w[i].id = i; w[i].rng = 77 + i; w[i].nheld = 0; w[i].claims = 0;
+        th[i] = sync_thread_start(worker, &w[i]);
+    }
+    int started = 1;
+    long claims = 0;
+    for (int i = 0; i < THREADS; ++i) { if (!th[i]) started = 0; sync_thread_join(th[i]); claims += w[i].claims; }
+    ASSERT(started, "worker threads started");
+    ASSERT(claims > OPS, "threads claimed seats concurrently");
+    ASSERT(double_sold == 0, "no seat segment ever held by two claimers at once");
+
+    int owned_ok = 1;
+    for (int s = 0; s < SEATS; ++s)
+        for (int k = 0; k < SEGS; ++k) if (shadow[s][k] != 0 && shadow[s][k] != 1) owned_ok = 0;
+    ASSERT(owned_ok, "shadow ownership balanced after releases");
+
+    /* 余票摘要是在无锁增量下维护的，结束后必须与实际持有情况完全一致 */
+    int remain_ok = 1;
+    for (int f = 0; f < SEGS; ++f)
+        for (int e = f + 1; e <= SEGS; ++e) {
+            char from[8], to[8];
+            snprintf(from, sizeof(from), "S%d", f);
+            snprintf(to, sizeof(to), "S%d", e);
+            int expect = 0;
+            for (int s = 0; s < SEATS; ++s) {
+                int ok = 1;
+                for (int k = f; k < e; ++k) if (shadow[s][k]) ok = 0;
+                expect += ok;
+            }
+            if (train_remaining_seats(&TL, "LF1", "2026-07-01", from, to, 2) != expect) remain_ok = 0;
+        }
+    ASSERT(remain_ok, "remaining-seat summary matches held seats");
+
+    int stops = STOPS, *m = malloc(sizeof(int) * stops * stops);
+    int full = train_remaining_seats(&TL, "LF1", "2026-07-01", "S0", "S8", 2);
+    ASSERT(train_availability_matrix_cached(&TL, "LF1", "2026-07-01", 2, m) == 0 && m[SEGS] == full,
+           "cached matrix agrees after lock-free churn");
+    free(m);
+
+    for (int i = 0; i < THREADS; ++i)
+        for (int k = 0; k < w[i].nheld; ++k)
+            train_release_seat(&TL, "LF1", "2026-07-01", 2, w[i].held[k].seat, w[i].held[k].from, w[i].held[k].to);
+    ASSERT(train_remaining_seats(&TL, "LF1", "2026-07-01", "S0", "S8", 2) == SEATS, "all seats free after releasing everything");
+
+    train_set_alloc_policy(ALLOC_FIRST_FIT);
+    trainlist_free(&TL);
+    printf("All lock-free tests passed\n");
+    return 0;
+}
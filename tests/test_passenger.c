@@ -34,6 +34,26 @@ int main(void) {
     ASSERT(passenger_delete(&PL, "P123") == 0, "passenger_delete returns 0");
     ASSERT(passenger_find_index(&PL, "P123") == -1, "passenger not found after delete");
 
+    /* 删除中间元素后，其后乘客的索引下标随之前移；改证件号后旧号查不到 */
+    const char *ids[4] = { "Q0", "Q1", "Q2", "Q3" };
+    for (int i = 0; i < 4; ++i) {
+        Passenger q;
+        memset(&q, 0, sizeof(q));
+        strncpy(q.id_num, ids[i], sizeof(q.id_num)-1);
+        passenger_add(&PL, &q);
+    }
+    ASSERT(passenger_delete(&PL, "Q1") == 0, "delete middle passenger");
+    int shift_ok = 1;
+    for (int i = 0; i < 4; ++i) {
+        int k = passenger_find_index(&PL, ids[i]);
+        if (i == 1 ? k != -1 : (k < 0 || strcmp(PL.data[k].id_num, ids[i]) != 0)) shift_ok = 0;
+    }
+    ASSERT(shift_ok, "index follows shifted passengers");
+    Passenger r = PL.data[passenger_find_index(&PL, "Q3")];
+    strncpy(r.id_num, "Q9", sizeof(r.id_num)-1);
+    ASSERT(passenger_update(&PL, "Q3", &r) == 0, "update changes id_num");
+    ASSERT(passenger_find_index(&PL, "Q3") == -1 && passenger_find_index(&PL, "Q9") >= 0, "index rekeyed on id change");
+
     passengerlist_free(&PL);
     printf("ALL passenger tests passed\n");
     return 0;
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "route.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+/* stops 形如 { "A", "", "08:00", "B", "09:00", "09:05", ... }：站名、到达、发车 */
+static void add_train(TrainList *TL, const char *id, int running, int n, const char **stops) {
+    Train t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.train_id, id, ID_LEN-1);
+    t.running = running;
+    t.stop_count = n;
+    t.stops = calloc(n, sizeof(Stop));
+    for (int i = 0; i < n; ++i) {
+        strncpy(t.stops[i].name, stops[i*3], STATION_LEN-1);
+        strncpy(t.stops[i].arrive, stops[i*3+1], TIME_LEN-1);
+        strncpy(t.stops[i].depart, stops[i*3+2], TIME_LEN-1);
+    }
+    t.seat_count[2] = 10;
+    for (int i = 0; i < 4; ++i) t.seat_price_coef[i] = 1.0;
+    train_add(TL, &t);
+}
+
+int main(void) {
+    TrainList TL;
+    trainlist_init(&TL);
+
+    const char *g1[] = { "A", "", "08:00", "B", "09:00", "09:05", "C", "10:00", "" };
+    const char *g2[] = { "C", "", "10:10", "D", "10:40", "" };
+    const char *g3[] = { "C", "", "10:30", "D", "10:50", "" };
+    const char *g4[] = { "D", "", "11:30", "E", "12:00", "" };
+    const char *g5[] = { "A", "", "07:00", "E", "23:00", "" };
+    const char *g6[] = { "E", "", "23:30", "A", "00:30", "" };
+    const char *g7[] = { "A", "", "08:00", "E", "08:30", "" };
+    add_train(&TL, "G1", 1, 3, g1);
+    add_train(&TL, "G2", 1, 2, g2);
+    add_train(&TL, "G3", 1, 2, g3);
+    add_train(&TL, "G4", 1, 2, g4);
+    add_train(&TL, "G5", 1, 2, g5);
+    add_train(&TL, "G6", 1, 2, g6);
+    add_train(&TL, "G7", 0, 2, g7);
+
+    ASSERT(route_parse_time("09:05") == 545 && route_parse_time("24:00") == -1 && route_parse_time("9") == -1, "route_parse_time");
+
+    Router *r = route_build(&TL);
+    ASSERT(r != NULL && route_station_count(r) == 5, "router built over 5 stations");
+    ASSERT(route_connection_count(r) == 2 * 7, "two days of connections, stopped train skipped");
+
+    RoutePlan p;
+    ASSERT(route_earliest(r, "A", "C", "07:30", 10, 2, &p) == 0 && p.legs == 1 && p.arrive_min == 600, "direct A->C on G1");
+    ASSERT(strcmp(p.leg[0].train_id, "G1") == 0 && p.leg[0].from_idx == 0 && p.leg[0].to_idx == 2, "direct leg stop indexes");
+
+    ASSERT(route_earliest(r, "A", "D", "07:30", 5, 1, &p) == 0 && p.legs == 2 && strcmp(p.leg[1].train_id, "G2") == 0 && p.arrive_min == 640,
+           "short transfer time catches G2");
+    ASSERT(route_earliest(r, "A", "D", "07:30", 15, 1, &p) == 0 && strcmp(p.leg[1].train_id, "G3") == 0 && p.arrive_min == 650,
+           "longer transfer time falls back to G3");
+    ASSERT(strcmp(p.leg[0].to, "C") == 0 && strcmp(p.leg[1].from, "C") == 0 && p.leg[1].depart_min == 630, "transfer at C");
+
+    ASSERT(route_earliest(r, "A", "E", "07:00", 15, 2, &p) == 0 && p.legs == 3 && p.arrive_min == 720, "two transfers beat the slow direct train");
+    ASSERT(strcmp(p.leg[0].train_id, "G1") == 0 && strcmp(p.leg[2].train_id, "G4") == 0, "two-transfer itinerary legs");
+    ASSERT(route_earliest(r, "A", "E", "07:00", 15, 1, &p) == 0 && p.legs == 1 && strcmp(p.leg[0].train_id, "G5") == 0,
+           "transfer limit leaves only the direct train");
+    ASSERT(route_earliest(r, "A", "E", "07:00", 15, 0, &p) == 0 && p.arrive_min == 23 * 60, "direct only");
+
+    ASSERT(route_earliest(r, "E", "A", "23:00", 10, 0, &p) == 0 && p.arrive_min == 1440 + 30, "overnight train arrives next day");
+    ASSERT(route_earliest(r, "E", "A", "23:45", 10, 0, &p) == 0 && p.leg[0].depart_min == 1440 + 23 * 60 + 30, "missed train waits for next day");
+    ASSERT(route_earliest(r, "B", "E", "10:00", 10, 2, &p) == 0 && p.leg[0].depart_min == 1440 + 9 * 60 + 5, "B->E starts on next day's G1");
+
+    ASSERT(route_earliest(r, "D", "X", "07:00", 10, 2, &p) == -1, "unknown station unreachable");
+    ASSERT(route_earliest(r, "A", "E", "7h", 10, 2, &p) == -2, "bad time rejected");
+    ASSERT(route_earliest(r, "A", "E", "07:00", 10, ROUTE_MAX_LEGS, &p) == -2, "too many transfers rejected");
+
+    route_free(r);
+    trainlist_free(&TL);
+    printf("All route tests passed\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scan.h"
+#include "booking.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+int main(void) {
+    const char *text = "A||-17|2.50\r\nlast|+3|1e2";
+    Scanner s;
+    ScanField f;
+    char buf[4];
+    int n = 0;
+    double d = 0;
+
+    scan_init(&s, text, strlen(text), 1);
+    ASSERT(scan_line(&s) && s.lineno == 1, "first line");
+    ASSERT(scan_str(&s, buf, sizeof(buf)) == 0 && strcmp(buf, "A") == 0, "string field");
+    ASSERT(scan_field(&s, &f) == 0 && f.len == 0, "empty field kept");
+    ASSERT(scan_int(&s, &n) == 0 && n == -17, "negative integer");
+    ASSERT(scan_double(&s, &d) == 0 && d == 2.5, "decimal without the trailing \\r");
+    ASSERT(scan_line(&s) && scan_str(&s, buf, sizeof(buf)) == 0 && strcmp(buf, "las") == 0, "long field truncated to capacity");
+    ASSERT(scan_int(&s, &n) == 0 && n == 3 && scan_double(&s, &d) == 0 && d == 100.0, "last line without newline, exponent via strtod");
+    ASSERT(!s.err && !scan_line(&s) && s.err && s.err_line == 3, "end of input reported on the next line");
+
+    /* 快速路径与 strtod 逐位一致 */
+    int same = 1;
+    for (int i = 0; i < 200000; ++i) {
+        char num[32];
+        snprintf(num, sizeof(num), i % 3 ? "%.2f" : "%.6f", (i * 7919 % 1000003) / 977.0);
+        scan_init(&s, num, strlen(num), 1);
+        scan_line(&s);
+        if (scan_double(&s, &d) != 0 || d != strtod(num, NULL))
+            same = 0;
+    }
+    ASSERT(same, "fast decimal path matches strtod");
+
+    scan_init(&s, "1|2147483647|-2147483648|2147483648", 35, 1);
+    scan_line(&s);
+    ASSERT(scan_int(&s, &n) == 0 && scan_int(&s, &n) == 0 && n == 2147483647 &&
+           scan_int(&s, &n) == 0 && n == -2147483648, "int limits");
+    ASSERT(scan_int(&s, &n) == -1 && s.err_field == 4 && s.err_col == 26, "int overflow located");
+
+    const char *bad = "ok\nG1|x|12a|3\n";
+    scan_init(&s, bad, strlen(bad), 5);
+    scan_line(&s);
+    scan_line(&s);
+    scan_str(&s, buf, sizeof(buf));
+    scan_str(&s, buf, sizeof(buf));
+    ASSERT(scan_int(&s, &n) == -1 && s.err_line == 6 && s.err_col == 8 && s.err_field == 3, "bad digit located");
+    ASSERT(scan_int(&s, &n) == -1 && s.err_field == 3, "first error kept");
+    scan_init(&s, "a|b", 3, 1);
+    scan_line(&s);
+    scan_str(&s, buf, sizeof(buf));
+    scan_str(&s, buf, sizeof(buf));
+    ASSERT(scan_field(&s, &f) == -1 && s.err_field == 3 && s.err_col == 4, "missing field located at end of line");
+    scan_init(&s, "|", 1, 1);
+    scan_line(&s);
+    ASSERT(scan_double(&s, &d) == -1 && s.err_col == 1, "empty number rejected");
+
+    /* 超过旧版 512 字节行缓冲的乘客行照常载入 */
+    FILE *fp = fopen("test_scan_passengers.txt", "wb");
+    fprintf(fp, "2\r\nID|S1|Amy|123|Bob|456\r\nID|S2|");
+    for (int i = 0; i < 3000; ++i)
+        fputc('x', fp);
+    fprintf(fp, "|1|2|3");
+    fclose(fp);
+    PassengerList PL;
+    passengerlist_init(&PL);
+    ASSERT(load_passengers("test_scan_passengers.txt", &PL) == 1 && PL.size == 2 &&
+           strcmp(PL.data[0].emergency_phone, "456") == 0 && strcmp(PL.data[1].phone, "1") == 0 &&
+           strlen(PL.data[1].name) == sizeof(PL.data[1].name) - 1, "long passenger line loaded");
+    passengerlist_free(&PL);
+
+    fp = fopen("test_scan_trains.txt", "wb");
+    fprintf(fp, "1\nG1|A|B|08:00|100.00|1|60|2|1|2|3|4|1.000|1.000|1.000|1.000\nA|08:00|08:00|0\nB|09:00|09:00|x\n");
+    fclose(fp);
+    TrainList TL;
+    trainlist_init(&TL);
+    ASSERT(load_trains("test_scan_trains.txt", &TL) == 0 && TL.size == 0, "bad stop distance rejects the train");
+    trainlist_free(&TL);
+
+    /* 停靠站超过 MAX_STOPS 的车次不再被悄悄丢掉：载入报错，之前的车次保留 */
+    fp = fopen("test_scan_trains.txt", "wb");
+    fprintf(fp, "2\nG1|A|B|08:00|100.00|1|60|2|1|2|3|4|1.000|1.000|1.000|1.000\nA|08:00|08:00|0\nB|09:00|09:00|10\n");
+    fprintf(fp, "G2|A|B|08:00|100.00|1|60|%d|1|2|3|4|1.000|1.000|1.000|1.000\n", MAX_STOPS + 1);
+    for (int i = 0; i <= MAX_STOPS; ++i)
+        fprintf(fp, "S%d|08:00|08:00|%d\n", i, i);
+    fclose(fp);
+    trainlist_init(&TL);
+    ASSERT(load_trains("test_scan_trains.txt", &TL) == 0 && TL.size == 1 &&
+           train_find_index(&TL, "G2") == -1, "train over MAX_STOPS reported");
+    trainlist_free(&TL);
+    remove("test_scan_passengers.txt");
+    remove("test_scan_trains.txt");
+
+    printf("ALL scan tests passed\n");
+    return 0;
+}
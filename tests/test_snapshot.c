@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "wal.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+#define SNAP "test_snapshot.snap"
+
+static void add_train(TrainList *L, const char *id, int seats)
+{
+    Train t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.train_id, id, ID_LEN-1);
+    strncpy(t.from, "A", STATION_LEN-1);
+    strncpy(t.to, "D", STATION_LEN-1);
+    strncpy(t.depart_time, "07:30", TIME_LEN-1);
+    t.base_price = 100.0;
+    t.running = 1;
+    t.duration_minutes = 120;
+    t.stop_count = 4;
+    t.stops = malloc(sizeof(Stop) * t.stop_count);
+    memset(t.stops, 0, sizeof(Stop) * t.stop_count);
+    strncpy(t.stops[0].name, "A", STATION_LEN-1);
+    strncpy(t.stops[1].name, "B", STATION_LEN-1);
+    strncpy(t.stops[2].name, "C", STATION_LEN-1);
+    strncpy(t.stops[3].name, "D", STATION_LEN-1);
+    t.seat_count[0] = 2; t.seat_count[2] = seats;
+    for (int i=0;i<4;i++) t.seat_price_coef[i]=1.0 + i;
+    train_add(L, &t);
+}
+
+int main(void) {
+    TrainList TL; PassengerList PL; BookingList BL;
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    add_train(&TL, "S1", 150);
+    add_train(&TL, "S2", 10);
+
+    Passenger p;
+    memset(&p,0,sizeof(p));
+    strncpy(p.id_type, "ID", sizeof(p.id_type)-1);
+    strncpy(p.id_num, "Q1", sizeof(p.id_num)-1);
+    strncpy(p.name, "Lee", sizeof(p.name)-1);
+    ASSERT(passenger_add(&PL, &p) == 0, "passenger added");
+
+    /* 多个日期、多个座位块、部分区间与退票，覆盖各种 seatmap 状态 */
+    const char *stations[4] = { "A", "B", "C", "D" };
+    char first[ORDER_ID_LEN];
+    int made = 0;
+    for (int i = 0; i < 140; ++i) {
+        char oid[ORDER_ID_LEN];
+        const char *date = (i % 3) ? "2026-05-01" : "2026-05-02";
+        if (booking_create(&BL, &TL, &PL, date, "S1", stations[i % 2], stations[2 + i % 2], "Q1", 2, oid, sizeof(oid)) == 0) {
+            if (!made) memcpy(first, oid, sizeof(oid));
+            made++;
+        }
+    }
+    ASSERT(made == 140, "bookings created");
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-01", "S2", "B", "C", "Q1", 0, NULL, 0) == 0, "second train booked");
+    ASSERT(booking_cancel(&BL, first, &TL) == 0, "one booking canceled");
+
+    int before[4][16], after[16];
+    for (int c = 0; c < 4; ++c)
+        train_availability_matrix(&TL, "S1", "2026-05-01", c, before[c]);
+    int rem_s2 = train_remaining_seats(&TL, "S2", "2026-05-01", "A", "D", 0);
+    BookingAggRow agg_before;
+    booking_aggregate(&BL, 0, BOOKING_AGG_ACTIVE, &agg_before, 1);
+    SeatmapMemStats mem_before;
+    train_seatmap_mem_stats(&mem_before);
+
+    ASSERT(train_evict_before(&TL, "2026-04-01") == 0, "eviction cutoff set before live dates");
+    ASSERT(save_snapshot(SNAP, &TL, &PL, &BL) == 1, "snapshot saved");
+
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 1, "snapshot loaded");
+
+    ASSERT(TL.size == 2 && PL.size == 1 && BL.size == 141, "list sizes restored");
+    ASSERT(train_find_index(&TL, "S2") == 1 && passenger_find_index(&PL, "Q1") == 0, "hash indexes restored");
+    Train *t = train_get(&TL, 0);
+    ASSERT(t->stop_count == 4 && strcmp(t->stops[3].name, "D") == 0 && t->seat_price_coef[2] == 3.0, "train fields restored");
+    int same = 1;
+    for (int c = 0; c < 4; ++c) {
+        train_availability_matrix(&TL, "S1", "2026-05-01", c, after);
+        if (memcmp(after, before[c], sizeof(after)) != 0) same = 0;
+    }
+    ASSERT(same, "availability matrices identical");
+    ASSERT(train_remaining_seats(&TL, "S2", "2026-05-01", "A", "D", 0) == rem_s2, "second train seats restored");
+    ASSERT(train_remaining_seats(&TL, "S2", "2026-03-31", "A", "D", 0) == -1, "eviction cutoff restored");
+    SeatmapMemStats mem_after;
+    train_seatmap_mem_stats(&mem_after);
+    ASSERT(mem_after.dates == mem_before.dates && mem_after.classes == mem_before.classes &&
+           mem_after.chunks == mem_before.chunks, "seatmap storage restored lazily as before");
+
+    Booking bx;
+    ASSERT(booking_get(&BL, booking_find_index(&BL, first), &bx) == 0 && bx.canceled &&
+           strcmp(bx.passenger_name, "Lee") == 0 && strcmp(bx.depart_time, "07:30") == 0, "booking record restored");
+    ASSERT(booking_find_by_passenger(&BL, "Lee", NULL, 0) == 141 &&
+           booking_find_by_train_date(&BL, "S1", "2026-05-02", NULL, 0) == 47, "secondary indexes restored");
+    BookingAggRow agg_after;
+    booking_aggregate(&BL, 0, BOOKING_AGG_ACTIVE, &agg_after, 1);
+    ASSERT(agg_after.count == agg_before.count && agg_after.revenue_cents == agg_before.revenue_cents, "columns rebuilt");
+
+    /* 载入后照常订票：座位不与已售重叠，序号接着原计数器 */
+    char oid[ORDER_ID_LEN];
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-01", "S2", "B", "C", "Q1", 0, oid, sizeof(oid)) == 0 &&
+           strcmp(oid, "2026-05-01-S2-0002") == 0, "sequence counter restored");
+    ASSERT(train_remaining_seats(&TL, "S2", "2026-05-01", "B", "C", 0) == 0, "new booking took the remaining seat");
+
+    /* 截断或改坏的文件被拒绝，三张表清空 */
+    BookingRec rec0 = BL.data[0];
+    FILE *f = fopen(SNAP, "rb");
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(len);
+    ASSERT(fread(buf, 1, len, f) == (size_t)len, "snapshot read back");
+    fclose(f);
+    f = fopen(SNAP, "wb");
+    fwrite(buf, 1, len / 2, f);
+    fclose(f);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 0 && TL.size == 0 && PL.size == 0 && BL.size == 0,
+           "truncated snapshot rejected");
+    /* 结构完好、但记录里的驻留池编号越界的文件同样被拒绝 */
+    long at = -1;
+    for (long off = 0; off + (long)sizeof(BookingRec) <= len; ++off)
+        if (memcmp(buf + off, &rec0, sizeof(rec0)) == 0) { at = off; break; }
+    ASSERT(at >= 0, "booking record located in snapshot");
+    BookingRec bad;
+    memcpy(&bad, buf + at, sizeof(bad));
+    bad.train_id = 0xffffff;
+    memcpy(buf + at, &bad, sizeof(bad));
+    f = fopen(SNAP, "wb");
+    fwrite(buf, 1, len, f);
+    fclose(f);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 0 && BL.size == 0, "out-of-range pool id rejected");
+    buf[8] = (char)(SNAPSHOT_VERSION + 1);
+    f = fopen(SNAP, "wb");
+    fwrite(buf, 1, len, f);
+    fclose(f);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 0, "version mismatch rejected");
+    free(buf);
+    remove(SNAP);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 0, "missing snapshot reported");
+
+    /* 增量保存：改动都在日志里时只落盘日志，车次有改动或日志未打开时重写快照 */
+    remove("test_snapshot.wal");
+    remove("test_snapshot.wal.old");
+    add_train(&TL, "S1", 150);
+    ASSERT(passenger_add(&PL, &p) == 0, "passenger re-added without log");
+    ASSERT(wal_open("test_snapshot.wal") == 0, "wal opened");
+    ASSERT(save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_WRITTEN, "unlogged changes force a full snapshot");
+    FILE *sf = fopen(SNAP, "rb");
+    fseek(sf, 0, SEEK_END);
+    long snap_len = ftell(sf);
+    fclose(sf);
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-03", "S1", "A", "D", "Q1", 2, oid, sizeof(oid)) == 0, "booking after snapshot");
+    ASSERT(save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_LOGGED, "logged booking saves without rewriting");
+    sf = fopen(SNAP, "rb");
+    fseek(sf, 0, SEEK_END);
+    ASSERT(ftell(sf) == snap_len, "snapshot file untouched");
+    fclose(sf);
+    WalStats ws;
+    wal_stats(&ws);
+    ASSERT(ws.log_bytes > 0, "log holds the change");
+
+    wal_close();
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 1 && BL.size == 0 &&
+           wal_replay("test_snapshot.wal", &TL, &PL, &BL) == 1 && booking_find_index(&BL, oid) == 0 &&
+           train_remaining_seats(&TL, "S1", "2026-05-03", "A", "D", 2) == 149, "snapshot plus log restores the booking");
+    ASSERT(wal_open("test_snapshot.wal") == 0 &&
+           save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_LOGGED, "replay after load keeps the base");
+    add_train(&TL, "S3", 5);
+    ASSERT(save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_WRITTEN, "train change compacts");
+    wal_stats(&ws);
+    ASSERT(ws.log_bytes == 0, "log emptied by compaction");
+    wal_close();
+    long long bv = booking_version();
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-03", "S3", "A", "D", "Q1", 2, NULL, 0) == 0 && booking_version() != bv,
+           "booking without a log counts as unlogged");
+    ASSERT(save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_WRITTEN, "no log means a full snapshot");
+
+    /* 后台保存：映像生成后即可继续订票，之后的订票进入新日志，快照加日志恢复两者 */
+    ASSERT(wal_open("test_snapshot.wal") == 0, "wal reopened");
+    add_train(&TL, "S4", 5);
+    int bg = save_snapshot_background(SNAP, &TL, &PL, &BL);
+    ASSERT(bg == SNAPSHOT_STARTED || bg == SNAPSHOT_WRITTEN, "background save started");
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-03", "S4", "A", "D", "Q1", 2, oid, sizeof(oid)) == 0,
+           "booking while the snapshot is written");
+    SnapshotStatus ss;
+    ASSERT(snapshot_wait() == 1, "background save succeeded");
+    snapshot_status(&ss);
+    ASSERT(ss.state == SNAPSHOT_DONE && ss.total > 0 && ss.written == ss.total, "status reports the whole image written");
+    ASSERT(fopen("test_snapshot.wal.old", "rb") == NULL, "checkpoint finished by the background save");
+    ASSERT(save_snapshot_background(SNAP, &TL, &PL, &BL) == SNAPSHOT_LOGGED, "later booking is covered by the log");
+    wal_close();
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    ASSERT(load_snapshot(SNAP, &TL, &PL, &BL) == 1 && train_remaining_seats(&TL, "S4", "2026-05-03", "A", "D", 2) == 5,
+           "image taken before the booking");
+    ASSERT(wal_replay("test_snapshot.wal", &TL, &PL, &BL) == 1 && booking_find_index(&BL, oid) >= 0 &&
+           train_remaining_seats(&TL, "S4", "2026-05-03", "A", "D", 2) == 4, "log restores the later booking");
+    remove("test_snapshot.wal");
+    remove("test_snapshot.wal.old");
+    remove(SNAP);
+
+#ifndef _WIN32
+    /* 日志写盘失败过：之后即使日志恢复正常，下次保存也要重写快照 */
+    ASSERT(wal_open("test_snapshot.wal") == 0 && save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_WRITTEN &&
+           save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_LOGGED, "base snapshot before the log failure");
+    ASSERT(wal_open("/dev/full") == 0 &&
+           booking_create(&BL, &TL, &PL, "2026-05-03", "S4", "A", "D", "Q1", 2, NULL, 0) == ERR_NOT_DURABLE,
+           "booking with a failing log");
+    ASSERT(wal_open("test_snapshot.wal") == 0 && wal_incomplete(), "log still incomplete after reopening");
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-05-03", "S4", "A", "D", "Q1", 2, NULL, 0) == 0, "later booking logged");
+    ASSERT(save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_WRITTEN, "incomplete log forces a full snapshot");
+    ASSERT(!wal_incomplete() && save_snapshot_incremental(SNAP, &TL, &PL, &BL) == SNAPSHOT_LOGGED,
+           "log trusted again after the compaction");
+    wal_close();
+#endif
+    remove("test_snapshot.wal");
+    remove("test_snapshot.wal.old");
+    remove(SNAP);
+
+    /* 文本导出先写临时文件再改名，失败时不留下半个文件 */
+    ASSERT(save_bookings("test_snapshot_bookings.txt", &BL) == 1 && fopen("test_snapshot_bookings.txt.tmp", "rb") == NULL,
+           "text save replaced atomically");
+    remove("test_snapshot_bookings.txt");
+    ASSERT(save_trains("no_such_dir/trains.txt", &TL) == 0, "unwritable path reported");
+
+    bookinglist_free(&BL);
+    passengerlist_free(&PL);
+    trainlist_free(&TL);
+    printf("ALL snapshot tests passed\n");
+    return 0;
+}
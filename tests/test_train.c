@@ -61,6 +61,138 @@ int main(void) {
     r = train_allocate_seat(&TL, "T1", "2026-01-10", "A", "C", 2, &seat_index, &from_idx, &to_idx);
     ASSERT(r == 0 && seat_index >= 0, "allocation after release succeeds");
 
+    r = train_allocate_seat(&TL, "T1", "2026-01-11", "A", "B", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 0, "short segment A-B takes seat 0");
+
+    r = train_allocate_seat(&TL, "T1", "2026-01-11", "B", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 0 && from_idx == 1 && to_idx == 3, "B-D reuses seat 0 after A-B");
+
+    r = train_allocate_seat(&TL, "T1", "2026-01-11", "A", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 1, "A-D goes to seat 1");
+
+    ASSERT(train_mark_seat(&TL, "T1", "2026-01-11", 2, 5, 0, 1) != 0, "mark out of range seat fails");
+
+    ASSERT(train_remaining_seats(&TL, "T1", "2026-01-11", "A", "D", 2) == 0, "no seat free A-D on 01-11");
+    ASSERT(train_remaining_seats(&TL, "T1", "2026-01-12", "A", "D", 2) == 2, "untouched date has all seats");
+    train_release_seat(&TL, "T1", "2026-01-11", 2, 0, 1, 3);
+    ASSERT(train_remaining_seats(&TL, "T1", "2026-01-11", "B", "D", 2) == 1, "B-D free again after release");
+    ASSERT(train_remaining_seats(&TL, "T1", "2026-01-11", "A", "C", 2) == 0, "A-C still blocked");
+    ASSERT(train_remaining_seats(&TL, "T1", "2026-01-11", "C", "A", 2) == -1, "reversed stops rejected");
+
+    int m[16];
+    ASSERT(train_availability_matrix(&TL, "T1", "2026-01-11", 2, m) == 0, "availability matrix computed");
+    ASSERT(m[0*4+1] == 0 && m[1*4+3] == 1 && m[2*4+3] == 1 && m[0*4+3] == 0, "matrix matches per-pair queries");
+    ASSERT(train_availability_matrix_cached(&TL, "T1", "2026-01-11", 2, m) == 0 && m[1*4+3] == 1, "cached matrix filled");
+    r = train_allocate_seat(&TL, "T1", "2026-01-11", "C", "D", 2, &seat_index, &from_idx, &to_idx);
+    train_availability_matrix_cached(&TL, "T1", "2026-01-11", 2, m);
+    ASSERT(r == 0 && m[2*4+3] == 0 && m[1*4+2] == 1, "cache invalidated by allocation");
+
+    Train t2 = t;
+    strncpy(t2.train_id, "T2", ID_LEN-1);
+    t2.stops = malloc(sizeof(Stop) * t2.stop_count);
+    memcpy(t2.stops, t.stops, sizeof(Stop) * t2.stop_count);
+    t2.seat_count[2] = 130;
+    ASSERT(train_add(&TL, &t2) == 0, "train_add T2 with 130 seats");
+    int ok = 1;
+    for (int i = 0; i < 130 && ok; ++i)
+        ok = train_allocate_seat(&TL, "T2", "2026-01-10", "B", "D", 2, &seat_index, &from_idx, &to_idx) == 0 && seat_index == i;
+    ASSERT(ok, "130 seats allocated in index order across bitmap words");
+    r = train_allocate_seat(&TL, "T2", "2026-01-10", "C", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r != 0, "131st allocation fails");
+    r = train_allocate_seat(&TL, "T2", "2026-01-10", "A", "B", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 0, "A-B still free on seat 0");
+    train_release_seat(&TL, "T2", "2026-01-10", 2, 100, 1, 3);
+    r = train_allocate_seat(&TL, "T2", "2026-01-10", "A", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 100, "released seat 100 found in second word");
+
+    ASSERT(train_mark_seat(&TL, "T1", "2026-01-20", 2, 1, 2, 3) == 0, "mark seat 1 C-D");
+    train_set_alloc_policy(ALLOC_BEST_FIT);
+    r = train_allocate_seat(&TL, "T1", "2026-01-20", "A", "B", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 1, "best-fit puts A-B on the shorter free run");
+    train_set_alloc_policy(ALLOC_FIRST_FIT);
+
+    int d0 = train_date_to_day("2026-01-10");
+    char dbuf[DATE_LEN];
+    train_day_to_date(d0 + 22, dbuf, sizeof(dbuf));
+    ASSERT(d0 > 0 && strcmp(dbuf, "2026-02-01") == 0, "date <-> day number round trip");
+    ASSERT(train_date_to_day("2026-02-30") == -1 && train_date_to_day("2026/01/10") == -1, "invalid dates rejected");
+
+    /* 日历环：两个未来日期争用同一槽位时后者被拒；槽位上的日期过期后，之后的日期照常售票 */
+    int today = train_today();
+    char fut[DATE_LEN], fut32[DATE_LEN], past[DATE_LEN], past32[DATE_LEN];
+    train_day_to_date(today + 10, fut, sizeof(fut));
+    train_day_to_date(today + 10 + SEATMAP_WINDOW_DAYS, fut32, sizeof(fut32));
+    train_day_to_date(today - 5, past, sizeof(past));
+    train_day_to_date(today - 5 + SEATMAP_WINDOW_DAYS, past32, sizeof(past32));
+    int full = train_remaining_seats(&TL, "T1", fut, "A", "D", 2);
+    ASSERT(train_allocate_seat(&TL, "T1", fut, "A", "D", 2, &seat_index, &from_idx, &to_idx) == 0, "future date sold");
+    r = train_allocate_seat(&TL, "T1", fut32, "A", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r != 0, "future date whose calendar slot holds another future date is rejected");
+    ASSERT(train_remaining_seats(&TL, "T1", fut, "A", "D", 2) == full - 1, "earlier future date keeps its sales");
+    ASSERT(train_remaining_seats(&TL, "T1", fut32, "A", "D", 2) == -1, "date outside the window is not reported free");
+
+    ASSERT(train_allocate_seat(&TL, "T1", past, "A", "D", 2, &seat_index, &from_idx, &to_idx) == 0, "past date sold");
+    ASSERT(train_remaining_seats(&TL, "T1", past32, "A", "D", 2) == full, "date after a passed date reported free");
+    r = train_allocate_seat(&TL, "T1", past32, "A", "D", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0 && seat_index == 0, "date 32 days after a passed date sold on a fresh seatmap");
+    ASSERT(train_remaining_seats(&TL, "T1", past32, "A", "D", 2) == full - 1, "passed date evicted lazily");
+    ASSERT(train_remaining_seats(&TL, "T1", past, "A", "D", 2) == -1, "evicted past date no longer reported");
+
+    SeatmapMemStats m0, m1, m2;
+    train_seatmap_mem_stats(&m0);
+    ASSERT(train_remaining_seats(&TL, "T2", "2026-02-12", "A", "D", 2) == 130, "untouched date reports full capacity");
+    train_seatmap_mem_stats(&m1);
+    ASSERT(m1.bytes == m0.bytes && m1.dates == m0.dates, "query on an unsold date allocates nothing");
+    r = train_allocate_seat(&TL, "T2", "2026-02-12", "A", "B", 2, &seat_index, &from_idx, &to_idx);
+    train_seatmap_mem_stats(&m2);
+    ASSERT(r == 0 && m2.classes == m1.classes + 1 && m2.chunks == m1.chunks + 1, "first sale materializes one class and one chunk");
+    train_mark_seat(&TL, "T2", "2026-02-12", 2, 129, 0, 3);
+    train_seatmap_mem_stats(&m2);
+    ASSERT(m2.chunks == m1.chunks + 2, "sale in the last coach adds only that chunk");
+
+    int i2 = train_find_index(&TL, "T2");
+    ASSERT(train_delete(&TL, "T1") == 0, "train_delete T1");
+    ASSERT(train_find_index(&TL, "T1") == -1 && train_find_index(&TL, "T2") == i2 - 1, "index shifts after delete");
+    ASSERT(train_remaining_seats(&TL, "T2", "2026-02-12", "A", "B", 2) == 128, "shifted train keeps its seatmap");
+
+    Train t3 = t;
+    strncpy(t3.train_id, "T3", ID_LEN-1);
+    t3.stops = malloc(sizeof(Stop) * t3.stop_count);
+    memset(t3.stops, 0, sizeof(Stop) * t3.stop_count);
+    for (int i = 0; i < 4; ++i) t3.stops[i].name[0] = (char)('D' - i);
+    t3.seat_count[2] = 5;
+    ASSERT(train_add(&TL, &t3) == 0, "train_add reversed T3");
+    TrainMatch tm[4];
+    int nm = train_find_between(&TL, "A", "C", "2026-02-12", tm, 4);
+    ASSERT(nm == 1 && strcmp(tm[0].train_id, "T2") == 0 && tm[0].from_idx == 0 && tm[0].to_idx == 2, "A->C served only by T2");
+    ASSERT(tm[0].remaining[2] == 128 && tm[0].remaining[0] == 0, "A->C remaining seats per class");
+    nm = train_find_between(&TL, "C", "A", NULL, tm, 4);
+    ASSERT(nm == 1 && strcmp(tm[0].train_id, "T3") == 0 && tm[0].remaining[2] == -1, "C->A served only by T3, no date");
+    ASSERT(train_find_between(&TL, "A", "Z", NULL, tm, 4) == 0, "unknown station has no trains");
+    Train t3u = *train_get(&TL, train_find_index(&TL, "T3"));
+    strncpy(t3u.stops[1].name, "X", STATION_LEN-1);
+    ASSERT(train_update(&TL, "T3", &t3u) == 0, "rename a stop of T3");
+    ASSERT(train_find_between(&TL, "X", "A", NULL, tm, 4) == 1 && train_find_between(&TL, "C", "A", NULL, tm, 4) == 0,
+           "station index follows update");
+    ASSERT(train_delete(&TL, "T2") == 0, "train_delete T2");
+    nm = train_find_between(&TL, "X", "A", "2026-02-12", tm, 4);
+    ASSERT(nm == 1 && strcmp(tm[0].train_id, "T3") == 0 && tm[0].remaining[2] == 5, "station index shifted after delete");
+    ASSERT(train_find_between(&TL, "A", "B", NULL, tm, 4) == 0, "deleted train gone from station index");
+
+    /* 显式淘汰：截止日以前的日期不再售票，也不再报告余票；放在最后，截止日之后不能再用更早的日期 */
+    char after_fut[DATE_LEN];
+    train_day_to_date(today + 11, after_fut, sizeof(after_fut));
+    ASSERT(train_allocate_seat(&TL, "T3", fut, "D", "A", 2, &seat_index, &from_idx, &to_idx) == 0 &&
+           train_allocate_seat(&TL, "T3", fut32, "D", "A", 2, &seat_index, &from_idx, &to_idx) != 0, "T3 slot held by a future date");
+    ASSERT(train_evict_before(&TL, after_fut) > 0, "explicit eviction");
+    r = train_allocate_seat(&TL, "T3", fut32, "D", "A", 2, &seat_index, &from_idx, &to_idx);
+    ASSERT(r == 0, "slot reused once the earlier date is evicted");
+    ASSERT(train_remaining_seats(&TL, "T3", fut, "D", "A", 2) == -1 &&
+           train_allocate_seat(&TL, "T3", fut, "D", "A", 2, &seat_index, &from_idx, &to_idx) != 0,
+           "evicted date neither reported free nor sold");
+    ASSERT(train_find_between(&TL, "D", "A", fut, tm, 4) == 1 && tm[0].remaining[2] == -1,
+           "search reports no seats for an evicted date");
+
     trainlist_free(&TL);
     printf("ALL train tests passed\n");
     return 0;
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "booking.h"
+#include "sync.h"
+#include "wal.h"
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL: %s\n", msg); return 1; } \
+    else { printf("OK: %s\n", msg); } \
+} while(0)
+
+#define WAL "test_wal.wal"
+#define THREADS 8
+#define PER_THREAD 50
+
+static TrainList TL;
+static PassengerList PL;
+static BookingList BL;
+
+static void add_train(TrainList *L)
+{
+    Train t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.train_id, "W1", ID_LEN-1);
+    strncpy(t.from, "A", STATION_LEN-1);
+    strncpy(t.to, "C", STATION_LEN-1);
+    strncpy(t.depart_time, "08:00", TIME_LEN-1);
+    t.base_price = 30.0;
+    t.running = 1;
+    t.duration_minutes = 90;
+    t.stop_count = 3;
+    t.stops = malloc(sizeof(Stop) * t.stop_count);
+    memset(t.stops, 0, sizeof(Stop) * t.stop_count);
+    strncpy(t.stops[0].name, "A", STATION_LEN-1);
+    strncpy(t.stops[1].name, "B", STATION_LEN-1);
+    strncpy(t.stops[2].name, "C", STATION_LEN-1);
+    t.seat_count[2] = THREADS * PER_THREAD + 1;
+    for (int i=0;i<4;i++) t.seat_price_coef[i]=1.0;
+    train_add(L, &t);
+}
+
+/* 重放前清空订单与座位占用，模拟从空快照启动 */
+static void reset_bookings(void)
+{
+    bookinglist_free(&BL); trainlist_free(&TL);
+    bookinglist_init(&BL); trainlist_init(&TL);
+    add_train(&TL);
+}
+
+static void *book_worker(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < PER_THREAD; ++i)
+        booking_create(&BL, &TL, &PL, "2026-03-01", "W1", "A", "C", "P1", 2, NULL, 0);
+    return NULL;
+}
+
+int main(void) {
+    remove(WAL);
+    remove(WAL ".old");
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    add_train(&TL);
+
+    ASSERT(wal_open(WAL) == 0 && wal_is_open(), "wal opened");
+
+    Passenger p;
+    memset(&p,0,sizeof(p));
+    strncpy(p.id_type, "ID", sizeof(p.id_type)-1);
+    strncpy(p.id_num, "P1", sizeof(p.id_num)-1);
+    strncpy(p.name, "Ann", sizeof(p.name)-1);
+    ASSERT(passenger_add(&PL, &p) == 0, "passenger P1 added");
+    strncpy(p.id_num, "P2", sizeof(p.id_num)-1);
+    strncpy(p.name, "Tom", sizeof(p.name)-1);
+    ASSERT(passenger_add(&PL, &p) == 0, "passenger P2 added");
+    strncpy(p.phone, "123", sizeof(p.phone)-1);
+    ASSERT(passenger_update(&PL, "P2", &p) == 0, "passenger P2 updated");
+
+    char first[ORDER_ID_LEN];
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-03-01", "W1", "A", "B", "P2", 2, first, sizeof(first)) == 0, "single booking");
+    ASSERT(passenger_delete(&PL, "P2") == 0, "passenger P2 deleted");
+
+    /* 多线程并发订票：每条都要落盘，但 fsync 次数应少于记录数 */
+    SyncThread *th[THREADS];
+    for (int i = 0; i < THREADS; ++i)
+        th[i] = sync_thread_start(book_worker, NULL);
+    for (int i = 0; i < THREADS; ++i)
+        sync_thread_join(th[i]);
+    ASSERT(BL.size == 1 + THREADS * PER_THREAD, "concurrent bookings all succeeded");
+    ASSERT(booking_cancel(&BL, first, &TL) == 0, "first booking canceled");
+
+    WalStats st;
+    wal_stats(&st);
+    ASSERT(st.records == 6 + THREADS * PER_THREAD, "one record per operation");
+    ASSERT(st.syncs > 0 && st.syncs <= st.records, "records grouped into fsyncs");
+    printf("records=%lld syncs=%lld bytes=%lld\n", st.records, st.syncs, st.bytes);
+    wal_close();
+    ASSERT(!wal_is_open(), "wal closed");
+
+    /* 空快照 + 重放日志即恢复全部状态 */
+    bookinglist_free(&BL); passengerlist_free(&PL); trainlist_free(&TL);
+    trainlist_init(&TL); passengerlist_init(&PL); bookinglist_init(&BL);
+    add_train(&TL);
+    int n = wal_replay(WAL, &TL, &PL, &BL);
+    ASSERT(n == 6 + THREADS * PER_THREAD, "every record replayed");
+    ASSERT(PL.size == 1 && passenger_find_index(&PL, "P2") == -1, "passenger add/delete replayed");
+    Booking bx;
+    ASSERT(booking_get(&BL, booking_find_index(&BL, first), &bx) == 0 && bx.canceled &&
+           strcmp(bx.passenger_name, "Tom") == 0, "cancel replayed");
+    ASSERT(train_remaining_seats(&TL, "W1", "2026-03-01", "A", "C", 2) == 1 &&
+           train_remaining_seats(&TL, "W1", "2026-03-01", "A", "B", 2) == 1, "seat occupancy replayed");
+
+    /* 快照已包含的记录再放一遍不改变状态 */
+    wal_replay(WAL, &TL, &PL, &BL);
+    ASSERT(BL.size == 1 + THREADS * PER_THREAD && PL.size == 1 &&
+           train_remaining_seats(&TL, "W1", "2026-03-01", "A", "C", 2) == 1, "replay is idempotent");
+
+    /* 保存快照：checkpoint 后旧日志在 .old，保存成功才删除 */
+    ASSERT(wal_open(WAL) == 0, "wal reopened");
+    ASSERT(wal_checkpoint_begin() == 0, "checkpoint begins");
+    char order2[ORDER_ID_LEN];
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-03-02", "W1", "A", "C", "P1", 2, order2, sizeof(order2)) == 0,
+           "booking during save");
+    wal_checkpoint_end(0);
+    FILE *f = fopen(WAL ".old", "rb");
+    ASSERT(f != NULL, "failed save keeps the old log");
+    fclose(f);
+    ASSERT(wal_checkpoint_begin() == 0, "second checkpoint appends to the old log");
+    wal_checkpoint_end(1);
+    f = fopen(WAL ".old", "rb");
+    ASSERT(f == NULL, "successful save drops the old log");
+    wal_close();
+
+    /* 宕机时写了一半的尾部被忽略并截掉，之后追加的记录不会被它挡住 */
+    f = fopen(WAL, "ab");
+    fputs("deadbeef B|2026-03-02-W1-00", f);
+    fclose(f);
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 0, "torn tail ignored");
+    char order3[ORDER_ID_LEN];
+    ASSERT(wal_open(WAL) == 0 &&
+           booking_create(&BL, &TL, &PL, "2026-03-03", "W1", "A", "C", "P1", 2, order3, sizeof(order3)) == 0,
+           "booking logged after the torn tail");
+    wal_close();
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 1 && booking_find_index(&BL, order3) == 0, "record after the torn tail replayed");
+    f = fopen(WAL, "ab");
+    fputs("00000000 C|x\n", f);
+    fclose(f);
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 1, "checksum mismatch on the last line ignored");
+
+    /* 校验失败的行后面还有记录时只跳过该行，不截掉其后的内容 */
+    f = fopen(WAL, "ab");
+    fputs("00000000 C|x\n", f);
+    fclose(f);
+    char order4[ORDER_ID_LEN];
+    ASSERT(wal_open(WAL) == 0 &&
+           booking_create(&BL, &TL, &PL, "2026-03-03", "W1", "A", "C", "P1", 2, order4, sizeof(order4)) == 0,
+           "booking logged after a corrupt line");
+    wal_close();
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 2 && booking_find_index(&BL, order4) == 1, "corrupt line in the middle skipped");
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 2, "records after the corrupt line kept in the file");
+
+    /* 含换行或 '|' 的字段会把一条记录拆成两行，直接拒绝 */
+    ASSERT(wal_open(WAL) == 0, "wal reopened for field checks");
+    Passenger bad;
+    memset(&bad, 0, sizeof(bad));
+    strcpy(bad.id_type, "ID");
+    strcpy(bad.id_num, "P9");
+    strcpy(bad.name, "bad\nname");
+    int np = PL.size;
+    ASSERT(passenger_add(&PL, &bad) == ERR_BAD_FIELD && PL.size == np, "newline in a name rejected");
+    strcpy(bad.name, "ok");
+    strcpy(bad.phone, "1|2");
+    ASSERT(passenger_update(&PL, "P1", &bad) == ERR_BAD_FIELD, "'|' in an update rejected");
+    ASSERT(booking_create(&BL, &TL, &PL, "2026-03-03", "W1", "A\r", "C", "P1", 2, NULL, 0) == ERR_BAD_FIELD,
+           "carriage return in a station rejected");
+    wal_close();
+
+    /* 重放时座位已被占用的订单不再悄悄记成有座：按未分配座位载入，座位不会被卖两次 */
+    char fut[DATE_LEN], ox[ORDER_ID_LEN], oy[ORDER_ID_LEN];
+    train_day_to_date(train_today() + 5, fut, sizeof(fut));
+    remove(WAL);
+    ASSERT(wal_open(WAL) == 0 &&
+           booking_create(&BL, &TL, &PL, fut, "W1", "A", "C", "P1", 2, ox, sizeof(ox)) == 0, "first booking on a future date");
+    Booking bfirst;
+    booking_get(&BL, booking_find_index(&BL, ox), &bfirst);
+    train_release_seat(&TL, "W1", fut, 2, bfirst.seat_index, bfirst.from_stop_idx, bfirst.to_stop_idx);
+    ASSERT(booking_create(&BL, &TL, &PL, fut, "W1", "A", "C", "P1", 2, oy, sizeof(oy)) == 0, "second booking takes the same seat");
+    wal_close();
+    int total = THREADS * PER_THREAD + 1;
+    reset_bookings();
+    ASSERT(wal_replay(WAL, &TL, &PL, &BL) == 2, "both bookings replayed");
+    Booking by;
+    ASSERT(booking_get(&BL, booking_find_index(&BL, oy), &by) == 0 && by.seat_index == -1 && strcmp(by.seat_no, "-") == 0,
+           "conflicting booking replayed without a seat");
+    ASSERT(train_remaining_seats(&TL, "W1", fut, "A", "C", 2) == total - 1, "seat held only once");
+    ASSERT(booking_cancel(&BL, oy, &TL) == 0 && train_remaining_seats(&TL, "W1", fut, "A", "C", 2) == total - 1,
+           "canceling the unseated booking frees nothing");
+    remove(WAL);
+
+#ifndef _WIN32
+    /* 写盘失败后不再追加，之后的提交都报告失败，不会有记录排在写了一半的行后面 */
+    if (wal_open("/dev/full") == 0) {
+        long long lsn = wal_append("P|x");
+        ASSERT(wal_commit(lsn) == -1, "failed write reported");
+        lsn = wal_append("P|y");
+        ASSERT(wal_commit(lsn) == -1 && wal_sync() == -1, "log refuses records after a failed write");
+        char order4[ORDER_ID_LEN];
+        ASSERT(booking_create(&BL, &TL, &PL, "2026-03-04", "W1", "A", "C", "P1", 2, order4, sizeof(order4)) == ERR_NOT_DURABLE &&
+               booking_find_index(&BL, order4) >= 0, "booking applied but reported not durable");
+        ASSERT(booking_cancel(&BL, order4, &TL) == ERR_NOT_DURABLE && passenger_delete(&PL, "P1") == ERR_NOT_DURABLE,
+               "cancel and passenger change reported not durable");
+        wal_close();
+    }
+#endif
+
+    remove(WAL);
+    bookinglist_free(&BL);
+    passengerlist_free(&PL);
+    trainlist_free(&TL);
+    printf("ALL wal tests passed\n");
+    return 0;
+}